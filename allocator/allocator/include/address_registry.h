@@ -0,0 +1,93 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ADDRESS_REGISTRY_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ADDRESS_REGISTRY_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+struct smart_mem_resource;
+
+/** Page map from any address to the resource owning the memory around it, for composite resources that
+ *  free blocks of many arenas. A radix tree of three levels over the granules of a 48 bit address space,
+ *  so owner_of() is three loads whatever the number of arenas. Lookups take no lock, add and remove
+ *  are serialized. Nodes are allocated on first use and live as long as the registry.
+ */
+class address_registry final
+{
+
+public:
+
+    static constexpr const size_t granule_shift = 12;
+
+    // Arena memory is registered in whole granules, two arenas must never share one
+    static constexpr const size_t granule = size_t(1) << granule_shift;
+
+private:
+
+    static constexpr const size_t level_bits = 12;
+
+    static constexpr const size_t level_size = size_t(1) << level_bits;
+
+    static constexpr const size_t address_bits = granule_shift + 3 * level_bits;
+
+    struct leaf
+    {
+        std::array<std::atomic<smart_mem_resource *>, level_size> owners{};
+    };
+
+    struct middle
+    {
+        std::array<std::atomic<leaf *>, level_size> leaves{};
+    };
+
+    std::array<std::atomic<middle *>, level_size> _root{};
+
+    std::mutex _lock;
+
+public:
+
+    address_registry() = default;
+
+    address_registry(
+        address_registry const &other) = delete;
+
+    address_registry &operator=(
+        address_registry const &other) = delete;
+
+    address_registry(
+        address_registry &&other) noexcept = delete;
+
+    address_registry &operator=(
+        address_registry &&other) noexcept = delete;
+
+    ~address_registry() noexcept;
+
+public:
+
+    /** Granules of [at, at + size) go to owner, at has to be granule aligned and the last granule is taken whole.
+     *  Throws std::logic_error for an unaligned or out of range address and for granules of another owner, nothing is added then.
+     */
+    void add(
+        void const *at,
+        size_t size,
+        smart_mem_resource *owner);
+
+    void remove(
+        void const *at,
+        size_t size) noexcept;
+
+    // nullptr for an address no owner was added for
+    smart_mem_resource *owner_of(
+        void const *at) const noexcept;
+
+private:
+
+    // Creates the missing nodes on the way, only called under the lock
+    std::atomic<smart_mem_resource *> &slot(
+        uintptr_t granule_index);
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ADDRESS_REGISTRY_H
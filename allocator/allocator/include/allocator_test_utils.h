@@ -1,7 +1,11 @@
 #ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_TEST_UTILS_H
 #define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_TEST_UTILS_H
 
+#include <array>
+#include <bit>
+#include <chrono>
 #include <cstddef>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -25,6 +29,43 @@ public:
         
     };
 
+    /** Snapshot of the allocator state, sizes are whole block spans including headers.
+     *  Allocators keep these counters in their metadata, so taking a snapshot never walks the blocks.
+     */
+    struct allocator_stats final
+    {
+
+        static constexpr const size_t histogram_size = 32;
+
+        size_t bytes_in_use = 0;
+
+        size_t free_bytes = 0;
+
+        size_t largest_free_block = 0;
+
+        size_t blocks_count = 0;
+
+        size_t free_blocks_count = 0;
+
+        size_t allocations_count = 0;
+
+        size_t deallocations_count = 0;
+
+        // size_histogram[i] counts requests of [2^(i-1), 2^i) bytes, the last bucket also takes all bigger ones
+        std::array<size_t, histogram_size> size_histogram{};
+
+        std::chrono::nanoseconds lock_wait_time{0};
+
+        // 0 while all free memory is one block, tends to 1 as it gets scattered into small pieces
+        double fragmentation() const noexcept;
+
+        void on_allocation(
+            size_t requested_size) noexcept;
+
+        void on_deallocation() noexcept;
+
+    };
+
 public:
     
     virtual ~allocator_test_utils() noexcept = default;
@@ -33,12 +74,20 @@ public:
     //synchronized interface, delegates to _inner version
     virtual std::vector<block_info> get_blocks_info() const = 0;
 
+    //synchronized, default one is derived from get_blocks_info and has no counters
+    virtual allocator_stats get_stats() const;
+
 protected:
 
     //without synchronization, real implementation
     virtual std::vector<block_info> get_blocks_info_inner() const = 0;
 
     std::string print_blocks() const;
+
+    //locks the mutex, the clock is read only when it is contended
+    static std::unique_lock<std::mutex> lock_counting_wait(
+        std::mutex &mutex,
+        allocator_stats &stats);
 };
 
 #endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_TEST_UTILS_H
\ No newline at end of file
@@ -7,17 +7,72 @@
 
 #include <memory_resource>
 #include <memory>
+#include <cstddef>
+#include <cstdint>
 
 struct smart_mem_resource : public std::pmr::memory_resource
 {
+public:
+
+    /** Set by the MP_OS_ALLOCATOR_HARDENED build option. Every block then gets a header and a tail canary,
+     *  both are checked on free and on resize, and freed bytes are overwritten with poison_byte.
+     *  A corrupted canary, a double free or a pointer that isn't a block throws std::logic_error.
+     */
+#ifdef MP_OS_ALLOCATOR_HARDENED
+    static constexpr const bool hardened = true;
+#else
+    static constexpr const bool hardened = false;
+#endif
+
+    static constexpr const unsigned char poison_byte = 0xDD;
+
+    // Bytes a block gets in front of and behind the caller's ones, 0 in builds that aren't hardened
+    static constexpr const size_t hardened_header_size = hardened ? alignof(std::max_align_t) : 0;
+
+    static constexpr const size_t hardened_tail_size = hardened ? sizeof(uint64_t) : 0;
+
+    static constexpr const size_t hardened_overhead = hardened_header_size + hardened_tail_size;
+
+    /** Grows or shrinks the block at p to new_size bytes without moving it, on false the block is left untouched.
+     *  Only blocks allocated with alignment up to default_alignment can be resized.
+     */
+    bool try_resize_in_place(void* p, size_t new_size, size_t alignment = alignof(std::max_align_t));
+
+    /** Fills out with count separate blocks of size bytes, each one may be deallocated on its own.
+     *  Either every block is allocated or std::bad_alloc is thrown and nothing is.
+     */
+    void allocate_batch(size_t size, size_t count, void** out);
+
+    void deallocate_batch(void* const* ptrs, size_t count);
+
 private:
     virtual void do_deallocate_sm(void*) =0;
 
-    void do_deallocate(void* p, size_t, size_t) final;
+    void do_deallocate(void* p, size_t, size_t _Align) final;
 
     virtual void* do_allocate_sm(size_t) =0;
 
     void * do_allocate(size_t _Bytes, size_t _Align) final;
+
+protected:
+
+    // Requests with alignment above this are routed to *_aligned_sm, everything else keeps the plain path
+    static constexpr const size_t default_alignment = alignof(std::max_align_t);
+
+    /** Default: over-allocates through do_allocate_sm and keeps the raw pointer right before the aligned one.
+     *  Allocators that can place the block header at the right spot should override both methods.
+     */
+    virtual void* do_allocate_aligned_sm(size_t size, size_t alignment);
+
+    virtual void do_deallocate_aligned_sm(void* at, size_t alignment);
+
+    // Default: no block can change its size in place
+    virtual bool do_try_resize_in_place_sm(void* at, size_t new_size);
+
+    // Default: one do_allocate_sm / do_deallocate_sm per block, allocators override these to lock and search once
+    virtual void do_allocate_batch_sm(size_t size, size_t count, void** out);
+
+    virtual void do_deallocate_batch_sm(void* const* ptrs, size_t count);
 };
 
 
@@ -57,6 +112,14 @@ public:
     [[nodiscard]] T* allocate(size_t n);
     void deallocate(T* p, size_t n = 1);
 
+    // Resizes the block of n objects at p to new_n objects without moving it, possible only on a smart_mem_resource
+    [[nodiscard]] bool try_resize(T* p, size_t n, size_t new_n);
+
+    // count separate objects at once, for node based containers. Each one may also be freed by deallocate
+    void allocate_batch(size_t count, T** out);
+
+    void deallocate_batch(T* const* ptrs, size_t count);
+
     template<class U, class... Args>
     void construct(U* p, Args&&... args);
 
@@ -186,6 +249,56 @@ void pp_allocator<T>::deallocate(T *p, size_t n)
     _mem->deallocate(p, n * sizeof(T), alignof(T));
 }
 
+template<typename T>
+bool pp_allocator<T>::try_resize(T *p, size_t /* n */, size_t new_n)
+{
+    if ((std::numeric_limits<size_t>::max() / sizeof(T)) < new_n)
+        return false;
+
+    auto smart = dynamic_cast<smart_mem_resource*>(_mem);
+    return smart != nullptr && smart->try_resize_in_place(p, new_n * sizeof(T), alignof(T));
+}
+
+template<typename T>
+void pp_allocator<T>::allocate_batch(size_t count, T **out)
+{
+    auto smart = dynamic_cast<smart_mem_resource*>(_mem);
+    if (smart != nullptr && alignof(T) <= alignof(std::max_align_t))
+    {
+        smart->allocate_batch(sizeof(T), count, reinterpret_cast<void**>(out));
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        try
+        {
+            out[i] = allocate(1);
+        }
+        catch (...)
+        {
+            deallocate_batch(out, i);
+            throw;
+        }
+    }
+}
+
+template<typename T>
+void pp_allocator<T>::deallocate_batch(T *const *ptrs, size_t count)
+{
+    auto smart = dynamic_cast<smart_mem_resource*>(_mem);
+    if (smart != nullptr && alignof(T) <= alignof(std::max_align_t))
+    {
+        smart->deallocate_batch(reinterpret_cast<void* const*>(ptrs), count);
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        deallocate(ptrs[i]);
+    }
+}
+
 template<typename T>
 T *pp_allocator<T>::allocate(size_t n)
 {
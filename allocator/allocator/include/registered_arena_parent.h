@@ -0,0 +1,91 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_REGISTERED_ARENA_PARENT_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_REGISTERED_ARENA_PARENT_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+#include "address_registry.h"
+
+/** Parent of one arena of a composite resource: upstream memory in whole granules, registered in the registry
+ *  for the arena, so a block can be traced back to it. The arena takes its memory while it is being built,
+ *  so those ranges wait until it is claimed. Derived parents prepare every fresh range before it is registered.
+ */
+class registered_arena_parent:
+    public std::pmr::memory_resource
+{
+
+private:
+
+    struct range
+    {
+        void *at;
+        size_t size;
+    };
+
+    std::pmr::memory_resource *_upstream;
+
+    address_registry &_registry;
+
+    size_t _min_alignment;
+
+    smart_mem_resource *_arena;
+
+    std::vector<range> _pending;
+
+public:
+
+    // Upstream ranges are aligned to at least min_alignment, which is never less than a granule
+    registered_arena_parent(
+        std::pmr::memory_resource *upstream,
+        address_registry &registry,
+        size_t min_alignment = address_registry::granule);
+
+    registered_arena_parent(
+        registered_arena_parent const &other) = delete;
+
+    registered_arena_parent &operator=(
+        registered_arena_parent const &other) = delete;
+
+    registered_arena_parent(
+        registered_arena_parent &&other) noexcept = delete;
+
+    registered_arena_parent &operator=(
+        registered_arena_parent &&other) noexcept = delete;
+
+    ~registered_arena_parent() override = default;
+
+public:
+
+    // Registers the ranges taken so far for arena, the ones taken later are registered right away
+    void claim(
+        smart_mem_resource *arena);
+
+protected:
+
+    // Called with every range right after the upstream gave it, nothing to do by default
+    virtual void prepare(
+        void *at,
+        size_t size);
+
+private:
+
+    [[nodiscard]] void *do_allocate(
+        size_t bytes,
+        size_t alignment) override;
+
+    void do_deallocate(
+        void *at,
+        size_t bytes,
+        size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    size_t upstream_alignment(
+        size_t alignment) const noexcept;
+
+    static size_t granules(
+        size_t bytes) noexcept;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_REGISTERED_ARENA_PARENT_H
@@ -0,0 +1,25 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_RESOURCE_WITH_DECOMMIT_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_RESOURCE_WITH_DECOMMIT_H
+
+#include <cstddef>
+
+/** Parent resource that can hand physical pages of a region back to the system while the region stays allocated.
+ *  Allocators call it for ranges that became entirely free, the pages read as zeros once touched again.
+ */
+class resource_with_decommit
+{
+
+public:
+
+    virtual ~resource_with_decommit() noexcept = default;
+
+public:
+
+    // Only pages lying entirely inside [at, at + size) are released
+    virtual void decommit(
+        void *at,
+        size_t size) noexcept = 0;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_RESOURCE_WITH_DECOMMIT_H
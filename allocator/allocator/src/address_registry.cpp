@@ -0,0 +1,110 @@
+#include <stdexcept>
+#include "address_registry.h"
+
+address_registry::~address_registry() noexcept
+{
+    for (auto &node : _root)
+    {
+        middle *current = node.load(std::memory_order_relaxed);
+        if (current == nullptr)
+            continue;
+
+        for (auto &leaf_node : current->leaves)
+        {
+            delete leaf_node.load(std::memory_order_relaxed);
+        }
+
+        delete current;
+    }
+}
+
+void address_registry::add(
+    void const *at,
+    size_t size,
+    smart_mem_resource *owner)
+{
+    auto begin = reinterpret_cast<uintptr_t>(at);
+    uintptr_t count = (size + granule - 1) >> granule_shift;
+
+    if ((begin & (granule - 1)) != 0 || owner == nullptr)
+        throw std::logic_error("[REGISTRY] Range has to start at a granule and have an owner!");
+
+    if (size > (uintptr_t(1) << address_bits) || begin > (uintptr_t(1) << address_bits) - size)
+        throw std::logic_error("[REGISTRY] Range is outside of the address space!");
+
+    uintptr_t first = begin >> granule_shift;
+
+    std::lock_guard lock(_lock);
+
+    // Checked first, so a conflict leaves the registry as it was
+    for (uintptr_t i = first; i < first + count; ++i)
+    {
+        smart_mem_resource *current = owner_of(reinterpret_cast<void const *>(i << granule_shift));
+        if (current != nullptr && current != owner)
+            throw std::logic_error("[REGISTRY] Range overlaps memory of another owner!");
+    }
+
+    for (uintptr_t i = first; i < first + count; ++i)
+    {
+        slot(i).store(owner, std::memory_order_release);
+    }
+}
+
+void address_registry::remove(
+    void const *at,
+    size_t size) noexcept
+{
+    uintptr_t first = reinterpret_cast<uintptr_t>(at) >> granule_shift;
+    uintptr_t count = (size + granule - 1) >> granule_shift;
+
+    std::lock_guard lock(_lock);
+
+    for (uintptr_t i = first; i < first + count && (i >> (3 * level_bits)) == 0; ++i)
+    {
+        middle *middle_node = _root[i >> (2 * level_bits)].load(std::memory_order_relaxed);
+        leaf *leaf_node = middle_node == nullptr ? nullptr : middle_node->leaves[(i >> level_bits) & (level_size - 1)].load(std::memory_order_relaxed);
+
+        if (leaf_node != nullptr)
+            leaf_node->owners[i & (level_size - 1)].store(nullptr, std::memory_order_release);
+    }
+}
+
+smart_mem_resource *address_registry::owner_of(
+    void const *at) const noexcept
+{
+    uintptr_t index = reinterpret_cast<uintptr_t>(at) >> granule_shift;
+    if ((index >> (3 * level_bits)) != 0)
+        return nullptr;
+
+    middle *middle_node = _root[index >> (2 * level_bits)].load(std::memory_order_acquire);
+    if (middle_node == nullptr)
+        return nullptr;
+
+    leaf *leaf_node = middle_node->leaves[(index >> level_bits) & (level_size - 1)].load(std::memory_order_acquire);
+    if (leaf_node == nullptr)
+        return nullptr;
+
+    return leaf_node->owners[index & (level_size - 1)].load(std::memory_order_acquire);
+}
+
+std::atomic<smart_mem_resource *> &address_registry::slot(
+    uintptr_t granule_index)
+{
+    auto &middle_slot = _root[granule_index >> (2 * level_bits)];
+    middle *middle_node = middle_slot.load(std::memory_order_relaxed);
+    if (middle_node == nullptr)
+    {
+        middle_node = new middle();
+        middle_slot.store(middle_node, std::memory_order_release);
+    }
+
+    auto &leaf_slot = middle_node->leaves[(granule_index >> level_bits) & (level_size - 1)];
+    leaf *leaf_node = leaf_slot.load(std::memory_order_relaxed);
+    if (leaf_node == nullptr)
+    {
+        leaf_node = new leaf();
+        leaf_slot.store(leaf_node, std::memory_order_release);
+    }
+
+    return leaf_node->owners[granule_index & (level_size - 1)];
+}
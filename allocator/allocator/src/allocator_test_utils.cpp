@@ -1,4 +1,5 @@
 #include "../include/allocator_test_utils.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -15,6 +16,61 @@ bool allocator_test_utils::block_info::operator!=(
     return !(*this == other);
 }
 
+double allocator_test_utils::allocator_stats::fragmentation() const noexcept
+{
+    return free_bytes == 0 ? 0.0 : 1.0 - static_cast<double>(largest_free_block) / static_cast<double>(free_bytes);
+}
+
+void allocator_test_utils::allocator_stats::on_allocation(
+    size_t requested_size) noexcept
+{
+    ++allocations_count;
+    ++size_histogram[std::min<size_t>(std::bit_width(requested_size), histogram_size - 1)];
+}
+
+void allocator_test_utils::allocator_stats::on_deallocation() noexcept
+{
+    ++deallocations_count;
+}
+
+allocator_test_utils::allocator_stats allocator_test_utils::get_stats() const
+{
+    allocator_stats stats;
+
+    for (auto const &block : get_blocks_info())
+    {
+        ++stats.blocks_count;
+
+        if (block.is_block_occupied)
+        {
+            stats.bytes_in_use += block.block_size;
+            continue;
+        }
+
+        ++stats.free_blocks_count;
+        stats.free_bytes += block.block_size;
+        stats.largest_free_block = std::max(stats.largest_free_block, block.block_size);
+    }
+
+    return stats;
+}
+
+std::unique_lock<std::mutex> allocator_test_utils::lock_counting_wait(
+    std::mutex &mutex,
+    allocator_stats &stats)
+{
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+
+    if (!lock.owns_lock())
+    {
+        auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        stats.lock_wait_time += std::chrono::steady_clock::now() - start;
+    }
+
+    return lock;
+}
+
 std::string allocator_test_utils::print_blocks() const
 {
     auto vec = get_blocks_info_inner();
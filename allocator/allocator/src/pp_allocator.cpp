@@ -3,18 +3,300 @@
 //
 
 #include "pp_allocator.h"
+#include <cstdint>
+#include <limits>
 
+#ifdef MP_OS_ALLOCATOR_HARDENED
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+    /** Block as the allocator sees it: header right before the caller's bytes, tail canary right after them.
+     *  Blocks with bigger alignment get max(alignment, header_size) bytes in front, so the caller's bytes stay aligned.
+     *  The header keeps the alignment, so a block is given back the way it was taken whatever alignment deallocate gets.
+     */
+    struct hardened_header
+    {
+        uint64_t size : 56;
+        uint64_t alignment_log2 : 8;
+        uint64_t canary;
+    };
+
+    constexpr const size_t header_size = smart_mem_resource::hardened_header_size;
+
+    constexpr const size_t tail_size = smart_mem_resource::hardened_tail_size;
+
+    static_assert(sizeof(hardened_header) == header_size);
+
+    // Random per process, so a canary can't be forged from a known address
+    uint64_t canary_for(void const* at)
+    {
+        static const uint64_t key = (uint64_t(std::random_device{}()) << 32) | std::random_device{}();
+        return key ^ reinterpret_cast<uintptr_t>(at);
+    }
+
+    size_t front_size(size_t alignment)
+    {
+        return std::max(alignment, header_size);
+    }
+
+    // Whole span of a block with size bytes for the caller, throws std::bad_alloc when it doesn't fit in size_t
+    size_t armed_size(size_t size, size_t alignment)
+    {
+        if (size > std::numeric_limits<size_t>::max() - front_size(alignment) - tail_size)
+            throw std::bad_alloc();
+
+        return front_size(alignment) + size + tail_size;
+    }
+
+    hardened_header* header_of(void* at)
+    {
+        return reinterpret_cast<hardened_header*>(at) - 1;
+    }
+
+    void* arm(void* raw, size_t size, size_t alignment)
+    {
+        auto at = reinterpret_cast<unsigned char*>(raw) + front_size(alignment);
+        uint64_t canary = canary_for(at);
+
+        header_of(at)->size = size;
+        header_of(at)->alignment_log2 = std::countr_zero(alignment);
+        header_of(at)->canary = canary;
+        memcpy(at + size, &canary, tail_size);
+
+        return at;
+    }
+
+    // Throws for anything but a live block with both canaries intact
+    hardened_header* checked(void* at)
+    {
+        hardened_header* header = header_of(at);
+        uint64_t canary = canary_for(at), tail;
+
+        if (header->canary == ~canary)
+            throw std::logic_error("[HARDENED] Double free!");
+
+        if (header->canary != canary)
+            throw std::logic_error("[HARDENED] Block header is corrupted or the pointer is not a block!");
+
+        memcpy(&tail, reinterpret_cast<unsigned char*>(at) + header->size, tail_size);
+        if (tail != canary)
+            throw std::logic_error("[HARDENED] Block overrun, tail canary is corrupted!");
+
+        return header;
+    }
+
+    size_t alignment_of(hardened_header const* header)
+    {
+        return size_t(1) << header->alignment_log2;
+    }
+
+    // Poisons a checked block and returns the raw block for the allocator
+    void* disarm(void* at)
+    {
+        hardened_header* header = checked(at);
+
+        memset(at, smart_mem_resource::poison_byte, header->size + tail_size);
+        header->canary = ~header->canary;
+
+        return reinterpret_cast<unsigned char*>(at) - front_size(alignment_of(header));
+    }
+}
+
+/** The block is disarmed before the allocator sees it, so a pointer the allocator rejects is armed again
+ *  and stays a live block. Its bytes are already poisoned by then, only the canaries are restored.
+ */
 void smart_mem_resource::do_deallocate(void* p, size_t, size_t)
 {
-    do_deallocate_sm(p);
+    if (p == nullptr)
+        return;
+
+    hardened_header* header = checked(p);
+    size_t size = header->size, alignment = alignment_of(header);
+    void* raw = disarm(p);
+
+    try
+    {
+        if (alignment > default_alignment)
+            do_deallocate_aligned_sm(raw, alignment);
+        else
+            do_deallocate_sm(raw);
+    }
+    catch (...)
+    {
+        arm(raw, size, alignment);
+        throw;
+    }
 }
 
 void * smart_mem_resource::do_allocate(size_t _Bytes, size_t _Align)
 {
+    size_t bytes = armed_size(_Bytes, _Align);
+    void* raw = _Align > default_alignment ? do_allocate_aligned_sm(bytes, _Align) : do_allocate_sm(bytes);
+
+    return raw == nullptr ? nullptr : arm(raw, _Bytes, _Align);
+}
+
+bool smart_mem_resource::try_resize_in_place(void* p, size_t new_size, size_t alignment)
+{
+    if (p == nullptr || alignment > default_alignment || alignment_of(checked(p)) > default_alignment)
+        return false;
+
+    if (new_size > std::numeric_limits<size_t>::max() - header_size - tail_size)
+        return false;
+
+    if (!do_try_resize_in_place_sm(reinterpret_cast<unsigned char*>(p) - header_size, header_size + new_size + tail_size))
+        return false;
+
+    arm(reinterpret_cast<unsigned char*>(p) - header_size, new_size, default_alignment);
+    return true;
+}
+
+void smart_mem_resource::allocate_batch(size_t size, size_t count, void** out)
+{
+    do_allocate_batch_sm(armed_size(size, default_alignment), count, out);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        out[i] = arm(out[i], size, default_alignment);
+    }
+}
+
+/** Allocators may free a part of a batch before they reject a block, so after a throw there is no telling
+ *  which blocks are still theirs to arm again. Each block goes to the allocator on its own instead.
+ */
+void smart_mem_resource::deallocate_batch(void* const* ptrs, size_t count)
+{
+    // Nothing is freed when any of the blocks is bad, blocks of the batch are never aligned above the default
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (ptrs[i] != nullptr && alignment_of(checked(ptrs[i])) > default_alignment)
+            throw std::logic_error("[HARDENED] Aligned block in a batch!");
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (ptrs[i] == nullptr)
+            continue;
+
+        size_t size = header_of(ptrs[i])->size;
+        void* raw = disarm(ptrs[i]);
+
+        try
+        {
+            do_deallocate_batch_sm(&raw, 1);
+        }
+        catch (...)
+        {
+            arm(raw, size, default_alignment);
+            throw;
+        }
+    }
+}
+
+#else
+
+void smart_mem_resource::do_deallocate(void* p, size_t, size_t _Align)
+{
+    if (_Align > default_alignment)
+        do_deallocate_aligned_sm(p, _Align);
+    else
+        do_deallocate_sm(p);
+}
+
+void * smart_mem_resource::do_allocate(size_t _Bytes, size_t _Align)
+{
+    if (_Align > default_alignment)
+        return do_allocate_aligned_sm(_Bytes, _Align);
+
     return do_allocate_sm(_Bytes);
 }
 
+bool smart_mem_resource::try_resize_in_place(void* p, size_t new_size, size_t alignment)
+{
+    // Aligned blocks may sit behind a prefix the allocator knows nothing about
+    if (p == nullptr || alignment > default_alignment)
+        return false;
+
+    return do_try_resize_in_place_sm(p, new_size);
+}
+
+void smart_mem_resource::allocate_batch(size_t size, size_t count, void** out)
+{
+    do_allocate_batch_sm(size, count, out);
+}
+
+void smart_mem_resource::deallocate_batch(void* const* ptrs, size_t count)
+{
+    do_deallocate_batch_sm(ptrs, count);
+}
+
+#endif
+
+void* smart_mem_resource::do_allocate_aligned_sm(size_t size, size_t alignment)
+{
+    if ((alignment & (alignment - 1)) != 0 || size > std::numeric_limits<size_t>::max() - alignment - sizeof(void*))
+        throw std::bad_alloc();
+
+    auto raw = reinterpret_cast<uintptr_t>(do_allocate_sm(size + alignment + sizeof(void*)));
+    if (raw == 0)
+        return nullptr;
+
+    uintptr_t aligned = (raw + sizeof(void*) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    reinterpret_cast<void**>(aligned)[-1] = reinterpret_cast<void*>(raw);
+
+    return reinterpret_cast<void*>(aligned);
+}
+
+void smart_mem_resource::do_deallocate_aligned_sm(void* at, size_t)
+{
+    if (at == nullptr)
+        return;
+
+    do_deallocate_sm(reinterpret_cast<void**>(at)[-1]);
+}
+
+bool smart_mem_resource::do_try_resize_in_place_sm(void*, size_t)
+{
+    return false;
+}
+
+// Some allocators report failure with nullptr instead of std::bad_alloc, both roll the batch back
+void smart_mem_resource::do_allocate_batch_sm(size_t size, size_t count, void** out)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        try
+        {
+            out[i] = do_allocate_sm(size);
+        }
+        catch (...)
+        {
+            do_deallocate_batch_sm(out, i);
+            throw;
+        }
+
+        if (out[i] == nullptr)
+        {
+            do_deallocate_batch_sm(out, i);
+            throw std::bad_alloc();
+        }
+    }
+}
+
+void smart_mem_resource::do_deallocate_batch_sm(void* const* ptrs, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        do_deallocate_sm(ptrs[i]);
+    }
+}
+
 void* test_mem_resource::do_allocate_sm(size_t n)
 {
 return ::operator new(n);
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <stdexcept>
+#include "registered_arena_parent.h"
+
+registered_arena_parent::registered_arena_parent(
+    std::pmr::memory_resource *upstream,
+    address_registry &registry,
+    size_t min_alignment) :
+        _upstream(upstream),
+        _registry(registry),
+        _min_alignment(std::max(min_alignment, address_registry::granule)),
+        _arena(nullptr)
+{
+}
+
+void registered_arena_parent::claim(
+    smart_mem_resource *arena)
+{
+    _arena = arena;
+
+    for (auto const &[at, size] : _pending)
+    {
+        _registry.add(at, size, arena);
+    }
+
+    _pending.clear();
+}
+
+void registered_arena_parent::prepare(
+    void * /* at */,
+    size_t /* size */)
+{
+}
+
+[[nodiscard]] void *registered_arena_parent::do_allocate(
+    size_t bytes,
+    size_t alignment)
+{
+    size_t size = granules(bytes);
+    void *at = _upstream->allocate(size, upstream_alignment(alignment));
+
+    try
+    {
+        prepare(at, size);
+
+        if (_arena == nullptr)
+            _pending.push_back({ at, size });
+        else
+            _registry.add(at, size, _arena);
+    }
+    catch (...)
+    {
+        _upstream->deallocate(at, size, upstream_alignment(alignment));
+        throw;
+    }
+
+    return at;
+}
+
+void registered_arena_parent::do_deallocate(
+    void *at,
+    size_t bytes,
+    size_t alignment)
+{
+    size_t size = granules(bytes);
+
+    _registry.remove(at, size);
+    _upstream->deallocate(at, size, upstream_alignment(alignment));
+}
+
+bool registered_arena_parent::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+size_t registered_arena_parent::upstream_alignment(
+    size_t alignment) const noexcept
+{
+    return std::max(alignment, _min_alignment);
+}
+
+size_t registered_arena_parent::granules(
+    size_t bytes) noexcept
+{
+    return (std::max<size_t>(bytes, 1) + address_registry::granule - 1) & ~(address_registry::granule - 1);
+}
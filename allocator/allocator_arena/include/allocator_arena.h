@@ -0,0 +1,112 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_ARENA_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_ARENA_H
+
+#include <pp_allocator.h>
+#include <allocator_test_utils.h>
+#include <logger_guardant.h>
+#include <typename_holder.h>
+#include <mutex>
+#include <utility>
+
+/** Monotonic arena: memory is bumped out of chunks taken from the parent resource, deallocate is a no-op.
+ *  Chunks grow geometrically, so release() returns everything in a number of steps
+ *  logarithmic in the total size and independent of how many allocations were made.
+ */
+class allocator_arena final:
+    public smart_mem_resource,
+    public allocator_test_utils,
+    private logger_guardant,
+    private typename_holder
+{
+
+private:
+
+    static constexpr const size_t min_chunk_size = 256;
+
+    static constexpr const size_t growth_factor = 2;
+
+    struct alignas(std::max_align_t) chunk_header
+    {
+        chunk_header *next;
+        size_t size;
+        size_t used; // filled in once the chunk stops being the current one
+    };
+
+    struct arena_metadata
+    {
+        logger *loggerObj;
+        std::pmr::memory_resource *allocatorObj;
+        size_t initialChunkSize;
+        size_t nextChunkSize;
+        std::mutex globalLock;
+        chunk_header *chunks;
+        char *current;
+        char *end;
+    };
+
+    static constexpr const size_t chunk_header_size = sizeof(chunk_header);
+
+    void *_trusted_memory;
+
+public:
+
+    explicit allocator_arena(
+        size_t initial_chunk_size = 4096,
+        std::pmr::memory_resource *parent_allocator = nullptr,
+        logger *logger = nullptr);
+
+    allocator_arena(
+        allocator_arena const &other) = delete;
+
+    allocator_arena &operator=(
+        allocator_arena const &other) = delete;
+
+    allocator_arena(
+        allocator_arena &&other) noexcept;
+
+    allocator_arena &operator=(
+        allocator_arena &&other) noexcept;
+
+    ~allocator_arena() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_aligned_sm(
+        void *at,
+        size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info() const override;
+
+    // Returns every chunk to the parent resource, all pointers handed out before become invalid
+    void release();
+
+private:
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
+
+    void *bump(size_t size, size_t alignment);
+
+    void add_chunk(size_t min_size);
+
+    void release_inner() noexcept;
+
+    std::mutex &mutex() const noexcept;
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_ARENA_H
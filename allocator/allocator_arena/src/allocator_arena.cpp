@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <limits>
+#include "../include/allocator_arena.h"
+
+allocator_arena::allocator_arena(
+    size_t initial_chunk_size,
+    std::pmr::memory_resource *parent_allocator,
+    logger *logger)
+{
+    if (parent_allocator == nullptr)
+        parent_allocator = std::pmr::get_default_resource();
+
+    _trusted_memory = parent_allocator->allocate(sizeof(arena_metadata), alignof(arena_metadata));
+
+    auto data = new (_trusted_memory) arena_metadata();
+    data->loggerObj = logger;
+    data->allocatorObj = parent_allocator;
+    data->initialChunkSize = std::max(initial_chunk_size, min_chunk_size);
+    data->nextChunkSize = data->initialChunkSize;
+    data->chunks = nullptr;
+    data->current = nullptr;
+    data->end = nullptr;
+}
+
+allocator_arena::allocator_arena(
+    allocator_arena &&other) noexcept : _trusted_memory(std::exchange(other._trusted_memory, nullptr))
+{
+}
+
+allocator_arena &allocator_arena::operator=(
+    allocator_arena &&other) noexcept
+{
+    if (this != &other)
+        std::swap(_trusted_memory, other._trusted_memory);
+
+    return *this;
+}
+
+allocator_arena::~allocator_arena()
+{
+    if (_trusted_memory == nullptr)
+        return;
+
+    release_inner();
+
+    auto data = reinterpret_cast<arena_metadata *>(_trusted_memory);
+    std::pmr::memory_resource *parent = data->allocatorObj;
+    data->~arena_metadata();
+    parent->deallocate(_trusted_memory, sizeof(arena_metadata), alignof(arena_metadata));
+}
+
+[[nodiscard]] void *allocator_arena::do_allocate_sm(
+    size_t size)
+{
+    std::lock_guard lock(mutex());
+
+    return bump(size, default_alignment);
+}
+
+void allocator_arena::do_deallocate_sm(
+    void * /* at */)
+{
+    // Memory is only given back by release() or destruction
+}
+
+[[nodiscard]] void *allocator_arena::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    if ((alignment & (alignment - 1)) != 0)
+        throw std::bad_alloc();
+
+    std::lock_guard lock(mutex());
+
+    return bump(size, alignment);
+}
+
+void allocator_arena::do_deallocate_aligned_sm(
+    void * /* at */,
+    size_t /* alignment */)
+{
+}
+
+bool allocator_arena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+void allocator_arena::release()
+{
+    std::lock_guard lock(mutex());
+
+    debug_with_guard("[ARENA] Releasing all chunks");
+
+    release_inner();
+}
+
+std::vector<allocator_test_utils::block_info> allocator_arena::get_blocks_info() const
+{
+    std::lock_guard lock(mutex());
+
+    return get_blocks_info_inner();
+}
+
+std::vector<allocator_test_utils::block_info> allocator_arena::get_blocks_info_inner() const
+{
+    auto data = reinterpret_cast<arena_metadata *>(_trusted_memory);
+    std::vector<allocator_test_utils::block_info> res;
+
+    // Each chunk is reported as its used prefix and the unused tail, oldest chunk first
+    for (chunk_header *chunk = data->chunks; chunk != nullptr; chunk = chunk->next)
+    {
+        size_t capacity = chunk->size - chunk_header_size;
+        size_t used = chunk == data->chunks
+            ? data->current - (reinterpret_cast<char *>(chunk) + chunk_header_size)
+            : chunk->used;
+
+        if (capacity - used != 0)
+            res.push_back({ .block_size = capacity - used, .is_block_occupied = false });
+        if (used != 0)
+            res.push_back({ .block_size = used, .is_block_occupied = true });
+    }
+
+    std::reverse(res.begin(), res.end());
+
+    return res;
+}
+
+void *allocator_arena::bump(
+    size_t size,
+    size_t alignment)
+{
+    auto data = reinterpret_cast<arena_metadata *>(_trusted_memory);
+
+    auto aligned = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(data->current) + alignment - 1) & ~(uintptr_t(alignment) - 1));
+
+    if (data->current == nullptr || aligned > data->end || size > static_cast<size_t>(data->end - aligned))
+    {
+        if (size > std::numeric_limits<size_t>::max() - alignment)
+        {
+            error_with_guard([&] { return "[ARENA] Unable to allocate " + std::to_string(size) + " bytes"; });
+            throw std::bad_alloc();
+        }
+
+        add_chunk(size + (alignment > default_alignment ? alignment : 0));
+        aligned = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(data->current) + alignment - 1) & ~(uintptr_t(alignment) - 1));
+    }
+
+    data->current = aligned + size;
+
+    return aligned;
+}
+
+void allocator_arena::add_chunk(
+    size_t min_size)
+{
+    auto data = reinterpret_cast<arena_metadata *>(_trusted_memory);
+
+    if (min_size > std::numeric_limits<size_t>::max() - chunk_header_size)
+    {
+        error_with_guard([&] { return "[ARENA] Unable to provide a chunk for " + std::to_string(min_size) + " bytes"; });
+        throw std::bad_alloc();
+    }
+
+    size_t chunk_size = std::max(data->nextChunkSize, chunk_header_size + min_size);
+
+    debug_with_guard([&] { return "[ARENA] Requesting chunk of " + std::to_string(chunk_size) + " bytes"; });
+
+    void *memory;
+    try
+    {
+        memory = data->allocatorObj->allocate(chunk_size, alignof(chunk_header));
+    }
+    catch (std::bad_alloc const &)
+    {
+        memory = nullptr;
+    }
+
+    if (memory == nullptr)
+    {
+        error_with_guard([&] { return "[ARENA] Parent allocator is unable to provide " + std::to_string(chunk_size) + " bytes"; });
+        throw std::bad_alloc();
+    }
+
+    if (data->chunks != nullptr)
+        data->chunks->used = data->current - (reinterpret_cast<char *>(data->chunks) + chunk_header_size);
+
+    auto chunk = new (memory) chunk_header();
+    chunk->next = data->chunks;
+    chunk->size = chunk_size;
+    data->chunks = chunk;
+
+    data->current = reinterpret_cast<char *>(chunk) + chunk_header_size;
+    data->end = reinterpret_cast<char *>(chunk) + chunk_size;
+    data->nextChunkSize = chunk_size <= std::numeric_limits<size_t>::max() / growth_factor ? chunk_size * growth_factor : chunk_size;
+}
+
+void allocator_arena::release_inner() noexcept
+{
+    auto data = reinterpret_cast<arena_metadata *>(_trusted_memory);
+
+    while (data->chunks != nullptr)
+    {
+        chunk_header *chunk = data->chunks;
+        data->chunks = chunk->next;
+        data->allocatorObj->deallocate(chunk, chunk->size, alignof(chunk_header));
+    }
+
+    data->current = data->end = nullptr;
+    data->nextChunkSize = data->initialChunkSize;
+}
+
+std::mutex &allocator_arena::mutex() const noexcept
+{
+    return reinterpret_cast<arena_metadata *>(_trusted_memory)->globalLock;
+}
+
+inline logger *allocator_arena::get_logger() const
+{
+    return reinterpret_cast<arena_metadata *>(_trusted_memory)->loggerObj;
+}
+
+inline std::string allocator_arena::get_typename() const
+{
+    return "allocator_arena";
+}
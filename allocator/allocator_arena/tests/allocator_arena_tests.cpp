@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <allocator_arena.h>
+#include <allocator_global_heap.h>
+#include <AVL_tree.h>
+#include <client_logger_builder.h>
+#include <cstring>
+#include <limits>
+
+logger *create_logger(
+    std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
+    bool use_console_stream = true,
+    logger::severity console_stream_severity = logger::severity::debug)
+{
+    std::unique_ptr<logger_builder> logger_builder_instance(new client_logger_builder);
+
+    if (use_console_stream)
+    {
+        logger_builder_instance->add_console_stream(console_stream_severity);
+    }
+
+    for (auto &output_file_stream_setup: output_file_streams_setup)
+    {
+        logger_builder_instance->add_file_stream(output_file_stream_setup.first, output_file_stream_setup.second);
+    }
+
+    logger *logger_instance = logger_builder_instance->build();
+
+    return logger_instance;
+}
+
+TEST(allocatorArenaPositiveTests, test1)
+{
+    std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
+        {
+            {
+                "allocator_arena_tests_positive_test1.txt",
+                logger::severity::debug
+            }
+        }, false));
+
+    allocator_arena subject(1024, nullptr, logger_instance.get());
+
+    auto first_block = reinterpret_cast<int *>(subject.allocate(sizeof(int) * 10));
+    auto second_block = reinterpret_cast<int *>(subject.allocate(sizeof(int) * 10));
+
+    ASSERT_NE(first_block, second_block);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(first_block) % alignof(std::max_align_t), 0);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(second_block) % alignof(std::max_align_t), 0);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        first_block[i] = i;
+        second_block[i] = -i;
+    }
+
+    // Deallocation does not give memory back, both blocks stay intact
+    subject.deallocate(first_block, 1);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(second_block[i], -i);
+    }
+
+    auto third_block = reinterpret_cast<int *>(subject.allocate(sizeof(int) * 10));
+    ASSERT_NE(first_block, third_block);
+
+    auto blocks = subject.get_blocks_info();
+    ASSERT_EQ(blocks.size(), 2);
+    ASSERT_TRUE(blocks[0].is_block_occupied);
+    // Every block but the last one is padded to alignof(std::max_align_t)
+    size_t block_size = sizeof(int) * 10 + smart_mem_resource::hardened_overhead;
+    ASSERT_EQ(blocks[0].block_size, 2 * ((block_size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1)) + block_size);
+    ASSERT_FALSE(blocks[1].is_block_occupied);
+}
+
+TEST(allocatorArenaPositiveTests, test2)
+{
+    allocator_arena subject(256);
+
+    // Requests larger than the next chunk get a chunk of their own size
+    auto large_block = reinterpret_cast<char *>(subject.allocate(10000));
+    memset(large_block, 'a', 10000);
+
+    for (size_t alignment : { 32, 64, 128, 4096 })
+    {
+        auto block = subject.allocate(100, alignment);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % alignment, 0);
+        memset(block, 'b', 100);
+    }
+
+    ASSERT_EQ(large_block[9999], 'a');
+
+    subject.release();
+    ASSERT_TRUE(subject.get_blocks_info().empty());
+
+    // Arena is usable again after release
+    auto block = subject.allocate(64);
+    ASSERT_NE(block, nullptr);
+    ASSERT_EQ(subject.get_blocks_info()[0].block_size, 64 + smart_mem_resource::hardened_overhead);
+}
+
+TEST(allocatorArenaPositiveTests, test3)
+{
+    allocator_arena subject;
+
+    {
+        AVL_tree<int, std::string> tree{ pp_allocator<typename AVL_tree<int, std::string>::value_type>(&subject) };
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            tree.insert(std::make_pair(i, std::to_string(i)));
+        }
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            ASSERT_EQ(tree.at(i), std::to_string(i));
+        }
+    }
+
+    subject.release();
+}
+
+TEST(allocatorArenaNegativeTests, test1)
+{
+    allocator_arena subject;
+
+    // Neither the aligned size nor the chunk holding it may wrap around
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max() - 8)), std::bad_alloc);
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max() - 20)), std::bad_alloc);
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max() - 32, 64)), std::bad_alloc);
+
+    ASSERT_NE(subject.allocate(16), nullptr);
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
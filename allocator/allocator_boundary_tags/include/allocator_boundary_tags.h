@@ -6,24 +6,43 @@
 #include <pp_allocator.h>
 #include <logger_guardant.h>
 #include <typename_holder.h>
+#include <resource_with_decommit.h>
+#include <climits>
+#include <cstddef>
 #include <iterator>
+#include <limits>
 #include <mutex>
 
+/** Size is the whole span of the block including this header, so the physically next block is at block + size.
+ *  While the block is free the last two words link it into its size bin, once allocated they hold the owner.
+ */
 struct alignas(size_t) block_metadata {
 	size_t size : 63;
 	bool allocated : 1;
-	block_metadata* next;
 	block_metadata* prev;
-	struct allocator_metadata* parent;
+	block_metadata* nextFree;
+	union {
+		block_metadata* prevFree;
+		struct allocator_metadata* parent;
+	};
 } __attribute__( (__packed__) );
 
-struct alignas(size_t) allocator_metadata {
+// Free blocks of size [2^i, 2^(i+1)) live in freeBins[i], bit i of nonEmptyBins is set while that list is not empty
+static constexpr const size_t boundaryTagsBinsCount = CHAR_BIT * sizeof(size_t);
+
+struct alignas(std::max_align_t) allocator_metadata {
 	logger* loggerObj;
 	std::pmr::memory_resource* allocatorObj;
 	allocator_with_fit_mode::fit_mode fitMode;
 	size_t memSize;
 	std::mutex globalLock;
 	struct block_metadata* firstBlock;
+	size_t nonEmptyBins;
+	struct block_metadata* freeBins[boundaryTagsBinsCount];
+	// Parent able to take pages of free blocks back, nullptr for any other parent
+	resource_with_decommit* pageSource;
+	// Free block counters follow insertFree/removeFree, the total one follows splits and merges
+	allocator_test_utils::allocator_stats stats;
 };
 
 
@@ -44,6 +63,17 @@ private:
 
     static constexpr const size_t freeMetadataSize = 0;
 
+    // Block sizes are multiples of it, so headers and the payloads right behind them stay max_align_t-aligned
+    static constexpr const size_t blockAlignment = alignof(std::max_align_t);
+
+    static_assert( metadataSize % blockAlignment == 0 && allocatedMetadataSize % blockAlignment == 0 );
+
+    // Largest size whose block, header and padding included, still fits in size_t
+    static constexpr const size_t maxRequestSize = std::numeric_limits<size_t>::max() - allocatedMetadataSize - (blockAlignment - 1);
+
+    // Free blocks of at least 64 KiB give their pages back to a pageSource
+    static constexpr const size_t decommitSize = size_t(1) << 16;
+
     void* _allocatorMemory;
 
 public:
@@ -70,13 +100,40 @@ void splitBlockAndInit( struct block_metadata* block, size_t size );
 
 void mergeBlocks( struct block_metadata* a, struct block_metadata* b );
 
+struct block_metadata* physicalNext( struct block_metadata* block ) const;
+
+static size_t binIndex( size_t size );
+
+void insertFree( struct block_metadata* block );
+
+void removeFree( struct block_metadata* block );
+
+void* takeBlock( struct block_metadata* block, size_t size );
+
 [[nodiscard]] void* allocate( size_t size );
+[[nodiscard]] void* allocateAligned( size_t size, size_t alignment );
 [[nodiscard]] void* do_allocate_sm( size_t size );
 void do_deallocate_sm( void* ptr );
+[[nodiscard]] void* do_allocate_aligned_sm( size_t size, size_t alignment ) override;
+void do_deallocate_aligned_sm( void* ptr, size_t alignment ) override;
+bool do_try_resize_in_place_sm( void* ptr, size_t size ) override;
+void do_allocate_batch_sm( size_t size, size_t count, void** out ) override;
+void do_deallocate_batch_sm( void* const* ptrs, size_t count ) override;
 bool do_is_equal(const std::pmr::memory_resource& other) const noexcept;
 	
 void deallocate( void* ptr );
 
+// Caller holds globalLock
+void deallocateUnlocked( void* ptr );
+
+void allocateBatch( size_t size, size_t count, void** out );
+
+void deallocateBatch( void* const* ptrs, size_t count );
+
+bool resizeInPlace( void* ptr, size_t size );
+
+struct block_metadata* findFreeBlock( size_t size );
+
 struct block_metadata* firstfit( size_t size );
 
 struct block_metadata* bestfit( size_t size );
@@ -91,6 +148,7 @@ inline void set_fit_mode( allocator_with_fit_mode::fit_mode mode );
 inline std::string get_typename() const noexcept;
 std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const;
 std::vector<allocator_test_utils::block_info> get_blocks_info() const;
+allocator_test_utils::allocator_stats get_stats() const override;
 
 allocator_with_fit_mode::fit_mode fitMode() const;
 
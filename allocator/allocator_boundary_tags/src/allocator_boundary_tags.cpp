@@ -1,18 +1,29 @@
 //#include <not_implemented.h>
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <utility>
 #include "../include/allocator_boundary_tags.h"
 
 allocator_boundary_tags::~allocator_boundary_tags() {
-	std::lock_guard lock(mutex());
-	size_t totalSize = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->memSize;
-	if( reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->allocatorObj ) {
-		reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->allocatorObj->deallocate( reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory), totalSize );
+	if( !this->_allocatorMemory ) return;
+
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	std::pmr::memory_resource* parentAllocator = data->allocatorObj;
+	size_t totalSize = data->memSize + allocator_boundary_tags::metadataSize;
+
+	// Mutex lives inside the memory being released, so it can't be held here
+	data->~allocator_metadata();
+
+	if( parentAllocator ) {
+		parentAllocator->deallocate( this->_allocatorMemory, totalSize );
 	}else{
-		::operator delete( reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory) );
+		::operator delete( this->_allocatorMemory );
 	}
 }
 
 allocator_boundary_tags::allocator_boundary_tags( allocator_boundary_tags &&other ) noexcept {
-    this->_allocatorMemory = other._allocatorMemory;
+    this->_allocatorMemory = std::exchange( other._allocatorMemory, nullptr );
 }
 
 inline void* recomputeWithOffset( void* a, size_t offset ) {
@@ -29,166 +40,416 @@ allocator_boundary_tags::allocator_boundary_tags(
         std::pmr::memory_resource *allocator,
         logger *loggerObj,
         allocator_with_fit_mode::fit_mode fitMode ){
-    
+
 	size_t totalSize = memSize + allocator_boundary_tags::metadataSize;
-	if( memSize < allocator_boundary_tags::metadataSize ) throw std::logic_error( "Not enough space" );
-	
+	if( memSize < allocator_boundary_tags::allocatedMetadataSize ) throw std::logic_error( "Not enough space" );
+
 	void* allocatedMemory = (!allocator) ? ::operator new(totalSize) : allocator->allocate( totalSize );
 	if( !allocatedMemory ) {
 		error_with_guard("[BOUNDARY_TAGS] Unable to init allocator!");
 		return;
 	}
-	
+
 	this->_allocatorMemory = new(allocatedMemory) allocator_metadata();
-	
-	reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->loggerObj = loggerObj;
-	reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->allocatorObj = allocator;
-	reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->memSize = memSize;
-	reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->fitMode = fitMode;
-	
-	reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->firstBlock = reinterpret_cast<struct block_metadata*>(recomputeWithOffset(allocatedMemory, allocator_boundary_tags::metadataSize));
-	
-	reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->firstBlock->size = memSize - sizeof( struct block_metadata );
-	reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->firstBlock->next = nullptr;
-	reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->firstBlock->prev = nullptr;
+
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	data->loggerObj = loggerObj;
+	data->allocatorObj = allocator;
+	data->memSize = memSize;
+	data->fitMode = fitMode;
+	data->pageSource = dynamic_cast<resource_with_decommit*>(allocator);
+
+	data->firstBlock = reinterpret_cast<struct block_metadata*>(recomputeWithOffset(allocatedMemory, allocator_boundary_tags::metadataSize));
+	new (data->firstBlock) block_metadata();
+	this->initBlockMetadata( data->firstBlock, nullptr, memSize );
+	data->stats.blocks_count = 1;
+	this->insertFree( data->firstBlock );
 }
 
 inline bool allocator_boundary_tags::canMergePrev( struct block_metadata* block) {
-	if( !block || !block->prev || block->prev->allocated ) return false;
-	return recomputeWithOffset(reinterpret_cast<void*>(block->prev), block->prev->size) == reinterpret_cast<void*>(block);
+	return block && block->prev && !block->prev->allocated;
 }
 
 inline bool allocator_boundary_tags::canMergeNext( struct block_metadata* block) {
-	if( !block || !block->next || block->next->allocated ) return false;
-	return recomputeWithOffset(reinterpret_cast<void*>(block), block->size) == reinterpret_cast<void*>(block->next);
+	struct block_metadata* next = this->physicalNext( block );
+	return next && !next->allocated;
+}
+
+struct block_metadata* allocator_boundary_tags::physicalNext( struct block_metadata* block ) const {
+	if( !block ) return nullptr;
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	void* next = recomputeWithOffset( block, block->size );
+	return next < recomputeWithOffset( data->firstBlock, data->memSize ) ? reinterpret_cast<struct block_metadata*>(next) : nullptr;
+}
+
+size_t allocator_boundary_tags::binIndex( size_t size ) {
+	return std::bit_width( size ) - 1;
+}
+
+void allocator_boundary_tags::insertFree( struct block_metadata* block ) {
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	size_t bin = binIndex( block->size );
+
+	block->allocated = false;
+	block->prevFree = nullptr;
+	block->nextFree = data->freeBins[bin];
+	if( block->nextFree ) block->nextFree->prevFree = block;
+	data->freeBins[bin] = block;
+	data->nonEmptyBins |= size_t(1) << bin;
+
+	++data->stats.free_blocks_count;
+	data->stats.free_bytes += block->size;
+}
+
+void allocator_boundary_tags::removeFree( struct block_metadata* block ) {
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	size_t bin = binIndex( block->size );
+
+	if( block->prevFree ) {
+		block->prevFree->nextFree = block->nextFree;
+	}else{
+		data->freeBins[bin] = block->nextFree;
+		if( !data->freeBins[bin] ) data->nonEmptyBins &= ~(size_t(1) << bin);
+	}
+	if( block->nextFree ) block->nextFree->prevFree = block->prevFree;
+
+	--data->stats.free_blocks_count;
+	data->stats.free_bytes -= block->size;
 }
 
 void allocator_boundary_tags::initBlockMetadata( struct block_metadata* block, struct block_metadata* prev, size_t size ) {
 	if( !block ) return;
-	block->parent = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
 	block->size = size;
-	
-	if( !prev ) return; // Init run, no block here yet.
+	block->allocated = false;
 	block->prev = prev;
-	
-	if( prev->next ) block->next = prev->next;
-	prev->next = block;
+
+	struct block_metadata* next = this->physicalNext( block );
+	if( next ) next->prev = block;
 }
 
+// Block must already be out of its bin, the tail becomes a new free block
 void allocator_boundary_tags::splitBlockAndInit( struct block_metadata* block, size_t size ) {
 	if( !block || block->size <= size ) return;
-	
+
 	size_t nextSize = block->size - size;
 	block->size = size;
-	
+
 	void* voidMem = recomputeWithOffset(reinterpret_cast<void*>(block), size);
-	
+
 	new (voidMem) block_metadata();
 	this->initBlockMetadata(reinterpret_cast<struct block_metadata*>(voidMem), block, nextSize );
-	warning_with_guard("[BOUNDARY_TAGS] Split block at addr." + std::to_string(reinterpret_cast<size_t>(block)));
+	++reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->stats.blocks_count;
+	this->insertFree( reinterpret_cast<struct block_metadata*>(voidMem) );
+	debug_with_guard([&] { return "[BOUNDARY_TAGS] Split block at addr." + std::to_string(reinterpret_cast<size_t>(block)); });
 }
 
+// Both blocks must already be out of their bins
 void allocator_boundary_tags::mergeBlocks( struct block_metadata* a, struct block_metadata* b ) {
 	if( !a || !b ) return;
 	struct block_metadata* acceptor = a;
 	struct block_metadata* donnor = b;
 	if( a > b ) std::swap(acceptor, donnor);
-	
-	acceptor->next = donnor->next;
-	if( acceptor->next ) acceptor->next->prev = acceptor;
-	
-	debug_with_guard("[BOUNDARY_TAGS] Merged block" + std::to_string(reinterpret_cast<size_t>(acceptor)) + "(acceptor) with " + std::to_string(reinterpret_cast<size_t>(donnor)) + "(donnor)");
+
+	acceptor->size = acceptor->size + donnor->size;
+	struct block_metadata* next = this->physicalNext( acceptor );
+	if( next ) next->prev = acceptor;
+	--reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->stats.blocks_count;
+
+	debug_with_guard([&] { return "[BOUNDARY_TAGS] Merged block" + std::to_string(reinterpret_cast<size_t>(acceptor)) + "(acceptor) with " + std::to_string(reinterpret_cast<size_t>(donnor)) + "(donnor)"; });
+}
+
+void* allocator_boundary_tags::takeBlock( struct block_metadata* block, size_t size ) {
+	if( block->size > size + allocator_boundary_tags::allocatedMetadataSize ) {
+		this->splitBlockAndInit( block, size );
+	}
+
+	block->allocated = true;
+	block->parent = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	return recomputeWithOffset( block, allocator_boundary_tags::allocatedMetadataSize );
 }
 
 [[nodiscard]] void* allocator_boundary_tags::allocate( size_t size ) {
 	// if( size == 0 ) return nullptr;
-	std::lock_guard<std::mutex> lock(this->mutex());
-	debug_with_guard("[BOUNDARY_TAGS] Initiated allocation of " + std::to_string(size) + " bytes boundary tags");
-	
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+	debug_with_guard([&] { return "[BOUNDARY_TAGS] Initiated allocation of " + std::to_string(size) + " bytes boundary tags"; });
+
+	size_t minBlockSize = this->realBlockSize( size );
+
+	struct block_metadata* freeBlock = this->findFreeBlock( minBlockSize );
+
+	if( !freeBlock ) {
+		error_with_guard([&] { return "[BOUNDARY_TAGS] Unable to allocate" + std::to_string(minBlockSize) + " bytes"; });
+		throw std::bad_alloc();
+	}
+
+	debug_with_guard([&] { return "[BOUNDARY_TAGS] Found block of size" + std::to_string(freeBlock->size) + " bytes"; });
+
+	data->stats.on_allocation( size );
+	this->removeFree( freeBlock );
+	return this->takeBlock( freeBlock, minBlockSize );
+}
+
+/** Header has to end exactly at an aligned address, so the block is searched with room for the worst padding
+ *  and the gap in front of the header is split off as a separate free block.
+ */
+[[nodiscard]] void* allocator_boundary_tags::allocateAligned( size_t size, size_t alignment ) {
+	if( alignment & (alignment - 1) ) throw std::bad_alloc();
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+	debug_with_guard([&] { return "[BOUNDARY_TAGS] Initiated allocation of " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+
 	size_t minBlockSize = this->realBlockSize( size );
-	
-	struct block_metadata* freeBlock;
-    switch( this->fitMode() ) {
-        case allocator_with_fit_mode::fit_mode::first_fit:
-            freeBlock = this->firstfit( minBlockSize );
-        break;
-        case allocator_with_fit_mode::fit_mode::the_best_fit:
-            freeBlock = this->bestfit( minBlockSize );
-        break;
-        case allocator_with_fit_mode::fit_mode::the_worst_fit:
-            freeBlock = this->worstfit( minBlockSize );
-        break;
-    }
-	
-	debug_with_guard("[BOUNDARY_TAGS] Allocated" + std::to_string(reinterpret_cast<size_t>(freeBlock)));
+	if( minBlockSize > std::numeric_limits<size_t>::max() - alignment - allocator_boundary_tags::allocatedMetadataSize ) {
+		error_with_guard([&] { return "[BOUNDARY_TAGS] Unable to allocate" + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+		throw std::bad_alloc();
+	}
+
+	struct block_metadata* freeBlock = this->findFreeBlock( minBlockSize + alignment + allocator_boundary_tags::allocatedMetadataSize );
 	if( !freeBlock ) {
-		error_with_guard("[BOUNDARY_TAGS] Unable to allocate" + std::to_string(minBlockSize) + " bytes");
+		error_with_guard([&] { return "[BOUNDARY_TAGS] Unable to allocate" + std::to_string(minBlockSize) + " bytes aligned to " + std::to_string(alignment); });
 		throw std::bad_alloc();
 	}
-	
-	debug_with_guard("[BOUNDARY_TAGS] Found block of size" + std::to_string(freeBlock->size) + " bytes");
-	
-	if( freeBlock->size > minBlockSize + allocator_boundary_tags::allocatedMetadataSize ) {
-		this->splitBlockAndInit( freeBlock, minBlockSize );
+
+	data->stats.on_allocation( size );
+	this->removeFree( freeBlock );
+
+	uintptr_t blockAddr = reinterpret_cast<uintptr_t>(freeBlock);
+	uintptr_t payload = (blockAddr + allocator_boundary_tags::allocatedMetadataSize + alignment - 1) & ~(uintptr_t(alignment) - 1);
+	size_t gap = payload - allocator_boundary_tags::allocatedMetadataSize - blockAddr;
+
+	// Leading block must at least fit its own header
+	if( gap != 0 && gap < allocator_boundary_tags::allocatedMetadataSize ) gap += alignment;
+
+	if( gap != 0 ) {
+		// Leading part stays free and the aligned tail is the one being allocated
+		struct block_metadata* gapBlock = freeBlock;
+		this->splitBlockAndInit( gapBlock, gap );
+		freeBlock = this->physicalNext( gapBlock );
+		this->removeFree( freeBlock );
+		this->insertFree( gapBlock );
 	}
-	
-	freeBlock->allocated = true;
-	freeBlock->parent = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
-	return recomputeWithOffset( freeBlock, allocator_boundary_tags::allocatedMetadataSize );
+
+	return this->takeBlock( freeBlock, minBlockSize );
 }
 
 void allocator_boundary_tags::deallocate( void* ptr ) {
 	if( !ptr ) return;
-	std::lock_guard<std::mutex> lock(this->mutex());
-	debug_with_guard("[BOUNDARY_TAGS] Initiated free of block at addr." + std::to_string(reinterpret_cast<size_t>(ptr)));
-	
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+
+	this->deallocateUnlocked( ptr );
+}
+
+/** Whole batch is carved out of one free block when there is one big enough, the blocks are then consecutive.
+ *  Otherwise every block is searched for on its own, still under a single lock.
+ */
+void allocator_boundary_tags::allocateBatch( size_t size, size_t count, void** out ) {
+	if( count == 0 ) return;
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+	debug_with_guard([&] { return "[BOUNDARY_TAGS] Initiated allocation of " + std::to_string(count) + " blocks of " + std::to_string(size) + " bytes"; });
+
+	size_t minBlockSize = this->realBlockSize( size );
+
+	struct block_metadata* freeBlock = minBlockSize <= data->memSize / count ? this->findFreeBlock( minBlockSize * count ) : nullptr;
+	if( freeBlock ) {
+		this->removeFree( freeBlock );
+
+		for( size_t i = 0; i + 1 < count; ++i ) {
+			// Tail keeps at least one more block, so it is split off even when takeBlock would not
+			this->splitBlockAndInit( freeBlock, minBlockSize );
+			freeBlock->allocated = true;
+			freeBlock->parent = data;
+			out[i] = recomputeWithOffset( freeBlock, allocator_boundary_tags::allocatedMetadataSize );
+			data->stats.on_allocation( size );
+
+			freeBlock = this->physicalNext( freeBlock );
+			this->removeFree( freeBlock );
+		}
+
+		out[count - 1] = this->takeBlock( freeBlock, minBlockSize );
+		data->stats.on_allocation( size );
+		return;
+	}
+
+	for( size_t i = 0; i < count; ++i ) {
+		freeBlock = this->findFreeBlock( minBlockSize );
+
+		if( !freeBlock ) {
+			error_with_guard([&] { return "[BOUNDARY_TAGS] Unable to allocate " + std::to_string(count) + " blocks of " + std::to_string(size) + " bytes"; });
+			for( size_t j = 0; j < i; ++j ) this->deallocateUnlocked( out[j] );
+			throw std::bad_alloc();
+		}
+
+		data->stats.on_allocation( size );
+		this->removeFree( freeBlock );
+		out[i] = this->takeBlock( freeBlock, minBlockSize );
+	}
+}
+
+void allocator_boundary_tags::deallocateBatch( void* const* ptrs, size_t count ) {
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+
+	for( size_t i = 0; i < count; ++i ) {
+		if( ptrs[i] ) this->deallocateUnlocked( ptrs[i] );
+	}
+}
+
+void allocator_boundary_tags::deallocateUnlocked( void* ptr ) {
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	debug_with_guard([&] { return "[BOUNDARY_TAGS] Initiated free of block at addr." + std::to_string(reinterpret_cast<size_t>(ptr)); });
+
 	auto block = reinterpret_cast<struct block_metadata*>(recomputeWithNegOffset(ptr, allocator_boundary_tags::allocatedMetadataSize));
-	
-	if( !block->allocated || block->parent != reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory) ) {
+
+	if( !block->allocated || block->parent != data ) {
 		error_with_guard( "[BOUNDARY_TAGS] Double free attempt!" );
 		return;
 	}
 	debug_with_guard("[BOUNDARY_TAGS] Freed!");
-	
-	
+
+	data->stats.on_deallocation();
 	block->allocated = false;
-	if( this->canMergeNext(block) ) mergeBlocks( block, block->next );
-	
-	if( this->canMergePrev(block) ) mergeBlocks( block->prev, block );
+
+	/** Free neighbours of decommitSize and above were released when they became free,
+	 *  only up to decommitSize of them is released again to cover the pages they share with this block.
+	 */
+	uintptr_t releaseBegin = reinterpret_cast<uintptr_t>(block) + allocator_boundary_tags::allocatedMetadataSize;
+	uintptr_t releaseEnd = reinterpret_cast<uintptr_t>(block) + block->size;
+
+	if( this->canMergeNext(block) ) {
+		struct block_metadata* next = this->physicalNext( block );
+		releaseEnd += std::min<size_t>( next->size, allocator_boundary_tags::decommitSize );
+		this->removeFree( next );
+		this->mergeBlocks( block, next );
+	}
+
+	if( this->canMergePrev(block) ) {
+		struct block_metadata* prev = block->prev;
+		releaseBegin = reinterpret_cast<uintptr_t>(block) - std::min<size_t>( prev->size - allocator_boundary_tags::allocatedMetadataSize, allocator_boundary_tags::decommitSize );
+		this->removeFree( prev );
+		this->mergeBlocks( prev, block );
+		block = prev;
+	}
+
+	this->insertFree( block );
+
+	if( data->pageSource && block->size >= allocator_boundary_tags::decommitSize ) {
+		data->pageSource->decommit( reinterpret_cast<void*>(releaseBegin), releaseEnd - releaseBegin );
+	}
 }
 
-struct block_metadata* allocator_boundary_tags::firstfit( size_t size ) {
-	struct block_metadata* curBlock = reinterpret_cast<struct block_metadata*>(this->trustedMemoryBegin());
-	debug_with_guard("[BOUNDARY_TAGS] Begin at" + std::to_string(reinterpret_cast<size_t>(curBlock)));
-	do {
-		debug_with_guard("[BOUNDARY_TAGS] Block" + std::to_string(reinterpret_cast<size_t>(curBlock)) + "/" +
-		std::to_string(curBlock->allocated) + "/" +
-		std::to_string(reinterpret_cast<size_t>(curBlock->size))
-		);
-		if( !curBlock->allocated && curBlock->size >= size ) return curBlock;
-	} while( (curBlock=curBlock->next) != nullptr );
-	
+/** Growing absorbs the physically next block when it is free and big enough, shrinking gives the tail back.
+ *  Any leftover is split off again and merged with the free block after it.
+ */
+bool allocator_boundary_tags::resizeInPlace( void* ptr, size_t size ) {
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+	debug_with_guard([&] { return "[BOUNDARY_TAGS] Initiated resize of block at addr." + std::to_string(reinterpret_cast<size_t>(ptr)) + " to " + std::to_string(size) + " bytes"; });
+
+	auto block = reinterpret_cast<struct block_metadata*>(recomputeWithNegOffset(ptr, allocator_boundary_tags::allocatedMetadataSize));
+
+	if( !block->allocated || block->parent != data ) {
+		error_with_guard( "[BOUNDARY_TAGS] Resize of a block which is not allocated!" );
+		return false;
+	}
+
+	if( size > allocator_boundary_tags::maxRequestSize ) return false;
+
+	size_t minBlockSize = this->realBlockSize( size );
+	struct block_metadata* next = this->physicalNext( block );
+	bool nextFree = this->canMergeNext( block );
+
+	if( minBlockSize > block->size + (nextFree ? next->size : 0) ) return false;
+
+	if( nextFree ) {
+		this->removeFree( next );
+		this->mergeBlocks( block, next );
+	}
+
+	if( block->size > minBlockSize + allocator_boundary_tags::allocatedMetadataSize ) {
+		this->splitBlockAndInit( block, minBlockSize );
+
+		struct block_metadata* tail = this->physicalNext( block );
+		if( this->canMergeNext( tail ) ) {
+			struct block_metadata* tailNext = this->physicalNext( tail );
+			this->removeFree( tail );
+			this->removeFree( tailNext );
+			this->mergeBlocks( tail, tailNext );
+			this->insertFree( tail );
+		}
+	}
+
+	return true;
+}
+
+struct block_metadata* allocator_boundary_tags::findFreeBlock( size_t size ) {
+	if( size > reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory)->memSize ) return nullptr;
+
+	switch( this->fitMode() ) {
+		case allocator_with_fit_mode::fit_mode::first_fit:
+			return this->firstfit( size );
+		case allocator_with_fit_mode::fit_mode::the_best_fit:
+			return this->bestfit( size );
+		case allocator_with_fit_mode::fit_mode::the_worst_fit:
+			return this->worstfit( size );
+	}
 	return nullptr;
 }
 
+/** Only the bin of the requested size may hold blocks that are too small,
+ *  any block of a higher non-empty bin fits, so that one is taken right away.
+ */
+struct block_metadata* allocator_boundary_tags::firstfit( size_t size ) {
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	size_t bin = binIndex( size );
+
+	for( struct block_metadata* curBlock = data->freeBins[bin]; curBlock; curBlock = curBlock->nextFree ) {
+		if( curBlock->size >= size ) return curBlock;
+	}
+
+	size_t higherBins = data->nonEmptyBins & (~size_t(0) << (bin + 1));
+	return higherBins ? data->freeBins[std::countr_zero( higherBins )] : nullptr;
+}
+
 struct block_metadata* allocator_boundary_tags::bestfit( size_t size ) {
-	struct block_metadata* curBlock = reinterpret_cast<struct block_metadata*>(this->trustedMemoryBegin());
-	
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	size_t bin = binIndex( size );
+
 	struct block_metadata* bestBlock = nullptr;
 	size_t bestSize = ~size_t(0); // Fuck limits.h
-	do {
+	for( struct block_metadata* curBlock = data->freeBins[bin]; curBlock; curBlock = curBlock->nextFree ) {
 		size_t blockSize = curBlock->size;
-		if( !curBlock->allocated && blockSize >= size && blockSize < bestSize ) {
+		if( blockSize >= size && blockSize < bestSize ) {
 			bestSize = blockSize;
 			bestBlock = curBlock;
 		}
-	} while( (curBlock=curBlock->next) != nullptr );
-	
+	}
+	if( bestBlock ) return bestBlock;
+
+	// Every block of the lowest higher bin fits, the best one is still the smallest of them
+	size_t higherBins = data->nonEmptyBins & (~size_t(0) << (bin + 1));
+	if( !higherBins ) return nullptr;
+
+	for( struct block_metadata* curBlock = data->freeBins[std::countr_zero( higherBins )]; curBlock; curBlock = curBlock->nextFree ) {
+		if( curBlock->size < bestSize ) {
+			bestSize = curBlock->size;
+			bestBlock = curBlock;
+		}
+	}
+
 	return bestBlock;
 }
 
 [[nodiscard]] void* allocator_boundary_tags::do_allocate_sm( size_t size ) { return this->allocate( size ); }
 void allocator_boundary_tags::do_deallocate_sm( void* ptr ) { this->deallocate( ptr ); }
+[[nodiscard]] void* allocator_boundary_tags::do_allocate_aligned_sm( size_t size, size_t alignment ) { return this->allocateAligned( size, alignment ); }
+// Header always sits right before the payload, padding lives in a separate free block
+void allocator_boundary_tags::do_deallocate_aligned_sm( void* ptr, size_t ) { this->deallocate( ptr ); }
+bool allocator_boundary_tags::do_try_resize_in_place_sm( void* ptr, size_t size ) { return this->resizeInPlace( ptr, size ); }
+void allocator_boundary_tags::do_allocate_batch_sm( size_t size, size_t count, void** out ) { this->allocateBatch( size, count, out ); }
+void allocator_boundary_tags::do_deallocate_batch_sm( void* const* ptrs, size_t count ) { this->deallocateBatch( ptrs, count ); }
 
 bool allocator_boundary_tags::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
 	auto p = dynamic_cast<const allocator_boundary_tags*>(&other);
@@ -197,18 +458,20 @@ bool allocator_boundary_tags::do_is_equal(const std::pmr::memory_resource& other
 
 
 struct block_metadata* allocator_boundary_tags::worstfit( size_t size ) {
-	struct block_metadata* curBlock = reinterpret_cast<struct block_metadata*>(this->trustedMemoryBegin());
-	
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	if( !data->nonEmptyBins ) return nullptr;
+
+	// Largest block can only be in the highest non-empty bin
 	struct block_metadata* worstBlock = nullptr;
 	size_t worstSize = 0; // Fuck limits.h
-	do {
+	for( struct block_metadata* curBlock = data->freeBins[std::bit_width( data->nonEmptyBins ) - 1]; curBlock; curBlock = curBlock->nextFree ) {
 		size_t blockSize = curBlock->size;
-		if( !curBlock->allocated && blockSize >= size && blockSize > worstSize ) {
+		if( blockSize >= size && blockSize > worstSize ) {
 			worstSize = blockSize;
 			worstBlock = curBlock;
 		}
-	} while( (curBlock=curBlock->next) != nullptr );
-	
+	}
+
 	return worstBlock;
 }
 
@@ -217,7 +480,12 @@ void* allocator_boundary_tags::trustedMemoryBegin() const {
 }
 
 size_t allocator_boundary_tags::realBlockSize( size_t size ) {
-	return size + allocator_boundary_tags::allocatedMetadataSize;
+	if( size > allocator_boundary_tags::maxRequestSize ) {
+		error_with_guard([&] { return "[BOUNDARY_TAGS] Unable to allocate" + std::to_string(size) + " bytes"; });
+		throw std::bad_alloc();
+	}
+
+	return (size + allocator_boundary_tags::allocatedMetadataSize + allocator_boundary_tags::blockAlignment - 1) & ~(allocator_boundary_tags::blockAlignment - 1);
 }
 
 allocator_with_fit_mode::fit_mode allocator_boundary_tags::fitMode() const {
@@ -247,12 +515,10 @@ std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_block
     std::back_insert_iterator<std::vector<allocator_test_utils::block_info>> inserter(out);
 
 	struct block_metadata* curBlock = reinterpret_cast<struct block_metadata*>(this->trustedMemoryBegin());
-	
-	struct block_metadata* worstBlock = nullptr;
-	size_t worstSize = ~size_t(0); // Fuck limits.h
+
 	do {
-		inserter = {curBlock->size + (curBlock->allocated ? 0 : sizeof( struct block_metadata ) ) , curBlock->allocated};
-	} while( (curBlock=curBlock->next) != nullptr );
+		inserter = {curBlock->size, curBlock->allocated};
+	} while( (curBlock=this->physicalNext(curBlock)) != nullptr );
 
     return out;
 }
@@ -261,4 +527,23 @@ std::vector<allocator_test_utils::block_info> allocator_boundary_tags::get_block
     std::lock_guard lock(this->mutex());
 
     return get_blocks_info_inner();
-}
\ No newline at end of file
+}
+
+/** Counters are kept up to date by every operation, only the largest free block is looked up here,
+ *  and it can only be in the highest non-empty bin.
+ */
+allocator_test_utils::allocator_stats allocator_boundary_tags::get_stats() const {
+	auto data = reinterpret_cast<struct allocator_metadata*>(this->_allocatorMemory);
+	std::lock_guard lock(data->globalLock);
+
+	allocator_test_utils::allocator_stats stats = data->stats;
+	stats.bytes_in_use = data->memSize - stats.free_bytes;
+
+	if( data->nonEmptyBins ) {
+		for( struct block_metadata* curBlock = data->freeBins[std::bit_width( data->nonEmptyBins ) - 1]; curBlock; curBlock = curBlock->nextFree ) {
+			stats.largest_free_block = std::max<size_t>( stats.largest_free_block, curBlock->size );
+		}
+	}
+
+	return stats;
+}
@@ -1,9 +1,13 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <allocator_dbg_helper.h>
 #include <allocator_boundary_tags.h>
 #include <client_logger_builder.h>
 #include <memory>
 #include <list>
+#include <cstring>
+#include <functional>
+#include <limits>
 
 logger *create_logger(
     std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
@@ -27,6 +31,14 @@ logger *create_logger(
     return logger_instance;
 }
 
+// Span of a block holding size bytes: payload padded to alignof(std::max_align_t), canaries of hardened builds and the block metadata
+size_t block_size_for(size_t size)
+{
+    size_t payload = size + smart_mem_resource::hardened_overhead;
+    payload = (payload + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+    return payload + sizeof(allocator_dbg_helper::block_size_t) + sizeof(allocator_dbg_helper::block_pointer_t) * 3;
+}
+
 //TODO: recalculate size
 
 TEST(positiveTests, test1)
@@ -38,14 +50,14 @@ TEST(positiveTests, test1)
                 logger::severity::information
             }
         }));
-    std::unique_ptr<smart_mem_resource> subject(new allocator_boundary_tags(sizeof(int) * 70, nullptr, logger.get(), allocator_with_fit_mode::fit_mode::first_fit));
+    std::unique_ptr<smart_mem_resource> subject(new allocator_boundary_tags(block_size_for(sizeof(int) * 16) * 3 + 32, nullptr, logger.get(), allocator_with_fit_mode::fit_mode::first_fit));
     
-    auto *first_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 10));
-    auto *second_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 10));
-    auto *third_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 10));
+    auto *first_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 16));
+    auto *second_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 16));
+    auto *third_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 16));
     
-    ASSERT_EQ(reinterpret_cast<int*>(reinterpret_cast<char*>(first_block + 10) + sizeof(size_t) + sizeof(void*) * 3), second_block);
-    ASSERT_EQ(reinterpret_cast<int*>(reinterpret_cast<char*>(second_block + 10) + sizeof(size_t) + sizeof(void*) * 3), third_block);
+    ASSERT_EQ(reinterpret_cast<int*>(reinterpret_cast<char*>(first_block) + block_size_for(sizeof(int) * 16)), second_block);
+    ASSERT_EQ(reinterpret_cast<int*>(reinterpret_cast<char*>(second_block) + block_size_for(sizeof(int) * 16)), third_block);
     
     subject->deallocate(const_cast<void *>(reinterpret_cast<void const *>(second_block)), 1);
     
@@ -55,8 +67,9 @@ TEST(positiveTests, test1)
     the_same_subject->set_fit_mode(allocator_with_fit_mode::fit_mode::the_best_fit);
     auto *fifth_block = reinterpret_cast<int *>(subject->allocate(sizeof(int) * 1));
     
-    ASSERT_EQ(reinterpret_cast<int*>(reinterpret_cast<char*>(first_block + 10) + sizeof(size_t) + sizeof(void*) * 3), fourth_block);
-    ASSERT_EQ(reinterpret_cast<int*>(reinterpret_cast<char*>(fourth_block + 1) + sizeof(size_t) + sizeof(void*) * 3), fifth_block);
+    // Payload of a single int is padded up to alignof(std::max_align_t)
+    ASSERT_EQ(reinterpret_cast<int*>(reinterpret_cast<char*>(first_block) + block_size_for(sizeof(int) * 16)), fourth_block);
+    ASSERT_EQ(reinterpret_cast<int*>(reinterpret_cast<char*>(fourth_block) + block_size_for(sizeof(int))), fifth_block);
     
     subject->deallocate(const_cast<void *>(reinterpret_cast<void const *>(first_block)), 1);
     subject->deallocate(const_cast<void *>(reinterpret_cast<void const *>(third_block)), 1);
@@ -83,9 +96,9 @@ TEST(positiveTests, test2)
     auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
     std::vector<allocator_test_utils::block_info> expected_blocks_state
         {
-            { .block_size = 1000 + sizeof(allocator_dbg_helper::block_size_t) + sizeof(allocator_dbg_helper::block_pointer_t) * 3, .is_block_occupied = true },
-            { .block_size = sizeof(allocator_dbg_helper::block_size_t) + sizeof(allocator_dbg_helper::block_pointer_t) * 3, .is_block_occupied = true },
-            { .block_size = 3000 - (1000 + (sizeof(allocator_dbg_helper::block_size_t) + sizeof(allocator_dbg_helper::block_pointer_t) * 3) * 2), .is_block_occupied = false }
+            { .block_size = block_size_for(1000), .is_block_occupied = true },
+            { .block_size = block_size_for(0), .is_block_occupied = true },
+            { .block_size = 3000 - block_size_for(1000) - block_size_for(0), .is_block_occupied = false }
         };
     
     ASSERT_EQ(actual_blocks_state.size(), expected_blocks_state.size());
@@ -113,6 +126,16 @@ TEST(falsePositiveTests, test1)
 
 }
 
+TEST(falsePositiveTests, test2)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_boundary_tags(3000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    // Header and padding would wrap the block size around
+    ASSERT_THROW(static_cast<void>(allocator_instance->allocate(std::numeric_limits<size_t>::max() - 8)), std::bad_alloc);
+    ASSERT_THROW(static_cast<void>(allocator_instance->allocate(std::numeric_limits<size_t>::max() - 8, 64)), std::bad_alloc);
+    ASSERT_EQ(dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info().size(), 1);
+}
+
 TEST(own, test1)
 {
     std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
@@ -210,6 +233,392 @@ TEST(own, test1)
     }
 }
 
+TEST(positiveTests, alignedAllocation)
+{
+    for (auto mode : { allocator_with_fit_mode::fit_mode::first_fit,
+                       allocator_with_fit_mode::fit_mode::the_best_fit,
+                       allocator_with_fit_mode::fit_mode::the_worst_fit })
+    {
+        std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_boundary_tags(8000, nullptr, nullptr, mode));
+        std::vector<std::pair<void *, size_t>> blocks;
+
+        for (size_t alignment : { 32, 64, 128 })
+        {
+            for (size_t size : { 1, 24, 100, 257 })
+            {
+                void *block = allocator_instance->allocate(size, alignment);
+                ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % alignment, 0);
+                memset(block, 0xAB, size);
+                blocks.emplace_back(block, alignment);
+            }
+        }
+
+        for (size_t i = 0; i < blocks.size(); i += 2)
+        {
+            allocator_instance->deallocate(blocks[i].first, 1, blocks[i].second);
+        }
+
+        void *block = allocator_instance->allocate(40, 64);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % 64, 0);
+        allocator_instance->deallocate(block, 1, 64);
+
+        for (size_t i = 1; i < blocks.size(); i += 2)
+        {
+            allocator_instance->deallocate(blocks[i].first, 1, blocks[i].second);
+        }
+    }
+}
+
+TEST(positiveTests, defaultAlignment)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_boundary_tags(8000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    std::vector<void *> blocks;
+
+    for (size_t size : { 1, 7, 13, 24, 100, 257, 0, 3 })
+    {
+        void *block = allocator_instance->allocate(size);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % alignof(std::max_align_t), 0);
+        blocks.push_back(block);
+    }
+
+    for (void *block : blocks)
+    {
+        allocator_instance->deallocate(block, 1);
+    }
+}
+
+TEST(positiveTests, coalescing)
+{
+    for (auto mode : { allocator_with_fit_mode::fit_mode::first_fit,
+                       allocator_with_fit_mode::fit_mode::the_best_fit,
+                       allocator_with_fit_mode::fit_mode::the_worst_fit })
+    {
+        std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_boundary_tags(1 << 16, nullptr, nullptr, mode));
+        std::vector<void *> blocks;
+        srand(0);
+
+        // Fragment the arena with holes of every size, then free everything in random order
+        for (size_t i = 0; i < 400; ++i)
+        {
+            blocks.push_back(allocator_instance->allocate(1 + rand() % 100));
+        }
+
+        for (size_t i = 0; i < blocks.size(); i += 2)
+        {
+            allocator_instance->deallocate(blocks[i], 1);
+            blocks[i] = nullptr;
+        }
+
+        for (size_t i = 0; i < blocks.size(); i += 2)
+        {
+            blocks[i] = allocator_instance->allocate(1 + rand() % 50);
+        }
+
+        while (!blocks.empty())
+        {
+            auto it = blocks.begin() + rand() % blocks.size();
+            allocator_instance->deallocate(*it, 1);
+            blocks.erase(it);
+        }
+
+        auto blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
+        ASSERT_EQ(blocks_state.size(), 1);
+        ASSERT_EQ(blocks_state[0].block_size, 1 << 16);
+        ASSERT_FALSE(blocks_state[0].is_block_occupied);
+    }
+}
+
+TEST(positiveTests, statistics)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_boundary_tags(1 << 16, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    auto *utils = dynamic_cast<allocator_test_utils *>(allocator_instance.get());
+    std::vector<void *> blocks;
+    srand(0);
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+        blocks.push_back(allocator_instance->allocate(1 + rand() % 200));
+    }
+
+    for (size_t i = 0; i < blocks.size(); i += 3)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+
+    // Counters kept along the way have to agree with a full walk over the blocks
+    auto stats = utils->get_stats();
+    size_t bytes_in_use = 0, free_bytes = 0, largest_free_block = 0, free_blocks_count = 0;
+    auto blocks_state = utils->get_blocks_info();
+    for (auto const &block : blocks_state)
+    {
+        if (block.is_block_occupied)
+        {
+            bytes_in_use += block.block_size;
+            continue;
+        }
+
+        ++free_blocks_count;
+        free_bytes += block.block_size;
+        largest_free_block = std::max(largest_free_block, block.block_size);
+    }
+
+    ASSERT_EQ(stats.blocks_count, blocks_state.size());
+    ASSERT_EQ(stats.free_blocks_count, free_blocks_count);
+    ASSERT_EQ(stats.bytes_in_use, bytes_in_use);
+    ASSERT_EQ(stats.free_bytes, free_bytes);
+    ASSERT_EQ(stats.largest_free_block, largest_free_block);
+    ASSERT_EQ(stats.allocations_count, 200);
+    ASSERT_EQ(stats.deallocations_count, 67);
+    ASSERT_GT(stats.fragmentation(), 0.0);
+    ASSERT_LT(stats.fragmentation(), 1.0);
+
+    size_t histogram_total = 0;
+    for (size_t count : stats.size_histogram)
+    {
+        histogram_total += count;
+    }
+    ASSERT_EQ(histogram_total, 200);
+    ASSERT_EQ(stats.size_histogram[9], 0);
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        if (i % 3 != 0)
+        {
+            allocator_instance->deallocate(blocks[i], 1);
+        }
+    }
+
+    stats = utils->get_stats();
+    ASSERT_EQ(stats.blocks_count, 1);
+    ASSERT_EQ(stats.bytes_in_use, 0);
+    ASSERT_EQ(stats.largest_free_block, 1 << 16);
+    ASSERT_EQ(stats.fragmentation(), 0.0);
+}
+
+TEST(positiveTests, batchAllocation)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_boundary_tags(1 << 14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    auto *utils = dynamic_cast<allocator_test_utils *>(allocator_instance.get());
+    std::vector<void *> blocks(50);
+
+    allocator_instance->allocate_batch(40, blocks.size(), blocks.data());
+
+    // Whole batch is carved out of one free block, so every block follows the previous one
+    for (size_t i = 1; i < blocks.size(); ++i)
+    {
+        ASSERT_GT(blocks[i], blocks[i - 1]);
+        ASSERT_EQ(reinterpret_cast<char *>(blocks[i]) - reinterpret_cast<char *>(blocks[i - 1]),
+                  reinterpret_cast<char *>(blocks[1]) - reinterpret_cast<char *>(blocks[0]));
+    }
+
+    auto stats = utils->get_stats();
+    ASSERT_EQ(stats.allocations_count, 50);
+    ASSERT_EQ(stats.blocks_count, 51);
+
+    std::vector<void *> fillers;
+    try
+    {
+        while (true)
+        {
+            fillers.push_back(allocator_instance->allocate(40));
+        }
+    }
+    catch (std::bad_alloc const &)
+    {
+    }
+
+    // Blocks of a batch are ordinary blocks, each one can be freed on its own
+    for (size_t i = 0; i < blocks.size(); i += 2)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+
+    // No free block holds the batch any more, so it is assembled from the holes
+    std::vector<void *> refill(25), holes;
+    allocator_instance->allocate_batch(40, refill.size(), refill.data());
+    for (size_t i = 0; i < blocks.size(); i += 2)
+    {
+        holes.push_back(blocks[i]);
+    }
+    std::vector<void *> sorted_refill(refill);
+    std::sort(sorted_refill.begin(), sorted_refill.end());
+    ASSERT_EQ(sorted_refill, holes);
+
+    allocator_instance->deallocate_batch(refill.data(), refill.size());
+    allocator_instance->deallocate_batch(fillers.data(), fillers.size());
+    for (size_t i = 1; i < blocks.size(); i += 2)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+    ASSERT_EQ(utils->get_blocks_info().size(), 1);
+
+    // Nothing stays allocated when the batch doesn't fit
+    blocks.resize(100);
+    ASSERT_THROW(allocator_instance->allocate_batch(200, blocks.size(), blocks.data()), std::bad_alloc);
+    stats = utils->get_stats();
+    ASSERT_EQ(stats.blocks_count, 1);
+    ASSERT_EQ(stats.bytes_in_use, 0);
+
+    pp_allocator<double> allocator(allocator_instance.get());
+    double *numbers[10];
+    allocator.allocate_batch(10, numbers);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        *numbers[i] = static_cast<double>(i);
+    }
+    allocator.deallocate_batch(numbers, 10);
+    ASSERT_EQ(utils->get_blocks_info().size(), 1);
+}
+
+TEST(positiveTests, resizeInPlace)
+{
+    std::unique_ptr<smart_mem_resource> allocator(new allocator_boundary_tags(1 << 14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    auto *utils = dynamic_cast<allocator_test_utils *>(allocator.get());
+
+    void *first = allocator->allocate(100);
+    void *second = allocator->allocate(100);
+    void *third = allocator->allocate(100);
+    allocator->deallocate(second, 1);
+
+    // Free neighbour is absorbed, the occupied block behind it stops the growth
+    ASSERT_TRUE(allocator->try_resize_in_place(first, 200));
+    ASSERT_FALSE(allocator->try_resize_in_place(first, 400));
+    ASSERT_TRUE(allocator->try_resize_in_place(first, 20));
+    ASSERT_TRUE(allocator->try_resize_in_place(third, 1000));
+    ASSERT_FALSE(allocator->try_resize_in_place(third, 1 << 15));
+    ASSERT_FALSE(allocator->try_resize_in_place(third, 100, 64));
+
+    allocator->deallocate(first, 1);
+    allocator->deallocate(third, 1);
+    ASSERT_EQ(utils->get_blocks_info().size(), 1);
+
+    // Contents up to the smaller of both sizes survive, other blocks are never touched
+    std::vector<std::pair<unsigned char *, size_t>> blocks;
+    srand(0);
+
+    auto check = [](unsigned char *block, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            ASSERT_EQ(block[i], static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block) >> 4));
+        }
+    };
+
+    for (size_t i = 0; i < 3000; ++i)
+    {
+        switch (blocks.empty() ? 0 : rand() % 3)
+        {
+            case 0:
+                try
+                {
+                    size_t size = 1 + rand() % 300;
+                    auto block = reinterpret_cast<unsigned char *>(allocator->allocate(size));
+                    memset(block, static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block) >> 4), size);
+                    blocks.emplace_back(block, size);
+                }
+                catch (std::bad_alloc const &)
+                {
+                }
+                break;
+            case 1:
+            {
+                auto it = blocks.begin() + rand() % blocks.size();
+                check(it->first, it->second);
+                allocator->deallocate(it->first, 1);
+                blocks.erase(it);
+                break;
+            }
+            case 2:
+            {
+                auto &[block, size] = blocks[rand() % blocks.size()];
+                size_t new_size = 1 + rand() % 600;
+                if (allocator->try_resize_in_place(block, new_size))
+                {
+                    check(block, std::min(size, new_size));
+                    memset(block, static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block) >> 4), new_size);
+                    size = new_size;
+                }
+                break;
+            }
+        }
+    }
+
+    for (auto &[block, size] : blocks)
+    {
+        check(block, size);
+        allocator->deallocate(block, 1);
+    }
+
+    auto stats = utils->get_stats();
+    ASSERT_EQ(stats.blocks_count, 1);
+    ASSERT_EQ(stats.free_bytes, 1 << 14);
+}
+
+TEST(falsePositiveTests, resizeOverflow)
+{
+    std::unique_ptr<smart_mem_resource> allocator(new allocator_boundary_tags(1 << 14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    auto *utils = dynamic_cast<allocator_test_utils *>(allocator.get());
+
+    void *block = allocator->allocate(100);
+    auto blocks_state = utils->get_blocks_info();
+
+    // Header and padding would wrap the new block size around
+    for (size_t size : { std::numeric_limits<size_t>::max() - 8, std::numeric_limits<size_t>::max() })
+    {
+        ASSERT_FALSE(allocator->try_resize_in_place(block, size));
+        ASSERT_EQ(utils->get_blocks_info(), blocks_state);
+    }
+
+    allocator->deallocate(block, 1);
+}
+
+TEST(falsePositiveTests, hardening)
+{
+    if (!smart_mem_resource::hardened)
+    {
+        GTEST_SKIP() << "Built without MP_OS_ALLOCATOR_HARDENED";
+    }
+
+    std::unique_ptr<smart_mem_resource> allocator(new allocator_boundary_tags(3000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    auto error_of = [&](std::function<void()> const &action) -> std::string
+    {
+        try
+        {
+            action();
+        }
+        catch (std::logic_error const &error)
+        {
+            return error.what();
+        }
+
+        return "";
+    };
+
+    // Overrun is caught on free and on resize, the block stays allocated
+    auto block = reinterpret_cast<unsigned char *>(allocator->allocate(100));
+    block[100] ^= 1;
+    ASSERT_EQ(error_of([&] { allocator->deallocate(block, 1); }), "[HARDENED] Block overrun, tail canary is corrupted!");
+    ASSERT_EQ(error_of([&] { allocator->try_resize_in_place(block, 50); }), "[HARDENED] Block overrun, tail canary is corrupted!");
+    block[100] ^= 1;
+
+    ASSERT_TRUE(allocator->try_resize_in_place(block, 50));
+    block[49] = 1;
+    allocator->deallocate(block, 1);
+
+    // Freed bytes are poisoned until the allocator hands them out again
+    for (size_t i = 0; i < 32; ++i)
+    {
+        ASSERT_EQ(block[i], smart_mem_resource::poison_byte);
+    }
+
+    ASSERT_EQ(error_of([&] { allocator->deallocate(block, 1); }), "[HARDENED] Double free!");
+    ASSERT_EQ(error_of([&] { allocator->deallocate(block + 16, 1); }), "[HARDENED] Block header is corrupted or the pointer is not a block!");
+
+    auto blocks = dynamic_cast<allocator_test_utils *>(allocator.get())->get_blocks_info();
+    ASSERT_EQ(blocks.size(), 1);
+    ASSERT_FALSE(blocks[0].is_block_occupied);
+}
 
 int main(
     int argc,
@@ -5,30 +5,12 @@
 #include <allocator_with_fit_mode.h>
 #include <logger_guardant.h>
 #include <typename_holder.h>
+#include <resource_with_decommit.h>
+#include <bit_utils.h>
 #include <mutex>
-#include <cmath>
 
 #define CPU_VM_BITS 56 // As of 2025, CPUs support Virtual Memory addressation up to 56 bits. All bits above shall be either zero'ed or one'd
 
-namespace __detail
-{
-    constexpr size_t nearest_greater_k_of_2(size_t size) noexcept {
-        int ones_counter = 0, index = -1;
-
-        constexpr const size_t o = 1;
-
-        for (int i = sizeof(size_t) * 8 - 1; i >= 0; --i) {
-            if (size & (o << i)) {
-                if (ones_counter == 0)
-                    index = i;
-                ++ones_counter;
-            }
-        }
-
-        return ones_counter <= 1 ? index : index + 1;
-    }
-}
-
 class allocator_buddies_system final:
     public smart_mem_resource,
     public allocator_test_utils,
@@ -53,10 +35,31 @@ private:
         size_t memSize;
         std::mutex globalLock;
         BuddyBlock* blocks[CPU_VM_BITS];
+        // Bit k is set while blocks[k] is not empty
+        uint64_t nonEmptyOrders;
+        // Order of the whole managed space
+        size_t spaceOrder;
+        /** One bit per buddy pair of every order below spaceOrder, flipped whenever either block of the pair
+         *  enters or leaves the free list of that order. For a block which is not free, the bit tells if its buddy is.
+         *  Lives right after the managed space.
+         */
+        uint64_t* buddyMap;
+        // Parent able to take pages of free blocks back, nullptr for any other parent
+        resource_with_decommit* pageSource;
+        // Free counters follow push_free/remove_free, the total one follows splits and merges
+        allocator_test_utils::allocator_stats stats;
     };
 
     void* _trusted_memory;
-    static constexpr const size_t min_k = __detail::nearest_greater_k_of_2(sizeof(BuddyMetadata));
+
+    // Occupied blocks keep the whole header, so payloads are aligned like the ones of operator new
+    static constexpr const size_t payload_offset = sizeof(BuddyBlock);
+    static_assert(payload_offset % alignof(std::max_align_t) == 0);
+
+    static constexpr const size_t min_k = __detail::ceil_log2(sizeof(BuddyMetadata));
+
+    // Free blocks of at least 64 KiB give their pages back to a pageSource
+    static constexpr const size_t decommit_order = 16;
 
 public:
     explicit allocator_buddies_system(
@@ -90,6 +93,27 @@ public:
     void do_deallocate_sm(
         void *at) override;
 
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_aligned_sm(
+        void *at,
+        size_t alignment) override;
+
+    bool do_try_resize_in_place_sm(
+        void *at,
+        size_t new_size) override;
+
+    void do_allocate_batch_sm(
+        size_t size,
+        size_t count,
+        void **out) override;
+
+    void do_deallocate_batch_sm(
+        void *const *ptrs,
+        size_t count) override;
+
     bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
 
     inline void set_fit_mode(
@@ -97,10 +121,17 @@ public:
 
     std::vector<allocator_test_utils::block_info> get_blocks_info() const noexcept override;
 
+    allocator_test_utils::allocator_stats get_stats() const override;
+
 private:
-    void split_first_block(BuddyBlock* block);
     struct BuddyBlock* get_buddy(BuddyBlock* b) const;
+    size_t buddy_map_index(BuddyBlock* b) const;
+    bool is_buddy_free(BuddyBlock* b) const;
+    void push_free(BuddyBlock* b);
+    void remove_free(BuddyBlock* b);
     struct BuddyBlock* get_block(size_t size) noexcept;
+    // Caller holds globalLock
+    void free_block(void* at);
     
     inline logger *get_logger() const override;
     inline std::string get_typename() const override;
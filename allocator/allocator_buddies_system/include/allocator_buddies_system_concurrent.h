@@ -0,0 +1,115 @@
+#pragma once
+
+#include <pp_allocator.h>
+#include <allocator_test_utils.h>
+#include <allocator_with_fit_mode.h>
+#include <logger_guardant.h>
+#include <typename_holder.h>
+#include <atomic>
+#include <mutex>
+#include "allocator_buddies_system.h"
+
+/** Buddy system without a global lock: every order keeps its free blocks in a tagged Treiber stack,
+ *  so allocation and deallocation are a few CASes. Freed blocks are not merged right away;
+ *  buddies are coalesced under a lock only when no free block is big enough for a request.
+ *  Block layout and user pointers match allocator_buddies_system.
+ */
+class allocator_buddies_system_concurrent final:
+    public smart_mem_resource,
+    public allocator_test_utils,
+    public allocator_with_fit_mode,
+    private logger_guardant,
+    private typename_holder
+{
+private:
+
+    // Status lives in the two upper bits of the state byte, the order in the rest
+    static constexpr const uint8_t order_mask = 0x3F;
+    static constexpr const uint8_t status_interior = 0x00; // header of a block merged into its buddy
+    static constexpr const uint8_t status_free = 0x40;     // in the stack of its order
+    static constexpr const uint8_t status_held = 0x80;     // taken out of the stacks by coalescing
+    static constexpr const uint8_t status_occupied = 0xC0;
+
+    static constexpr const size_t min_order = 4;
+
+    struct BuddyBlock {
+        std::atomic<uint8_t> state;
+        uint8_t padding[7];
+        // Index of the next block in the stack, meaningful only while the block is free
+        std::atomic<uint64_t> next;
+    };
+
+    // Same payload layout as allocator_buddies_system
+    static constexpr const size_t payload_offset = sizeof(BuddyBlock);
+    static_assert(payload_offset % alignof(std::max_align_t) == 0);
+
+    // Head packs the ABA tag in the upper half and the index of the top block (0 - empty) in the lower one
+    struct alignas(64) FreeStack {
+        std::atomic<uint64_t> head;
+    };
+
+    struct alignas(64) BuddyMetadata {
+        logger* loggerObj;
+        std::pmr::memory_resource* allocatorObj;
+        allocator_with_fit_mode::fit_mode fitMode;
+        size_t memSize;
+        size_t spaceOrder;
+        std::mutex coalesceLock;
+        FreeStack stacks[CPU_VM_BITS];
+    };
+
+    void* _trusted_memory;
+
+public:
+    explicit allocator_buddies_system_concurrent(
+            size_t space_size_power_of_two,
+            std::pmr::memory_resource *parent_allocator = nullptr,
+            logger *logger = nullptr,
+            allocator_with_fit_mode::fit_mode allocate_fit_mode = allocator_with_fit_mode::fit_mode::first_fit);
+
+    allocator_buddies_system_concurrent(
+        allocator_buddies_system_concurrent const &other) = delete;
+
+    allocator_buddies_system_concurrent &operator=(
+        allocator_buddies_system_concurrent const &other) = delete;
+
+    allocator_buddies_system_concurrent(
+        allocator_buddies_system_concurrent &&other) noexcept;
+
+    allocator_buddies_system_concurrent &operator=(
+        allocator_buddies_system_concurrent &&other) noexcept;
+
+    ~allocator_buddies_system_concurrent() override;
+
+public:
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    inline void set_fit_mode(
+        allocator_with_fit_mode::fit_mode mode) override;
+
+    // Coalesces free buddies first, the result is exact only while no other thread uses the allocator
+    std::vector<allocator_test_utils::block_info> get_blocks_info() const noexcept override;
+
+private:
+    BuddyBlock* space_begin() const noexcept;
+    uint64_t index_of(BuddyBlock* block) const noexcept;
+    BuddyBlock* block_at(uint64_t index) const noexcept;
+
+    void push(size_t order, BuddyBlock* block) const noexcept;
+    BuddyBlock* pop(size_t order) const noexcept;
+
+    BuddyBlock* take_block(size_t order) noexcept;
+    // Caller holds coalesceLock
+    void coalesce() const;
+
+    inline logger *get_logger() const override;
+    inline std::string get_typename() const override;
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
+};
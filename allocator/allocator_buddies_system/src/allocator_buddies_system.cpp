@@ -1,5 +1,7 @@
 #include <not_implemented.h>
+#include <algorithm>
 #include <cstddef>
+#include <bit>
 #include <cstring>
 #include <iostream>
 #include "../include/allocator_buddies_system.h"
@@ -8,120 +10,318 @@
 allocator_buddies_system::BuddyBlock* allocator_buddies_system::next_block( allocator_buddies_system::BuddyBlock* b ) const {
 	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
 	
-	auto addr = (allocator_buddies_system::BuddyBlock*)((uintptr_t)b + (size_t)pow(2, b->size)); // + sizeof(allocator_buddies_system::BuddyBlock));
-	return (uintptr_t)(addr) < (uintptr_t)data + data->memSize - 2 ? addr : nullptr; // 2 Because of block metadata
+	auto addr = (allocator_buddies_system::BuddyBlock*)((uintptr_t)b + (size_t(1) << b->size)); // + sizeof(allocator_buddies_system::BuddyBlock));
+	return (uintptr_t)(addr) < (uintptr_t)data + sizeof(BuddyMetadata) + (size_t(1) << data->spaceOrder) ? addr : nullptr;
 }
 
 allocator_buddies_system::BuddyBlock* allocator_buddies_system::get_buddy( allocator_buddies_system::BuddyBlock* b ) const {
 	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+    if (b->size >= data->spaceOrder) {
+        return nullptr;
+    }
+
     size_t block_size = size_t(1) << b->size;
     uintptr_t base_address = ((uintptr_t)this->_trusted_memory + sizeof(BuddyMetadata));
     uintptr_t block_offset = reinterpret_cast<uintptr_t>(b) - base_address;
     uintptr_t buddy_offset = block_offset ^ block_size;
     
-    if (buddy_offset + block_size > data->memSize) {
-        return nullptr;
-    }
-    
     return reinterpret_cast<allocator_buddies_system::BuddyBlock*>(base_address + buddy_offset);
 }
 
+// Pairs of the top order come first, every lower order takes twice as many bits as the one above
+size_t allocator_buddies_system::buddy_map_index( allocator_buddies_system::BuddyBlock* b ) const {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	uintptr_t block_offset = reinterpret_cast<uintptr_t>(b) - ((uintptr_t)this->_trusted_memory + sizeof(BuddyMetadata));
+	return (size_t(1) << (data->spaceOrder - 1 - b->size)) - 1 + (block_offset >> (b->size + 1));
+}
+
+bool allocator_buddies_system::is_buddy_free( allocator_buddies_system::BuddyBlock* b ) const {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	if( b->size >= data->spaceOrder ) return false;
+	
+	size_t index = this->buddy_map_index(b);
+	return (data->buddyMap[index / 64] >> (index % 64)) & 1;
+}
+
+void allocator_buddies_system::push_free( allocator_buddies_system::BuddyBlock* b ) {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	
+	b->occupied = false;
+	b->prev = 0;
+	b->next = (uintptr_t)data->blocks[b->size];
+	if( data->blocks[b->size] != nullptr ) data->blocks[b->size]->prev = (uintptr_t)b;
+	data->blocks[b->size] = b;
+	data->nonEmptyOrders |= uint64_t(1) << b->size;
+	++data->stats.free_blocks_count;
+	data->stats.free_bytes += size_t(1) << b->size;
+	
+	if( b->size < data->spaceOrder ) {
+		size_t index = this->buddy_map_index(b);
+		data->buddyMap[index / 64] ^= uint64_t(1) << (index % 64);
+	}
+}
+
+void allocator_buddies_system::remove_free( allocator_buddies_system::BuddyBlock* b ) {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	
+	if( b->prev == 0 ) {
+		data->blocks[b->size] = reinterpret_cast<allocator_buddies_system::BuddyBlock*>(b->next);
+		if( data->blocks[b->size] == nullptr ) data->nonEmptyOrders &= ~(uint64_t(1) << b->size);
+	}else{
+		reinterpret_cast<allocator_buddies_system::BuddyBlock*>(b->prev)->next = b->next;
+	}
+	if( b->next ) reinterpret_cast<allocator_buddies_system::BuddyBlock*>(b->next)->prev = b->prev;
+	--data->stats.free_blocks_count;
+	data->stats.free_bytes -= size_t(1) << b->size;
+	
+	if( b->size < data->spaceOrder ) {
+		size_t index = this->buddy_map_index(b);
+		data->buddyMap[index / 64] ^= uint64_t(1) << (index % 64);
+	}
+}
+
 std::mutex& allocator_buddies_system::mutex() const {
 	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
     return data->globalLock;
 }
 allocator_buddies_system::~allocator_buddies_system() {
-	std::lock_guard lock(this->mutex());
 	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	std::pmr::memory_resource* parentAllocator = data->allocatorObj;
+	size_t memSize = data->memSize;
 	
-	if( data->allocatorObj ) {
-		data->allocatorObj->deallocate( this->_trusted_memory, data->memSize );
+	// Mutex lives inside the memory being released, so it can't be held here
+	data->~BuddyMetadata();
+	
+	if( parentAllocator ) {
+		parentAllocator->deallocate( this->_trusted_memory, memSize, alignof(BuddyMetadata) );
 	}else{
-		::operator delete( this->_trusted_memory );
+		::operator delete( this->_trusted_memory, std::align_val_t(alignof(BuddyMetadata)) );
 	}
 }
 allocator_buddies_system::allocator_buddies_system( size_t size, std::pmr::memory_resource* parentAllocator, logger* logger, allocator_with_fit_mode::fit_mode fitMode ) {
 	if( size < 5 ) throw std::logic_error("[BUDDY] Insufficient space");
 	
-	size_t allocSize = (1 << (size_t)(log2( size ))) + sizeof(BuddyMetadata);
-	
-	this->_trusted_memory = (parentAllocator == nullptr) ? ::operator new(allocSize) : parentAllocator->allocate(allocSize, 1);
+	size_t spaceOrder = __detail::floor_log2( size );
+	size_t spaceSize = size_t(1) << spaceOrder;
+	size_t mapWords = spaceOrder > 4 ? ((size_t(1) << (spaceOrder - 4)) + 63) / 64 : 1;
+	size_t allocSize = spaceSize + sizeof(BuddyMetadata) + mapWords * sizeof(uint64_t);
 	
-	BuddyMetadata* data = (BuddyMetadata*)this->_trusted_memory;
+	// Metadata is cache line aligned, so every block of order >= 6 starts at a 64 byte boundary
+	this->_trusted_memory = (parentAllocator == nullptr) ? ::operator new(allocSize, std::align_val_t(alignof(BuddyMetadata))) : parentAllocator->allocate(allocSize, alignof(BuddyMetadata));
 	
-	memset(&data->blocks, 0, sizeof(BuddyMetadata));
+	BuddyMetadata* data = new (this->_trusted_memory) BuddyMetadata();
 	data->loggerObj = logger;
 	data->allocatorObj = parentAllocator;
 	data->fitMode = fitMode;
 	data->memSize = allocSize;
+	data->spaceOrder = spaceOrder;
+	data->buddyMap = reinterpret_cast<uint64_t*>((uintptr_t)this->_trusted_memory + sizeof(BuddyMetadata) + spaceSize);
+	data->pageSource = dynamic_cast<resource_with_decommit*>(parentAllocator);
+	memset( data->buddyMap, 0, mapWords * sizeof(uint64_t) );
 	
-	data->blocks[(size_t)(log2(size))] = (allocator_buddies_system::BuddyBlock*)((uintptr_t)this->_trusted_memory + sizeof(BuddyMetadata));
-	
-	data->blocks[(size_t)(log2(size))]->occupied = false;
-	data->blocks[(size_t)(log2(size))]->size = log2(size);
-	data->blocks[(size_t)(log2(size))]->next = 0;
+	allocator_buddies_system::BuddyBlock* firstBlock = (allocator_buddies_system::BuddyBlock*)((uintptr_t)this->_trusted_memory + sizeof(BuddyMetadata));
+	firstBlock->size = spaceOrder;
+	this->push_free( firstBlock );
+	data->stats.blocks_count = 1;
 }
 
 [[nodiscard]] void *allocator_buddies_system::do_allocate_sm( size_t size ) {
-    std::lock_guard lock(this->mutex());
 	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
-	debug_with_guard("[BUDDY] Allocating " + std::to_string(size) + " bytes");
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+	debug_with_guard([&] { return "[BUDDY] Allocating " + std::to_string(size) + " bytes"; });
 	
 	allocator_buddies_system::BuddyBlock* freeBlock = this->get_block(size);
 	
 	if( freeBlock == nullptr ) {
-		debug_with_guard("[BUDDY] Unable to allocate " + std::to_string(size) + " bytes");
+		debug_with_guard([&] { return "[BUDDY] Unable to allocate " + std::to_string(size) + " bytes"; });
         return nullptr;
 	}
 	
-	debug_with_guard("[BUDDY] Block found." + std::to_string((size_t)freeBlock) );
+	debug_with_guard([&] { return "[BUDDY] Block found." + std::to_string((size_t)freeBlock); });
+	data->stats.on_allocation( size );
 	
 	if( freeBlock->size != size ) {
-		warning_with_guard( "[BUDDY] allocated space of " + std::to_string(pow(2,freeBlock->size)) + "bytes allocated instead of requested space!" );
+		warning_with_guard([&] { return "[BUDDY] allocated space of " + std::to_string(size_t(1) << freeBlock->size) + "bytes allocated instead of requested space!"; });
 	}
 
 	
-	return reinterpret_cast<void*>((uintptr_t)(freeBlock) + 1);
+	return reinterpret_cast<void*>((uintptr_t)(freeBlock) + payload_offset);
 }
 
 
+/** Blocks of order k sit at k-aligned offsets from the 64 byte aligned base, so a block of at least
+ *  size + alignment bytes keeps its header at the start and hands out block + alignment.
+ */
+[[nodiscard]] void *allocator_buddies_system::do_allocate_aligned_sm( size_t size, size_t alignment ) {
+	if( alignment > alignof(BuddyMetadata) ) return smart_mem_resource::do_allocate_aligned_sm( size, alignment );
+	
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+	debug_with_guard([&] { return "[BUDDY] Allocating " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+	
+	// Checked before the sum is formed, it would wrap to a small block for sizes close to SIZE_MAX
+	size_t spaceSize = size_t(1) << data->spaceOrder;
+	allocator_buddies_system::BuddyBlock* freeBlock = alignment <= spaceSize && size <= spaceSize - alignment ? this->get_block(size + alignment - payload_offset) : nullptr;
+	
+	if( freeBlock == nullptr ) {
+		debug_with_guard([&] { return "[BUDDY] Unable to allocate " + std::to_string(size) + " aligned bytes"; });
+		return nullptr;
+	}
+	data->stats.on_allocation( size );
+	
+	return reinterpret_cast<void*>((uintptr_t)(freeBlock) + alignment);
+}
+
+void allocator_buddies_system::do_deallocate_aligned_sm( void *at, size_t alignment ) {
+	if( alignment > alignof(BuddyMetadata) ) return smart_mem_resource::do_deallocate_aligned_sm( at, alignment );
+	if( at == nullptr ) return;
+	
+	this->do_deallocate_sm( reinterpret_cast<void*>((uintptr_t)(at) - alignment + payload_offset) );
+}
+
 void allocator_buddies_system::do_deallocate_sm( void *at ) {
 	if( at == nullptr ) return;
-    std::lock_guard lock(this->mutex());
 	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
-	allocator_buddies_system::BuddyBlock* block = (allocator_buddies_system::BuddyBlock*)((uintptr_t)(at) - 1);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+	
+	this->free_block( at );
+}
+
+/** Splitting the first block leaves its upper halves at the heads of the free lists, so blocks taken
+ *  one after another under the same lock come out of one region next to each other.
+ */
+void allocator_buddies_system::do_allocate_batch_sm( size_t size, size_t count, void **out ) {
+	if( count == 0 ) return;
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+	debug_with_guard([&] { return "[BUDDY] Allocating " + std::to_string(count) + " blocks of " + std::to_string(size) + " bytes"; });
+	
+	for( size_t i = 0; i < count; ++i ) {
+		allocator_buddies_system::BuddyBlock* freeBlock = this->get_block(size);
+		
+		if( freeBlock == nullptr ) {
+			error_with_guard([&] { return "[BUDDY] Unable to allocate " + std::to_string(count) + " blocks of " + std::to_string(size) + " bytes"; });
+			
+			for( size_t j = 0; j < i; ++j ) this->free_block( out[j] );
+			throw std::bad_alloc();
+		}
+		
+		data->stats.on_allocation( size );
+		out[i] = reinterpret_cast<void*>((uintptr_t)(freeBlock) + payload_offset);
+	}
+}
+
+void allocator_buddies_system::do_deallocate_batch_sm( void *const *ptrs, size_t count ) {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+	debug_with_guard([&] { return "[BUDDY] Freeing " + std::to_string(count) + " blocks"; });
+	
+	for( size_t i = 0; i < count; ++i ) {
+		if( ptrs[i] != nullptr ) this->free_block( ptrs[i] );
+	}
+}
+
+void allocator_buddies_system::free_block( void *at ) {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	allocator_buddies_system::BuddyBlock* block = (allocator_buddies_system::BuddyBlock*)((uintptr_t)(at) - payload_offset);
 	
 	debug_with_guard("[BUDDY] Freeing obj");
-	if( (uintptr_t)(at) < (uintptr_t)(this->_trusted_memory) || (uintptr_t)(at) > (uintptr_t)(this->_trusted_memory) + data->memSize + sizeof(allocator_buddies_system::BuddyBlock) ) {
+	uintptr_t spaceBegin = (uintptr_t)(this->_trusted_memory) + sizeof(BuddyMetadata);
+	if( (uintptr_t)(block) < spaceBegin || (uintptr_t)(block) >= spaceBegin + (size_t(1) << data->spaceOrder) ) {
 		error_with_guard("[BUDDY] Invalid deallocation");
 		throw std::logic_error("[BUDDY] Invalid deallocation!");
 	}
 	
-	while( this->get_buddy(block) && !this->get_buddy(block)->occupied && this->get_buddy(block)->size == block->size ) {
-		if( this->get_buddy(block) < block ) block = this->get_buddy(block);
-		
+	if( !block->occupied ) {
+		error_with_guard("[BUDDY] Double free attempt");
+		throw std::logic_error("[BUDDY] Invalid deallocation!");
+	}
+	
+	data->stats.on_deallocation();
+	size_t freedOrder = block->size;
+	uintptr_t freedOffset = (uintptr_t)(block) - spaceBegin;
+	
+	// Buddy map answers whether the buddy is free without reading its header
+	while( this->is_buddy_free(block) ) {
 		allocator_buddies_system::BuddyBlock* buddy = this->get_buddy(block);
+		this->remove_free( buddy );
 		
-		if( buddy->prev == 0 ) {
-			if( buddy->next ) reinterpret_cast<allocator_buddies_system::BuddyBlock*>(buddy->next)->prev = 0;
-			data->blocks[buddy->size] = reinterpret_cast<allocator_buddies_system::BuddyBlock*>(buddy->next);
-		}else{
-			reinterpret_cast<allocator_buddies_system::BuddyBlock*>(buddy->prev)->next = buddy->next;
-			if( buddy->next ) reinterpret_cast<allocator_buddies_system::BuddyBlock*>(buddy->next)->prev = buddy->prev;
+		// Header of the upper half turns into free space, the pages around it were kept for it
+		if( data->pageSource && block->size >= decommit_order ) {
+			uintptr_t lower = (uintptr_t)std::min( block, buddy );
+			uintptr_t upper = (uintptr_t)std::max( block, buddy );
+			uintptr_t releaseBegin = std::max( upper - (size_t(1) << decommit_order), lower + sizeof(BuddyBlock) );
+			data->pageSource->decommit( reinterpret_cast<void*>(releaseBegin), upper + (size_t(1) << decommit_order) - releaseBegin );
 		}
 		
+		if( buddy < block ) block = buddy;
+		
 		block->size++;
+		--data->stats.blocks_count;
 		debug_with_guard("[BUDDY] Merged Block!");
 	}
 	
-	if( data->blocks[block->size] != nullptr ) {
-		block->next = (uintptr_t)data->blocks[block->size];
-		data->blocks[block->size]->prev = (uintptr_t)block;
+	this->push_free( block );
+	
+	/** Free buddies of decommit_order and above were released when they became free, so only the freed block
+	 *  or its enclosing block of that order is left. Space is not page aligned, so the range also takes
+	 *  the neighbouring blocks of that order for the pages they share, all of it stays clear of the header.
+	 */
+	if( data->pageSource && block->size >= decommit_order ) {
+		size_t order = std::max( freedOrder, decommit_order );
+		uintptr_t releaseBegin = spaceBegin + (freedOffset & ~((size_t(1) << order) - 1));
+		uintptr_t releaseEnd = releaseBegin + (size_t(1) << order);
+		releaseBegin = std::max( releaseBegin - (size_t(1) << decommit_order), (uintptr_t)(block) + sizeof(BuddyBlock) );
+		releaseEnd = std::min( releaseEnd + (size_t(1) << decommit_order), (uintptr_t)(block) + (size_t(1) << block->size) );
+		
+		data->pageSource->decommit( reinterpret_cast<void*>(releaseBegin), releaseEnd - releaseBegin );
+	}
+}
+
+/** Shrinking gives the upper halves back as free buddies. Growing promotes the block one order at a time,
+ *  which is possible only while it is the lower buddy and its buddy is free as a whole.
+ */
+bool allocator_buddies_system::do_try_resize_in_place_sm( void *at, size_t newSize ) {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	auto lock = lock_counting_wait( data->globalLock, data->stats );
+	allocator_buddies_system::BuddyBlock* block = (allocator_buddies_system::BuddyBlock*)((uintptr_t)(at) - payload_offset);
+	
+	debug_with_guard([&] { return "[BUDDY] Resizing obj to " + std::to_string(newSize) + " bytes"; });
+	uintptr_t spaceBegin = (uintptr_t)(this->_trusted_memory) + sizeof(BuddyMetadata);
+	if( (uintptr_t)(block) < spaceBegin || (uintptr_t)(block) >= spaceBegin + (size_t(1) << data->spaceOrder) || !block->occupied ) {
+		error_with_guard("[BUDDY] Invalid resize");
+		throw std::logic_error("[BUDDY] Invalid resize!");
+	}
+	
+	if( newSize > (size_t(1) << data->spaceOrder) - payload_offset ) return false;
+
+	size_t order = std::max<size_t>( std::bit_width( newSize + payload_offset - 1 ), 4 );
+	if( order > data->spaceOrder ) return false;
+	
+	while( block->size > order ) {
+		block->size--;
+		
+		allocator_buddies_system::BuddyBlock* buddy = reinterpret_cast<allocator_buddies_system::BuddyBlock*>((uintptr_t)block + (size_t(1) << block->size));
+		buddy->size = block->size;
+		this->push_free( buddy );
+		++data->stats.blocks_count;
+	}
+	
+	// Buddy region always starts with a block header, it is a whole free buddy only with the same order
+	for( size_t k = block->size; k < order; ++k ) {
+		if( ((uintptr_t)block - spaceBegin) & (size_t(1) << k) ) return false;
+		
+		auto buddy = reinterpret_cast<allocator_buddies_system::BuddyBlock*>((uintptr_t)block + (size_t(1) << k));
+		if( buddy->occupied || buddy->size != k ) return false;
 	}
-	data->blocks[block->size] = block;
-	block->prev = 0;
 	
-	block->occupied = false;
+	while( block->size < order ) {
+		this->remove_free( reinterpret_cast<allocator_buddies_system::BuddyBlock*>((uintptr_t)block + (size_t(1) << block->size)) );
+		block->size++;
+		--data->stats.blocks_count;
+	}
+	
+	return true;
 }
 
 allocator_buddies_system::allocator_buddies_system(const allocator_buddies_system &other) {
@@ -157,6 +357,18 @@ std::vector<allocator_test_utils::block_info> allocator_buddies_system::get_bloc
 }
 
 
+// Largest free block is of the highest non-empty order, so no list is walked at all
+allocator_test_utils::allocator_stats allocator_buddies_system::get_stats() const {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	std::lock_guard lock(this->mutex());
+	
+	allocator_test_utils::allocator_stats stats = data->stats;
+	stats.bytes_in_use = (size_t(1) << data->spaceOrder) - stats.free_bytes;
+	stats.largest_free_block = data->nonEmptyOrders ? size_t(1) << (std::bit_width( data->nonEmptyOrders ) - 1) : 0;
+	
+	return stats;
+}
+
 inline std::string allocator_buddies_system::get_typename() const {
     return "allocator_buddies_system";
 }
@@ -171,58 +383,38 @@ std::vector<allocator_test_utils::block_info> allocator_buddies_system::get_bloc
 	
 	allocator_buddies_system::BuddyBlock* worstBlock = nullptr;
 	do {
-		inserter = {static_cast<size_t>(pow(2, curBlock->size)), curBlock->occupied};
+		inserter = {size_t(1) << curBlock->size, curBlock->occupied};
 	} while( (curBlock=this->next_block(curBlock)) != nullptr && curBlock->size != 0 );
 
     return out;
 }
 
-void allocator_buddies_system::split_first_block( allocator_buddies_system::BuddyBlock* block ) {
+allocator_buddies_system::BuddyBlock* allocator_buddies_system::get_block(size_t size) noexcept {
 	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
-	size_t oldSize = block->size;
-	data->blocks[oldSize] = reinterpret_cast<allocator_buddies_system::BuddyBlock*>(block->next);
 	
+	// Block also holds the header, so size bytes need an order with 2^order >= size + payload_offset
+	if( size > (size_t(1) << data->spaceOrder) - payload_offset ) return nullptr;
+	size_t order = std::bit_width( size + payload_offset - 1 );
+	// Free block has to hold its whole header with list links
+	if( order < 4 ) order = 4;
+	if( order > data->spaceOrder ) return nullptr;
 	
-	block->size--;
+	uint64_t candidates = data->nonEmptyOrders & (~uint64_t(0) << order);
+	if( !candidates ) return nullptr;
 	
-	allocator_buddies_system::BuddyBlock* buddy = this->get_buddy( block );
-
-	buddy->next = (uintptr_t)data->blocks[block->size];
-	if( buddy->next != 0 ) (reinterpret_cast<allocator_buddies_system::BuddyBlock*>(buddy->next))->prev = (uintptr_t)buddy;
-	block->next = (uintptr_t)buddy;
-	buddy->prev = (uintptr_t)block;
-	block->prev = 0;
+	size_t offset = std::countr_zero( candidates );
+	allocator_buddies_system::BuddyBlock* block = data->blocks[offset];
+	this->remove_free( block );
 	
-	buddy->size = block->size;
-	buddy->occupied = false;
-	
-	data->blocks[block->size] = block;
-}
-
-allocator_buddies_system::BuddyBlock* allocator_buddies_system::get_block(size_t size) noexcept {
-	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
-	
-	allocator_buddies_system::BuddyBlock** blocks = data->blocks;
-	
-	size_t initialOffset = size == 0 ? 4 : ceil(log2(size));
-	if( size == (size_t)pow(2, initialOffset) ) initialOffset++;
-	for( size_t offset = initialOffset; offset < CPU_VM_BITS; ++offset ) {
-		if( blocks[offset] && blocks[offset]->size != offset ) return nullptr;
-		if( blocks[offset] ) {
-			
-			while( initialOffset < offset ) {
-				this->split_first_block( blocks[offset--] );
-			}
-			
-			blocks[offset]->occupied = true;
-			blocks[offset]->size = offset;
-			allocator_buddies_system::BuddyBlock* block = blocks[offset];
-			blocks[offset] = reinterpret_cast<allocator_buddies_system::BuddyBlock*>(blocks[offset]->next);
-			if( blocks[offset] ) blocks[offset]->prev = 0;
-			
-			return block;
-		}
+	while( offset > order ) {
+		block->size = --offset;
+		
+		allocator_buddies_system::BuddyBlock* buddy = reinterpret_cast<allocator_buddies_system::BuddyBlock*>((uintptr_t)block + (size_t(1) << offset));
+		buddy->size = offset;
+		this->push_free( buddy );
+		++data->stats.blocks_count;
 	}
 	
-	return nullptr;
-}
\ No newline at end of file
+	block->occupied = true;
+	return block;
+}
@@ -0,0 +1,248 @@
+#include <bit>
+#include <utility>
+#include "../include/allocator_buddies_system_concurrent.h"
+
+
+allocator_buddies_system_concurrent::allocator_buddies_system_concurrent( size_t size, std::pmr::memory_resource* parentAllocator, logger* logger, allocator_with_fit_mode::fit_mode fitMode ) {
+	size_t spaceOrder = size == 0 ? 0 : std::bit_width( size ) - 1;
+	// Free block has to hold its header with the stack link, stack indices are 32 bit wide and 0 marks an empty stack
+	if( spaceOrder < min_order ) throw std::logic_error("[BUDDY] Insufficient space");
+	if( spaceOrder >= 32 + min_order ) throw std::logic_error("[BUDDY] Space is too large");
+
+	size_t allocSize = (size_t(1) << spaceOrder) + sizeof(BuddyMetadata);
+
+	this->_trusted_memory = (parentAllocator == nullptr) ? ::operator new(allocSize, std::align_val_t(alignof(BuddyMetadata))) : parentAllocator->allocate(allocSize, alignof(BuddyMetadata));
+
+	BuddyMetadata* data = new (this->_trusted_memory) BuddyMetadata();
+	data->loggerObj = logger;
+	data->allocatorObj = parentAllocator;
+	data->fitMode = fitMode;
+	data->memSize = allocSize;
+	data->spaceOrder = spaceOrder;
+
+	BuddyBlock* firstBlock = new (this->space_begin()) BuddyBlock();
+	firstBlock->state.store( status_free | spaceOrder, std::memory_order_relaxed );
+	this->push( spaceOrder, firstBlock );
+}
+
+allocator_buddies_system_concurrent::allocator_buddies_system_concurrent( allocator_buddies_system_concurrent &&other ) noexcept : _trusted_memory(std::exchange(other._trusted_memory, nullptr)) {
+}
+
+allocator_buddies_system_concurrent &allocator_buddies_system_concurrent::operator=( allocator_buddies_system_concurrent &&other ) noexcept {
+	if( this != &other ) std::swap( this->_trusted_memory, other._trusted_memory );
+	return *this;
+}
+
+allocator_buddies_system_concurrent::~allocator_buddies_system_concurrent() {
+	if( !this->_trusted_memory ) return;
+
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	std::pmr::memory_resource* parentAllocator = data->allocatorObj;
+	size_t memSize = data->memSize;
+
+	data->~BuddyMetadata();
+
+	if( parentAllocator ) {
+		parentAllocator->deallocate( this->_trusted_memory, memSize, alignof(BuddyMetadata) );
+	}else{
+		::operator delete( this->_trusted_memory, std::align_val_t(alignof(BuddyMetadata)) );
+	}
+}
+
+allocator_buddies_system_concurrent::BuddyBlock* allocator_buddies_system_concurrent::space_begin() const noexcept {
+	return reinterpret_cast<BuddyBlock*>((uintptr_t)this->_trusted_memory + sizeof(BuddyMetadata));
+}
+
+uint64_t allocator_buddies_system_concurrent::index_of( BuddyBlock* block ) const noexcept {
+	return (((uintptr_t)block - (uintptr_t)this->space_begin()) >> min_order) + 1;
+}
+
+allocator_buddies_system_concurrent::BuddyBlock* allocator_buddies_system_concurrent::block_at( uint64_t index ) const noexcept {
+	return reinterpret_cast<BuddyBlock*>((uintptr_t)this->space_begin() + ((index - 1) << min_order));
+}
+
+void allocator_buddies_system_concurrent::push( size_t order, BuddyBlock* block ) const noexcept {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	std::atomic<uint64_t>& head = data->stacks[order].head;
+	uint64_t index = this->index_of( block );
+
+	uint64_t oldHead = head.load( std::memory_order_relaxed );
+	uint64_t newHead;
+	do {
+		block->next.store( oldHead & 0xFFFFFFFF, std::memory_order_relaxed );
+		newHead = (((oldHead >> 32) + 1) << 32) | index;
+	} while( !head.compare_exchange_weak( oldHead, newHead, std::memory_order_release, std::memory_order_relaxed ) );
+}
+
+/** Top block may be popped and reused by another thread between reading its link and the CAS,
+ *  the tag in the head makes such a CAS fail, and the read itself always stays inside the managed space.
+ */
+allocator_buddies_system_concurrent::BuddyBlock* allocator_buddies_system_concurrent::pop( size_t order ) const noexcept {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	std::atomic<uint64_t>& head = data->stacks[order].head;
+
+	uint64_t oldHead = head.load( std::memory_order_acquire );
+	while( (oldHead & 0xFFFFFFFF) != 0 ) {
+		BuddyBlock* block = this->block_at( oldHead & 0xFFFFFFFF );
+		uint64_t newHead = (((oldHead >> 32) + 1) << 32) | block->next.load( std::memory_order_relaxed );
+
+		if( head.compare_exchange_weak( oldHead, newHead, std::memory_order_acquire, std::memory_order_acquire ) ) return block;
+	}
+
+	return nullptr;
+}
+
+allocator_buddies_system_concurrent::BuddyBlock* allocator_buddies_system_concurrent::take_block( size_t order ) noexcept {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+
+	for( size_t offset = order; offset <= data->spaceOrder; ++offset ) {
+		BuddyBlock* block = this->pop( offset );
+		if( !block ) continue;
+
+		// Popped block belongs to this thread only, upper halves are published through their stacks
+		while( offset > order ) {
+			--offset;
+			auto buddy = reinterpret_cast<BuddyBlock*>((uintptr_t)block + (size_t(1) << offset));
+			buddy->state.store( status_free | offset, std::memory_order_relaxed );
+			this->push( offset, buddy );
+		}
+
+		block->state.store( status_occupied | order, std::memory_order_relaxed );
+		return block;
+	}
+
+	return nullptr;
+}
+
+/** Drains every stack, merges the drained blocks whose buddies were drained too, order by order,
+ *  and pushes the result back. Blocks freed meanwhile simply stay unmerged until the next run.
+ */
+void allocator_buddies_system_concurrent::coalesce() const {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	std::vector<std::vector<BuddyBlock*>> held(data->spaceOrder + 1);
+
+	for( size_t order = min_order; order <= data->spaceOrder; ++order ) {
+		BuddyBlock* block;
+		while( (block = this->pop( order )) != nullptr ) {
+			block->state.store( status_held | order, std::memory_order_relaxed );
+			held[order].push_back( block );
+		}
+	}
+
+	for( size_t order = min_order; order <= data->spaceOrder; ++order ) {
+		for( BuddyBlock* block : held[order] ) {
+			// Already merged as the buddy of an earlier block
+			if( block->state.load( std::memory_order_relaxed ) != (status_held | order) ) continue;
+
+			if( order < data->spaceOrder ) {
+				uintptr_t spaceBegin = (uintptr_t)this->space_begin();
+				auto buddy = reinterpret_cast<BuddyBlock*>(spaceBegin + (((uintptr_t)block - spaceBegin) ^ (size_t(1) << order)));
+
+				if( buddy->state.load( std::memory_order_relaxed ) == (status_held | order) ) {
+					BuddyBlock* lower = std::min( block, buddy );
+					BuddyBlock* upper = std::max( block, buddy );
+					upper->state.store( status_interior, std::memory_order_relaxed );
+					lower->state.store( status_held | (order + 1), std::memory_order_relaxed );
+					held[order + 1].push_back( lower );
+					continue;
+				}
+			}
+
+			block->state.store( status_free | order, std::memory_order_relaxed );
+			this->push( order, block );
+		}
+	}
+}
+
+[[nodiscard]] void *allocator_buddies_system_concurrent::do_allocate_sm( size_t size ) {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+
+	// Block also holds the header, so size bytes need an order with 2^order >= size + payload_offset
+	// Checked before the sum is formed, it would wrap to a small order for sizes close to SIZE_MAX
+	if( size > (size_t(1) << data->spaceOrder) - payload_offset ) {
+		debug_with_guard([&] { return "[BUDDY] Unable to allocate " + std::to_string(size) + " bytes"; });
+		return nullptr;
+	}
+
+	size_t order = std::max( std::bit_width( size + payload_offset - 1 ), min_order );
+
+	BuddyBlock* block = this->take_block( order );
+
+	if( !block ) {
+		std::lock_guard lock(data->coalesceLock);
+		debug_with_guard("[BUDDY] Coalescing free blocks");
+
+		this->coalesce();
+		block = this->take_block( order );
+	}
+
+	if( !block ) {
+		debug_with_guard([&] { return "[BUDDY] Unable to allocate " + std::to_string(size) + " bytes"; });
+		return nullptr;
+	}
+
+	return reinterpret_cast<void*>((uintptr_t)(block) + payload_offset);
+}
+
+void allocator_buddies_system_concurrent::do_deallocate_sm( void *at ) {
+	if( at == nullptr ) return;
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	auto block = reinterpret_cast<BuddyBlock*>((uintptr_t)(at) - payload_offset);
+
+	uintptr_t spaceBegin = (uintptr_t)this->space_begin();
+	if( (uintptr_t)(block) < spaceBegin || (uintptr_t)(block) >= spaceBegin + (size_t(1) << data->spaceOrder) || ((uintptr_t)(block) - spaceBegin) % (size_t(1) << min_order) != 0 ) {
+		error_with_guard("[BUDDY] Invalid deallocation");
+		throw std::logic_error("[BUDDY] Invalid deallocation!");
+	}
+
+	// Only one of the threads freeing the same block wins the CAS
+	uint8_t state = block->state.load( std::memory_order_relaxed );
+	if( (state & ~order_mask) != status_occupied || !block->state.compare_exchange_strong( state, status_free | (state & order_mask), std::memory_order_relaxed ) ) {
+		error_with_guard("[BUDDY] Double free attempt");
+		throw std::logic_error("[BUDDY] Invalid deallocation!");
+	}
+
+	this->push( state & order_mask, block );
+}
+
+bool allocator_buddies_system_concurrent::do_is_equal( const std::pmr::memory_resource &other ) const noexcept {
+	return this == &other;
+}
+
+inline void allocator_buddies_system_concurrent::set_fit_mode( allocator_with_fit_mode::fit_mode mode ) {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	std::lock_guard lock(data->coalesceLock);
+	data->fitMode = mode;
+}
+
+std::vector<allocator_test_utils::block_info> allocator_buddies_system_concurrent::get_blocks_info() const noexcept {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	std::lock_guard lock(data->coalesceLock);
+
+	this->coalesce();
+	return get_blocks_info_inner();
+}
+
+std::vector<allocator_test_utils::block_info> allocator_buddies_system_concurrent::get_blocks_info_inner() const {
+	BuddyMetadata* data = (BuddyMetadata*)(this->_trusted_memory);
+	std::vector<allocator_test_utils::block_info> out;
+
+	uintptr_t spaceEnd = (uintptr_t)this->space_begin() + (size_t(1) << data->spaceOrder);
+	for( uintptr_t cur = (uintptr_t)this->space_begin(); cur < spaceEnd; ) {
+		uint8_t state = reinterpret_cast<BuddyBlock*>(cur)->state.load( std::memory_order_relaxed );
+		size_t blockSize = size_t(1) << (state & order_mask);
+
+		out.push_back({ blockSize, (state & ~order_mask) == status_occupied });
+		cur += blockSize;
+	}
+
+	return out;
+}
+
+logger* allocator_buddies_system_concurrent::get_logger() const {
+	return ((BuddyMetadata*)(this->_trusted_memory))->loggerObj;
+}
+
+inline std::string allocator_buddies_system_concurrent::get_typename() const {
+	return "allocator_buddies_system_concurrent";
+}
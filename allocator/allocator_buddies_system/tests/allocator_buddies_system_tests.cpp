@@ -1,9 +1,16 @@
 #include <gtest/gtest.h>
+#include <bit>
 #include <cmath>
 #include <allocator_dbg_helper.h>
 #include <allocator_buddies_system.h>
+#include <allocator_buddies_system_concurrent.h>
 #include <client_logger_builder.h>
 #include <list>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <new>
+#include <thread>
 
 
 logger *create_logger(
@@ -28,7 +35,18 @@ logger *create_logger(
     return logger_instance;
 }
 
-TEST(positiveTests, test1)
+// Every scenario runs against both the locking and the lock-free buddy allocators
+using buddies_allocators = testing::Types<allocator_buddies_system, allocator_buddies_system_concurrent>;
+
+template<typename T>
+class positiveTests : public testing::Test {};
+TYPED_TEST_SUITE(positiveTests, buddies_allocators);
+
+template<typename T>
+class falsePositiveTests : public testing::Test {};
+TYPED_TEST_SUITE(falsePositiveTests, buddies_allocators);
+
+TYPED_TEST(positiveTests, test1)
 {
     std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
         {
@@ -37,7 +55,7 @@ TEST(positiveTests, test1)
                 logger::severity::information
             }
         }));
-    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_buddies_system(4096, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
+    std::unique_ptr<smart_mem_resource> allocator_instance(new TypeParam(4096, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
     
     auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
     std::vector<allocator_test_utils::block_info> expected_blocks_state
@@ -53,7 +71,7 @@ TEST(positiveTests, test1)
     }
 }
 
-TEST(positiveTests, test23)
+TYPED_TEST(positiveTests, test23)
 {
     std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
         {
@@ -62,9 +80,10 @@ TEST(positiveTests, test23)
                 logger::severity::information
             }
         }));
-    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_buddies_system(256, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
+    std::unique_ptr<smart_mem_resource> allocator_instance(new TypeParam(256, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
     
-    void *first_block = allocator_instance->allocate(sizeof(unsigned char) * 40);
+    // Block of 64 bytes with the header, canaries of hardened builds included
+    void *first_block = allocator_instance->allocate(sizeof(unsigned char) * 40 - smart_mem_resource::hardened_overhead);
     
     auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
     std::vector<allocator_test_utils::block_info> expected_blocks_state
@@ -83,17 +102,19 @@ TEST(positiveTests, test23)
     allocator_instance->deallocate(first_block, 1);
 }
 
-TEST(positiveTests, test3)
+TYPED_TEST(positiveTests, test3)
 {
-    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_buddies_system(256, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    std::unique_ptr<smart_mem_resource> allocator_instance(new TypeParam(256, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
     
     void *first_block = allocator_instance->allocate(sizeof(unsigned char) * 0);
     void *second_block = allocator_instance->allocate(sizeof(unsigned char) * 0);
     allocator_instance->deallocate(first_block, 1);
     
+    // Empty hardened blocks still hold the canaries, so they take a bigger order
+    size_t smallest = std::bit_ceil((1 << (static_cast<int>(std::floor(std::log2(sizeof(allocator_dbg_helper::block_pointer_t) + 1))) + 1)) + smart_mem_resource::hardened_overhead);
     auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
-    ASSERT_EQ(actual_blocks_state.size(), 5);
-    ASSERT_EQ(actual_blocks_state[0].block_size, 1 << (static_cast<int>(std::floor(std::log2(sizeof(allocator_dbg_helper::block_pointer_t) + 1))) + 1));
+    ASSERT_EQ(actual_blocks_state.size(), std::countr_zero(256 / smallest) + 1);
+    ASSERT_EQ(actual_blocks_state[0].block_size, smallest);
     ASSERT_EQ(actual_blocks_state[0].is_block_occupied, false);
     ASSERT_EQ(actual_blocks_state[0].block_size, actual_blocks_state[1].block_size);
     ASSERT_EQ(actual_blocks_state[1].is_block_occupied, true);
@@ -101,7 +122,7 @@ TEST(positiveTests, test3)
     allocator_instance->deallocate(second_block, 1);
 }
 
-TEST(positiveTests, test53)
+TYPED_TEST(positiveTests, test53)
 {
     std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
                                                     {
@@ -131,7 +152,7 @@ TEST(positiveTests, test53)
                                                             }
                                                     }));
 
-    std::unique_ptr<smart_mem_resource> alloc(new allocator_buddies_system(4090, nullptr, logger_instance.get(),
+    std::unique_ptr<smart_mem_resource> alloc(new TypeParam(4090, nullptr, logger_instance.get(),
                                                                allocator_with_fit_mode::fit_mode::first_fit));
 
     auto first_block = reinterpret_cast<int *>(alloc->allocate(sizeof(int) * 250));
@@ -140,7 +161,7 @@ TEST(positiveTests, test53)
     alloc->deallocate(first_block, 1);
     first_block = reinterpret_cast<int *>(alloc->allocate(sizeof(int) * 245));
 
-    std::unique_ptr<smart_mem_resource> allocator(new allocator_buddies_system(7256, nullptr, logger_instance.get(),
+    std::unique_ptr<smart_mem_resource> allocator(new TypeParam(7256, nullptr, logger_instance.get(),
                                                                    allocator_with_fit_mode::fit_mode::first_fit));
     auto *the_same_subject = dynamic_cast<allocator_with_fit_mode *>(allocator.get());
     int iterations_count = 100;
@@ -200,9 +221,364 @@ TEST(positiveTests, test53)
     }
 }
 
-TEST(falsePositiveTests, test1)
+TYPED_TEST(positiveTests, alignedAllocation)
+{
+    for (auto mode : { allocator_with_fit_mode::fit_mode::first_fit,
+                       allocator_with_fit_mode::fit_mode::the_best_fit,
+                       allocator_with_fit_mode::fit_mode::the_worst_fit })
+    {
+        std::unique_ptr<smart_mem_resource> allocator_instance(new TypeParam(8192, nullptr, nullptr, mode));
+        std::vector<std::pair<void *, size_t>> blocks;
+
+        for (size_t alignment : { 32, 64, 128 })
+        {
+            for (size_t size : { 1, 24, 100 })
+            {
+                void *block = allocator_instance->allocate(size, alignment);
+                ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % alignment, 0);
+                memset(block, 0xAB, size);
+                blocks.emplace_back(block, alignment);
+            }
+        }
+
+        for (auto &[block, alignment] : blocks)
+        {
+            allocator_instance->deallocate(block, 1, alignment);
+        }
+
+        auto actual_blocks_state = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info();
+        ASSERT_EQ(actual_blocks_state.size(), 1);
+        ASSERT_EQ(actual_blocks_state[0], (allocator_test_utils::block_info{ .block_size = 8192, .is_block_occupied = false }));
+    }
+}
+
+TYPED_TEST(positiveTests, defaultAlignment)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new TypeParam(4096, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    pp_allocator<double> doubles(allocator_instance.get());
+    std::vector<void *> blocks;
+
+    for (size_t size : { 1, 7, 16, 17, 100 })
+    {
+        blocks.push_back(allocator_instance->allocate(size));
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(blocks.back()) % alignof(std::max_align_t), 0);
+    }
+
+    double *values = doubles.allocate(3);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(values) % alignof(double), 0);
+    doubles.deallocate(values, 3);
+
+    for (void *block : blocks)
+    {
+        allocator_instance->deallocate(block, 1);
+    }
+
+    ASSERT_EQ(dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info().size(), 1);
+}
+
+TYPED_TEST(positiveTests, resizeInPlace)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new TypeParam(4096, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    void *first = allocator_instance->allocate(20);
+
+    // Lock-free variant keeps the default and never resizes
+    if constexpr (std::is_same_v<TypeParam, allocator_buddies_system_concurrent>)
+    {
+        ASSERT_FALSE(allocator_instance->try_resize_in_place(first, 40));
+        allocator_instance->deallocate(first, 1);
+        return;
+    }
+
+    void *second = allocator_instance->allocate(20);
+    allocator_instance->deallocate(second, 1);
+
+    // Lower buddy is promoted while its buddies of every order are free
+    ASSERT_TRUE(allocator_instance->try_resize_in_place(first, 40));
+    ASSERT_TRUE(allocator_instance->try_resize_in_place(first, 200));
+    // Compiler still sizes the block by the first request, the laundered pointer hides that
+    memset(std::launder(static_cast<std::byte *>(first)), 0xAB, 200);
+
+    void *third = allocator_instance->allocate(200);
+    ASSERT_FALSE(allocator_instance->try_resize_in_place(first, 400));
+    ASSERT_FALSE(allocator_instance->try_resize_in_place(third, 400));
+    ASSERT_FALSE(allocator_instance->try_resize_in_place(first, 8192));
+
+    // Shrunk block keeps the order of its 16 byte header and 10 bytes
+    ASSERT_TRUE(allocator_instance->try_resize_in_place(first, 10));
+    ASSERT_EQ(dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_blocks_info()[0],
+              (allocator_test_utils::block_info{ .block_size = std::bit_ceil(16 + 10 + smart_mem_resource::hardened_overhead), .is_block_occupied = true }));
+
+    allocator_instance->deallocate(first, 1);
+    allocator_instance->deallocate(third, 1);
+
+    auto stats = dynamic_cast<allocator_test_utils *>(allocator_instance.get())->get_stats();
+    ASSERT_EQ(stats.blocks_count, 1);
+    ASSERT_EQ(stats.free_bytes, 4096);
+}
+
+TYPED_TEST(positiveTests, batchAllocation)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new TypeParam(4096, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    auto *utils = dynamic_cast<allocator_test_utils *>(allocator_instance.get());
+    void *blocks[8];
+
+    allocator_instance->allocate_batch(16, 8, blocks);
+
+    // Locking variant splits one region, so the blocks of one order come out one after another
+    if constexpr (std::is_same_v<TypeParam, allocator_buddies_system>)
+    {
+        for (size_t i = 1; i < 8; ++i)
+        {
+            ASSERT_EQ(reinterpret_cast<char *>(blocks[i]) - reinterpret_cast<char *>(blocks[i - 1]), std::bit_ceil(32 + smart_mem_resource::hardened_overhead));
+        }
+    }
+
+    allocator_instance->deallocate(blocks[3], 1);
+    allocator_instance->deallocate_batch(blocks, 3);
+    allocator_instance->deallocate_batch(blocks + 4, 4);
+    ASSERT_EQ(utils->get_blocks_info().size(), 1);
+
+    // Nothing stays allocated when the batch doesn't fit
+    ASSERT_THROW(allocator_instance->allocate_batch(1000, 8, blocks), std::bad_alloc);
+    ASSERT_EQ(utils->get_blocks_info().size(), 1);
+}
+
+TYPED_TEST(positiveTests, statistics)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new TypeParam(1 << 16, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    auto *utils = dynamic_cast<allocator_test_utils *>(allocator_instance.get());
+    std::vector<void *> blocks;
+    srand(0);
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        blocks.push_back(allocator_instance->allocate(1 + rand() % 300));
+    }
+
+    for (size_t i = 0; i < blocks.size(); i += 3)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+
+    auto stats = utils->get_stats();
+    size_t bytes_in_use = 0, free_bytes = 0, largest_free_block = 0;
+    auto blocks_state = utils->get_blocks_info();
+    for (auto const &block : blocks_state)
+    {
+        (block.is_block_occupied ? bytes_in_use : free_bytes) += block.block_size;
+        if (!block.is_block_occupied)
+        {
+            largest_free_block = std::max(largest_free_block, block.block_size);
+        }
+    }
+
+    ASSERT_EQ(stats.blocks_count, blocks_state.size());
+    ASSERT_EQ(stats.bytes_in_use, bytes_in_use);
+    ASSERT_EQ(stats.free_bytes, free_bytes);
+    ASSERT_EQ(stats.largest_free_block, largest_free_block);
+
+    // Lock-free variant falls back to the walk and keeps no operation counters
+    if constexpr (std::is_same_v<TypeParam, allocator_buddies_system>)
+    {
+        ASSERT_EQ(stats.allocations_count, 100);
+        ASSERT_EQ(stats.deallocations_count, 34);
+        ASSERT_EQ(stats.size_histogram[10], 0);
+    }
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        if (i % 3 != 0)
+        {
+            allocator_instance->deallocate(blocks[i], 1);
+        }
+    }
+
+    stats = utils->get_stats();
+    ASSERT_EQ(stats.blocks_count, 1);
+    ASSERT_EQ(stats.largest_free_block, 1 << 16);
+    ASSERT_EQ(stats.fragmentation(), 0.0);
+}
+
+template<typename T>
+class buddiesSystemStressTests : public testing::Test {};
+TYPED_TEST_SUITE(buddiesSystemStressTests, buddies_allocators);
+
+TYPED_TEST(buddiesSystemStressTests, multithreaded)
+{
+    size_t const threads_count = std::max<size_t>(std::thread::hardware_concurrency(), 4);
+    size_t const iterations = 20000, live_count = 64;
+
+    TypeParam allocator_instance(1 << 24);
+    std::vector<std::vector<unsigned char *>> handed_over(threads_count);
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&allocator_instance, &handed_over, t, iterations, live_count]()
+        {
+            std::vector<std::pair<unsigned char *, size_t>> live(live_count, { nullptr, 0 });
+            unsigned int seed = static_cast<unsigned int>(t);
+
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                auto &[block, size] = live[rand_r(&seed) % live_count];
+                if (block != nullptr)
+                {
+                    // Nobody else may have written into a block while it was ours
+                    for (size_t j = 0; j < size; ++j)
+                    {
+                        ASSERT_EQ(block[j], static_cast<unsigned char>(t));
+                    }
+                    allocator_instance.deallocate(block, 1);
+                }
+
+                size = size_t(1) << (3 + rand_r(&seed) % 9);
+                block = reinterpret_cast<unsigned char *>(allocator_instance.allocate(size));
+                ASSERT_NE(block, nullptr);
+                memset(block, static_cast<int>(t), size);
+            }
+
+            for (auto &[block, size] : live)
+            {
+                handed_over[t].push_back(block);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+
+    // Blocks are freed by a different thread than the one which allocated them
+    for (size_t t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&allocator_instance, &handed_over, t, threads_count]()
+        {
+            for (auto block : handed_over[(t + 1) % threads_count])
+            {
+                allocator_instance.deallocate(block, 1);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto actual_blocks_state = allocator_instance.get_blocks_info();
+    ASSERT_EQ(actual_blocks_state.size(), 1);
+    ASSERT_EQ(actual_blocks_state[0], (allocator_test_utils::block_info{ .block_size = 1 << 24, .is_block_occupied = false }));
+}
+
+TYPED_TEST(falsePositiveTests, test1)
+{
+    ASSERT_THROW(new TypeParam(1), std::logic_error);
+}
+
+TYPED_TEST(falsePositiveTests, test2)
+{
+    std::unique_ptr<smart_mem_resource> allocator(new TypeParam(1 << 16, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    // Header would wrap the size around, so nothing is handed out instead of a small block
+    for (size_t alignment : { size_t(0), size_t(32), size_t(64) })
+    {
+        for (size_t size : { std::numeric_limits<size_t>::max() - 8, std::numeric_limits<size_t>::max() - 70, size_t(1 << 16) })
+        {
+            void *block = nullptr;
+            try
+            {
+                block = alignment == 0 ? allocator->allocate(size) : allocator->allocate(size, alignment);
+            }
+            catch (std::bad_alloc const &)
+            {
+            }
+            ASSERT_EQ(block, nullptr);
+        }
+    }
+
+    auto blocks_state = dynamic_cast<allocator_test_utils *>(allocator.get())->get_blocks_info();
+    ASSERT_EQ(blocks_state.size(), 1);
+    ASSERT_FALSE(blocks_state[0].is_block_occupied);
+}
+
+TYPED_TEST(falsePositiveTests, resizeOverflow)
+{
+    std::unique_ptr<smart_mem_resource> allocator(new TypeParam(1 << 16, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    auto *utils = dynamic_cast<allocator_test_utils *>(allocator.get());
+
+    void *block = allocator->allocate(100);
+    auto blocks_state = utils->get_blocks_info();
+
+    // Header would wrap the new size around or not fit in the space
+    for (size_t size : { std::numeric_limits<size_t>::max() - 8, std::numeric_limits<size_t>::max(), size_t(1 << 16) })
+    {
+        ASSERT_FALSE(allocator->try_resize_in_place(block, size));
+        ASSERT_EQ(utils->get_blocks_info(), blocks_state);
+    }
+
+    allocator->deallocate(block, 1);
+}
+
+TYPED_TEST(falsePositiveTests, hardening)
+{
+    if (!smart_mem_resource::hardened)
+    {
+        GTEST_SKIP() << "Built without MP_OS_ALLOCATOR_HARDENED";
+    }
+
+    TypeParam alloc(4096, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+    auto error_of = [&](std::function<void()> const &action) -> std::string
+    {
+        try
+        {
+            action();
+        }
+        catch (std::logic_error const &error)
+        {
+            return error.what();
+        }
+
+        return "";
+    };
+
+    // Overrun is caught on free and on resize, the block stays allocated
+    auto block = reinterpret_cast<unsigned char *>(alloc.allocate(100));
+    block[100] ^= 1;
+    ASSERT_EQ(error_of([&] { alloc.deallocate(block, 1); }), "[HARDENED] Block overrun, tail canary is corrupted!");
+    ASSERT_EQ(error_of([&] { alloc.try_resize_in_place(block, 50); }), "[HARDENED] Block overrun, tail canary is corrupted!");
+    block[100] ^= 1;
+
+    // Lock-free variant never resizes
+    if constexpr (std::is_same_v<TypeParam, allocator_buddies_system>)
+    {
+        ASSERT_TRUE(alloc.try_resize_in_place(block, 50));
+        block[49] = 1;
+    }
+    alloc.deallocate(block, 1);
+
+    // Freed bytes are poisoned until the allocator hands them out again
+    for (size_t i = 0; i < 32; ++i)
+    {
+        ASSERT_EQ(block[i], smart_mem_resource::poison_byte);
+    }
+
+    ASSERT_EQ(error_of([&] { alloc.deallocate(block, 1); }), "[HARDENED] Double free!");
+    ASSERT_EQ(error_of([&] { alloc.deallocate(block + 16, 1); }), "[HARDENED] Block header is corrupted or the pointer is not a block!");
+
+    auto blocks = alloc.get_blocks_info();
+    ASSERT_EQ(blocks.size(), 1);
+    ASSERT_FALSE(blocks[0].is_block_occupied);
+}
+
+TEST(buddiesSystemConcurrentNegativeTests, test1)
 {
-    ASSERT_THROW(new allocator_buddies_system(1), std::logic_error);
+    // Index of the last block would need the 33rd bit, which the stack heads don't keep
+    ASSERT_THROW(new allocator_buddies_system_concurrent(size_t(1) << 36, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit), std::logic_error);
 }
 
 int main(
@@ -47,6 +47,14 @@ public:
     void do_deallocate_sm(
         void *at) override;
 
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_aligned_sm(
+        void *at,
+        size_t alignment) override;
+
     bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
 
 private:
@@ -6,23 +6,44 @@ allocator_global_heap::allocator_global_heap( logger *logger ) {
 }
 
 [[nodiscard]] void *allocator_global_heap::do_allocate_sm( size_t size ) {
-    debug_with_guard("[GHEAP] Initiated allocation of " + std::to_string(size) + " bytes");
+    debug_with_guard([&] { return "[GHEAP] Initiated allocation of " + std::to_string(size) + " bytes"; });
 
     void* res;
 
     try {
         res = ::operator new(size);
     } catch (std::bad_alloc& e) {
-        error_with_guard("[GHEAP] Unable to allocate " + std::to_string(size) + " bytes");
+        error_with_guard([&] { return "[GHEAP] Unable to allocate " + std::to_string(size) + " bytes"; });
         throw;
     }
-    debug_with_guard("[GHEAP] Successful allocation of " + std::to_string(size) + " bytes");
+    debug_with_guard([&] { return "[GHEAP] Successful allocation of " + std::to_string(size) + " bytes"; });
     return res;
 }
 
 void allocator_global_heap::do_deallocate_sm( void *at ) {
-    debug_with_guard("[GHEAP] Initiated deallocation of area at " + std::to_string(reinterpret_cast<size_t>(at)));
-    ::delete reinterpret_cast<size_t*>(at);
+    debug_with_guard([&] { return "[GHEAP] Initiated deallocation of area at " + std::to_string(reinterpret_cast<size_t>(at)); });
+    ::operator delete(at);
+    debug_with_guard("[GHEAP] Successful deallocation of area");
+}
+
+[[nodiscard]] void *allocator_global_heap::do_allocate_aligned_sm( size_t size, size_t alignment ) {
+    debug_with_guard([&] { return "[GHEAP] Initiated allocation of " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+
+    void* res;
+
+    try {
+        res = ::operator new(size, std::align_val_t(alignment));
+    } catch (std::bad_alloc& e) {
+        error_with_guard([&] { return "[GHEAP] Unable to allocate " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+        throw;
+    }
+    debug_with_guard([&] { return "[GHEAP] Successful allocation of " + std::to_string(size) + " bytes"; });
+    return res;
+}
+
+void allocator_global_heap::do_deallocate_aligned_sm( void *at, size_t alignment ) {
+    debug_with_guard([&] { return "[GHEAP] Initiated deallocation of aligned area at " + std::to_string(reinterpret_cast<size_t>(at)); });
+    ::operator delete(at, std::align_val_t(alignment));
     debug_with_guard("[GHEAP] Successful deallocation of area");
 }
 
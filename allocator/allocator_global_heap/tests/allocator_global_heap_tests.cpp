@@ -77,6 +77,18 @@ TEST(allocatorGlobalHeapTests, test4)
     allocator_instance->deallocate(second_block, 1);
 }
 
+TEST(allocatorGlobalHeapTests, alignedAllocation)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_global_heap);
+
+    for (size_t alignment : { 32, 64, 128, 4096 })
+    {
+        auto block = allocator_instance->allocate(sizeof(double) * 10, alignment);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % alignment, 0);
+        allocator_instance->deallocate(block, sizeof(double) * 10, alignment);
+    }
+}
+
 int main(
     int argc,
     char *argv[])
@@ -6,8 +6,15 @@
 #include <allocator_with_fit_mode.h>
 #include <logger_guardant.h>
 #include <typename_holder.h>
+#include <cstddef>
+#include <limits>
 #include <mutex>
 
+/** Best-fit allocator for large fragmented spaces: free blocks form an intrusive red-black tree
+ *  keyed by (size, address), so every fit mode is one walk down the tree.
+ *  Each node also knows the lowest-addressed block of its subtree, which is what first fit looks for.
+ *  Blocks keep links to their physical neighbours, a block size is the distance to the next one.
+ */
 class allocator_red_black_tree final:
     public smart_mem_resource,
     public allocator_test_utils,
@@ -21,27 +28,53 @@ private:
     enum class block_color : unsigned char
     { RED, BLACK };
 
-    struct block_data
+    // Blocks start at max_align_t boundaries, so the low bits of the previous block address are free for these
+    static constexpr const uintptr_t occupied_flag = 1;
+    static constexpr const uintptr_t red_flag = 2;
+    static constexpr const uintptr_t flags_mask = occupied_flag | red_flag;
+
+    struct block_header
+    {
+        // Physical neighbours, nullptr at the ends of the space
+        uintptr_t prev_and_flags;
+        block_header *next;
+        // Present in free blocks only
+        block_header *parent;
+        block_header *left;
+        block_header *right;
+        // Lowest-addressed block of the subtree rooted here
+        block_header *lowest;
+    };
+
+    struct alignas(std::max_align_t) allocator_metadata
     {
-        bool occupied : 4;
-        block_color color : 4;
+        logger *loggerObj;
+        std::pmr::memory_resource *allocatorObj;
+        allocator_with_fit_mode::fit_mode fitMode;
+        size_t spaceSize;
+        std::mutex globalLock;
+        block_header *root;
+        allocator_test_utils::allocator_stats stats;
     };
 
     void *_trusted_memory;
 
-    static constexpr const size_t allocator_metadata_size = sizeof(logger*) + sizeof(allocator_dbg_helper*) + sizeof(fit_mode) + sizeof(size_t) + sizeof(std::mutex) + sizeof(void*);
-    static constexpr const size_t occupied_block_metadata_size = sizeof(block_data) + 3 * sizeof(void*);
-    static constexpr const size_t free_block_metadata_size = sizeof(block_data) + 5 * sizeof(void*);
+    static constexpr const size_t allocator_metadata_size = sizeof(allocator_metadata);
+    static constexpr const size_t occupied_block_metadata_size = offsetof(block_header, parent);
+    static constexpr const size_t free_block_metadata_size = sizeof(block_header);
+
+    // Largest size whose block, header and padding included, still fits in size_t
+    static constexpr const size_t max_request_size = std::numeric_limits<size_t>::max() - occupied_block_metadata_size - (default_alignment - 1);
 
 public:
     
     ~allocator_red_black_tree() override;
     
     allocator_red_black_tree(
-        allocator_red_black_tree const &other);
+        allocator_red_black_tree const &other) = delete;
     
     allocator_red_black_tree &operator=(
-        allocator_red_black_tree const &other);
+        allocator_red_black_tree const &other) = delete;
     
     allocator_red_black_tree(
         allocator_red_black_tree &&other) noexcept;
@@ -65,9 +98,23 @@ public:
     void do_deallocate_sm(
         void *at) override;
 
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_aligned_sm(
+        void *at,
+        size_t alignment) override;
+
+    bool do_try_resize_in_place_sm(
+        void *at,
+        size_t new_size) override;
+
     bool do_is_equal(const std::pmr::memory_resource&) const noexcept override;
 
     std::vector<allocator_test_utils::block_info> get_blocks_info() const override;
+
+    allocator_test_utils::allocator_stats get_stats() const override;
     
     inline void set_fit_mode(allocator_with_fit_mode::fit_mode mode) override;
 
@@ -79,6 +126,51 @@ private:
 
     inline std::string get_typename() const noexcept override;
 
+    allocator_metadata *metadata() const noexcept;
+
+    block_header *space_begin() const noexcept;
+
+    // Throws std::bad_alloc when the block would not fit in size_t
+    static size_t block_size_for(size_t size);
+
+    size_t block_size(block_header *block) const noexcept;
+
+    static block_header *prev_block(block_header *block) noexcept;
+
+    static void set_prev_block(block_header *block, block_header *prev) noexcept;
+
+    static bool is_occupied(block_header *block) noexcept;
+
+    static void set_occupied(block_header *block, bool occupied) noexcept;
+
+    static block_color color(block_header *block) noexcept;
+
+    static void set_color(block_header *block, block_color color) noexcept;
+
+    // Header of an occupied block of this allocator, throws std::logic_error for anything else
+    block_header *checked_block(void *at);
+
+    // Splits off the tail when it can hold a free block, block must already be out of the tree
+    void *take_block(block_header *block, size_t size);
+
+    block_header *find_free_block(size_t size) const noexcept;
+
+    // (size, address) order of the tree
+    bool tree_less(block_header *a, block_header *b) const noexcept;
+
+    // Recomputes lowest of the node from its children
+    static void update_lowest(block_header *node) noexcept;
+
+    void rotate_left(block_header *x) noexcept;
+
+    void rotate_right(block_header *x) noexcept;
+
+    void tree_insert(block_header *block) noexcept;
+
+    void tree_erase(block_header *block) noexcept;
+
+    void tree_erase_fixup(block_header *x, block_header *parent) noexcept;
+
     class rb_iterator
     {
         void* _block_ptr;
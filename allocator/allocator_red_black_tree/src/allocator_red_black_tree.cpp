@@ -1,22 +1,36 @@
-#include <not_implemented.h>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <bit_utils.h>
 
 #include "../include/allocator_red_black_tree.h"
 
 allocator_red_black_tree::~allocator_red_black_tree()
 {
-    throw not_implemented("allocator_red_black_tree::~allocator_red_black_tree()", "your code should be here...");
+    if (_trusted_memory == nullptr)
+        return;
+
+    auto data = metadata();
+    std::pmr::memory_resource *parent = data->allocatorObj;
+    size_t total_size = allocator_metadata_size + data->spaceSize;
+
+    // Mutex lives inside the memory being released, so it can't be held here
+    data->~allocator_metadata();
+    parent->deallocate(_trusted_memory, total_size, alignof(allocator_metadata));
 }
 
 allocator_red_black_tree::allocator_red_black_tree(
-    allocator_red_black_tree &&other) noexcept
+    allocator_red_black_tree &&other) noexcept : _trusted_memory(std::exchange(other._trusted_memory, nullptr))
 {
-    throw not_implemented("allocator_red_black_tree::allocator_red_black_tree(allocator_red_black_tree &&) noexcept", "your code should be here...");
 }
 
 allocator_red_black_tree &allocator_red_black_tree::operator=(
     allocator_red_black_tree &&other) noexcept
 {
-    throw not_implemented("allocator_red_black_tree &allocator_red_black_tree::operator=(allocator_red_black_tree &&) noexcept", "your code should be here...");
+    if (this != &other)
+        std::swap(_trusted_memory, other._trusted_memory);
+
+    return *this;
 }
 
 allocator_red_black_tree::allocator_red_black_tree(
@@ -25,116 +39,778 @@ allocator_red_black_tree::allocator_red_black_tree(
         logger *logger,
         allocator_with_fit_mode::fit_mode allocate_fit_mode)
 {
-    throw not_implemented("allocator_red_black_tree::allocator_red_black_tree(size_t ,std::pmr::memory_resource *,logger *,allocator_with_fit_mode::fit_mode)", "your code should be here...");
-}
+    if (space_size < free_block_metadata_size)
+        throw std::logic_error("[RB_TREE] Insufficient space");
 
-allocator_red_black_tree::allocator_red_black_tree(const allocator_red_black_tree &other)
-{
-    throw not_implemented("allocator_red_black_tree::allocator_red_black_tree(const allocator_red_black_tree &other)", "your code should be here...");
-}
+    if (parent_allocator == nullptr)
+        parent_allocator = std::pmr::get_default_resource();
 
-allocator_red_black_tree &allocator_red_black_tree::operator=(const allocator_red_black_tree &other)
-{
-    throw not_implemented("allocator_red_black_tree &allocator_red_black_tree::operator=(const allocator_red_black_tree &other)", "your code should be here...");
+    _trusted_memory = parent_allocator->allocate(allocator_metadata_size + space_size, alignof(allocator_metadata));
+
+    auto data = new (_trusted_memory) allocator_metadata();
+    data->loggerObj = logger;
+    data->allocatorObj = parent_allocator;
+    data->fitMode = allocate_fit_mode;
+    data->spaceSize = space_size;
+    data->root = nullptr;
+
+    auto first_block = new (space_begin()) block_header();
+    first_block->next = nullptr;
+    tree_insert(first_block);
+    data->stats.blocks_count = 1;
 }
 
 bool allocator_red_black_tree::do_is_equal(const std::pmr::memory_resource &other) const noexcept
 {
-    throw not_implemented("bool allocator_red_black_tree::do_is_equal(const std::pmr::memory_resource &other) const noexcept", "your code should be here...");
+    return this == &other;
 }
 
 [[nodiscard]] void *allocator_red_black_tree::do_allocate_sm(
     size_t size)
 {
-    throw not_implemented("[[nodiscard]] void *allocator_red_black_tree::do_allocate_sm(size_t)", "your code should be here...");
-}
+    auto data = metadata();
+    auto lock = lock_counting_wait(data->globalLock, data->stats);
+    debug_with_guard([&] { return "[RB_TREE] Allocating " + std::to_string(size) + " bytes"; });
 
+    size_t need = block_size_for(size);
 
+    block_header *block = find_free_block(need);
+    if (block == nullptr)
+    {
+        error_with_guard([&] { return "[RB_TREE] Unable to allocate " + std::to_string(size) + " bytes"; });
+        throw std::bad_alloc();
+    }
+
+    data->stats.on_allocation(size);
+    tree_erase(block);
+
+    return take_block(block, need);
+}
+
+/** Free blocks are merged with both physical neighbours right away,
+ *  so no two free blocks are ever adjacent.
+ */
 void allocator_red_black_tree::do_deallocate_sm(
     void *at)
 {
-    throw not_implemented("void allocator_red_black_tree::do_deallocate_sm(void *)", "your code should be here...");
+    if (at == nullptr)
+        return;
+
+    auto data = metadata();
+    auto lock = lock_counting_wait(data->globalLock, data->stats);
+    debug_with_guard("[RB_TREE] Freeing block");
+
+    block_header *block = checked_block(at);
+
+    data->stats.on_deallocation();
+    set_occupied(block, false);
+
+    block_header *next = block->next;
+    if (next != nullptr && !is_occupied(next))
+    {
+        tree_erase(next);
+        block->next = next->next;
+        if (block->next != nullptr)
+            set_prev_block(block->next, block);
+        --data->stats.blocks_count;
+    }
+
+    block_header *prev = prev_block(block);
+    if (prev != nullptr && !is_occupied(prev))
+    {
+        tree_erase(prev);
+        prev->next = block->next;
+        if (prev->next != nullptr)
+            set_prev_block(prev->next, prev);
+        --data->stats.blocks_count;
+        block = prev;
+    }
+
+    tree_insert(block);
+}
+
+/** Header has to end exactly at an aligned address, so the block is searched with room for the worst padding
+ *  and the gap in front of the header is split off as a separate free block.
+ */
+[[nodiscard]] void *allocator_red_black_tree::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    if ((alignment & (alignment - 1)) != 0)
+        throw std::bad_alloc();
+
+    // Blocks start at max_align_t boundaries, so the plain path is aligned enough
+    if (alignment <= default_alignment)
+        return do_allocate_sm(size);
+
+    auto data = metadata();
+    auto lock = lock_counting_wait(data->globalLock, data->stats);
+    debug_with_guard([&] { return "[RB_TREE] Allocating " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+
+    size_t need = block_size_for(size);
+    if (need > std::numeric_limits<size_t>::max() - alignment - free_block_metadata_size)
+    {
+        error_with_guard([&] { return "[RB_TREE] Unable to allocate " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+        throw std::bad_alloc();
+    }
+
+    block_header *block = find_free_block(need + alignment + free_block_metadata_size);
+    if (block == nullptr)
+    {
+        error_with_guard([&] { return "[RB_TREE] Unable to allocate " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+        throw std::bad_alloc();
+    }
+
+    data->stats.on_allocation(size);
+    tree_erase(block);
+
+    auto block_addr = reinterpret_cast<uintptr_t>(block);
+    uintptr_t payload = __detail::round_up(block_addr + occupied_block_metadata_size, alignment);
+    size_t gap = payload - occupied_block_metadata_size - block_addr;
+
+    // Leading block must at least fit its own free header
+    if (gap != 0 && gap < free_block_metadata_size)
+        gap += alignment;
+
+    if (gap != 0)
+    {
+        // Leading part stays free and the aligned tail is the one being allocated
+        auto tail = new (reinterpret_cast<void *>(block_addr + gap)) block_header();
+        set_prev_block(tail, block);
+        tail->next = block->next;
+        if (tail->next != nullptr)
+            set_prev_block(tail->next, tail);
+        block->next = tail;
+        ++data->stats.blocks_count;
+
+        tree_insert(block);
+        block = tail;
+    }
+
+    return take_block(block, need);
+}
+
+// Header always sits right before the payload, padding lives in a separate free block
+void allocator_red_black_tree::do_deallocate_aligned_sm(
+    void *at,
+    size_t /* alignment */)
+{
+    do_deallocate_sm(at);
+}
+
+/** Growing absorbs the physically next block when it is free and the sum is big enough,
+ *  the leftover goes back to the tree as one free block, just like on allocation.
+ */
+bool allocator_red_black_tree::do_try_resize_in_place_sm(
+    void *at,
+    size_t new_size)
+{
+    auto data = metadata();
+    auto lock = lock_counting_wait(data->globalLock, data->stats);
+    debug_with_guard([&] { return "[RB_TREE] Resizing block to " + std::to_string(new_size) + " bytes"; });
+
+    block_header *block = checked_block(at);
+    if (new_size > max_request_size)
+        return false;
+
+    size_t need = block_size_for(new_size);
+
+    block_header *next = block->next;
+    bool next_free = next != nullptr && !is_occupied(next);
+
+    if (need > block_size(block) + (next_free ? block_size(next) : 0))
+        return false;
+
+    if (next_free)
+    {
+        tree_erase(next);
+        block->next = next->next;
+        if (block->next != nullptr)
+            set_prev_block(block->next, block);
+        --data->stats.blocks_count;
+    }
+
+    take_block(block, need);
+
+    return true;
 }
 
 void allocator_red_black_tree::set_fit_mode(allocator_with_fit_mode::fit_mode mode)
 {
-    throw not_implemented("void allocator_red_black_tree::set_fit_mode(allocator_with_fit_mode::fit_mode)", "your code should be here...");
+    std::lock_guard lock(metadata()->globalLock);
+    metadata()->fitMode = mode;
 }
 
 
 std::vector<allocator_test_utils::block_info> allocator_red_black_tree::get_blocks_info() const
 {
-    throw not_implemented("std::vector<allocator_test_utils::block_info> allocator_red_black_tree::get_blocks_info() const", "your code should be here...");
+    std::lock_guard lock(metadata()->globalLock);
+
+    return get_blocks_info_inner();
+}
+
+// Largest free block is the rightmost node of the tree
+allocator_test_utils::allocator_stats allocator_red_black_tree::get_stats() const
+{
+    auto data = metadata();
+    std::lock_guard lock(data->globalLock);
+
+    allocator_test_utils::allocator_stats stats = data->stats;
+    stats.bytes_in_use = data->spaceSize - stats.free_bytes;
+
+    block_header *node = data->root;
+    while (node != nullptr && node->right != nullptr)
+        node = node->right;
+
+    stats.largest_free_block = node == nullptr ? 0 : block_size(node);
+
+    return stats;
 }
 
 inline logger *allocator_red_black_tree::get_logger() const
 {
-    throw not_implemented("inline logger *allocator_red_black_tree::get_logger() const", "your code should be here...");
+    return metadata()->loggerObj;
 }
 
 std::vector<allocator_test_utils::block_info> allocator_red_black_tree::get_blocks_info_inner() const
 {
-    throw not_implemented("std::vector<allocator_test_utils::block_info> allocator_red_black_tree::get_blocks_info_inner() const", "your code should be here...");
+    std::vector<allocator_test_utils::block_info> out;
+
+    for (auto it = begin(), stop = end(); it != stop; ++it)
+        out.push_back({ it.size(), it.occupied() });
+
+    return out;
 }
 
 inline std::string allocator_red_black_tree::get_typename() const noexcept
 {
-    throw not_implemented("inline std::string allocator_red_black_tree::get_typename() const noexcept", "your code should be here...");
+    return "allocator_red_black_tree";
+}
+
+allocator_red_black_tree::allocator_metadata *allocator_red_black_tree::metadata() const noexcept
+{
+    return reinterpret_cast<allocator_metadata *>(_trusted_memory);
+}
+
+allocator_red_black_tree::block_header *allocator_red_black_tree::space_begin() const noexcept
+{
+    return reinterpret_cast<block_header *>(reinterpret_cast<uintptr_t>(_trusted_memory) + allocator_metadata_size);
+}
+
+// Every block has to be able to turn into a tree node once it is freed
+size_t allocator_red_black_tree::block_size_for(size_t size)
+{
+    if (size > max_request_size)
+        throw std::bad_alloc();
+
+    return std::max(
+        occupied_block_metadata_size + __detail::round_up(size, default_alignment),
+        __detail::round_up(free_block_metadata_size, default_alignment));
+}
+
+size_t allocator_red_black_tree::block_size(block_header *block) const noexcept
+{
+    auto end = block->next != nullptr
+        ? reinterpret_cast<uintptr_t>(block->next)
+        : reinterpret_cast<uintptr_t>(space_begin()) + metadata()->spaceSize;
+
+    return end - reinterpret_cast<uintptr_t>(block);
+}
+
+void *allocator_red_black_tree::take_block(
+    block_header *block,
+    size_t size)
+{
+    // Remainder has to hold a free header, otherwise it stays inside this block
+    if (block_size(block) >= size + free_block_metadata_size)
+    {
+        auto rest = new (reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(block) + size)) block_header();
+        set_prev_block(rest, block);
+        rest->next = block->next;
+        if (rest->next != nullptr)
+            set_prev_block(rest->next, rest);
+        block->next = rest;
+        ++metadata()->stats.blocks_count;
+
+        tree_insert(rest);
+    }
+
+    set_occupied(block, true);
+
+    return reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(block) + occupied_block_metadata_size);
+}
+
+/** Best fit is the lower bound of the size, worst fit is the rightmost node.
+ *  First fit wants the lowest address among all blocks big enough: once a node fits, so does its whole
+ *  right subtree, whose lowest block is already known, and only the left subtree is left to look at.
+ */
+allocator_red_black_tree::block_header *allocator_red_black_tree::find_free_block(size_t size) const noexcept
+{
+    auto data = metadata();
+    block_header *node = data->root;
+
+    switch (data->fitMode)
+    {
+        case allocator_with_fit_mode::fit_mode::first_fit:
+        {
+            block_header *found = nullptr;
+            while (node != nullptr)
+            {
+                if (block_size(node) >= size)
+                {
+                    found = found == nullptr ? node : std::min(found, node);
+                    if (node->right != nullptr)
+                        found = std::min(found, node->right->lowest);
+                    node = node->left;
+                }
+                else
+                    node = node->right;
+            }
+
+            return found;
+        }
+
+        case allocator_with_fit_mode::fit_mode::the_best_fit:
+        {
+            block_header *found = nullptr;
+            while (node != nullptr)
+            {
+                if (block_size(node) >= size)
+                {
+                    found = node;
+                    node = node->left;
+                }
+                else
+                    node = node->right;
+            }
+
+            return found;
+        }
+
+        case allocator_with_fit_mode::fit_mode::the_worst_fit:
+            while (node != nullptr && node->right != nullptr)
+                node = node->right;
+
+            return node != nullptr && block_size(node) >= size ? node : nullptr;
+    }
+
+    return nullptr;
+}
+
+allocator_red_black_tree::block_header *allocator_red_black_tree::prev_block(block_header *block) noexcept
+{
+    return reinterpret_cast<block_header *>(block->prev_and_flags & ~flags_mask);
+}
+
+void allocator_red_black_tree::set_prev_block(
+    block_header *block,
+    block_header *prev) noexcept
+{
+    block->prev_and_flags = reinterpret_cast<uintptr_t>(prev) | (block->prev_and_flags & flags_mask);
+}
+
+allocator_red_black_tree::block_header *allocator_red_black_tree::checked_block(void *at)
+{
+    auto space = reinterpret_cast<uintptr_t>(space_begin());
+    auto addr = reinterpret_cast<uintptr_t>(at);
+    auto block = reinterpret_cast<block_header *>(addr - occupied_block_metadata_size);
+
+    // Neighbour links of a real block always point back at it
+    if (addr < space + occupied_block_metadata_size || addr >= space + metadata()->spaceSize
+        || (addr - space) % default_alignment != 0 || !is_occupied(block)
+        || (prev_block(block) == nullptr ? block != space_begin() : prev_block(block)->next != block)
+        || (block->next != nullptr && prev_block(block->next) != block))
+    {
+        error_with_guard("[RB_TREE] Invalid block pointer");
+        throw std::logic_error("[RB_TREE] Invalid block pointer!");
+    }
+
+    return block;
+}
+
+bool allocator_red_black_tree::is_occupied(block_header *block) noexcept
+{
+    return block->prev_and_flags & occupied_flag;
+}
+
+void allocator_red_black_tree::set_occupied(
+    block_header *block,
+    bool occupied) noexcept
+{
+    block->prev_and_flags = occupied ? block->prev_and_flags | occupied_flag : block->prev_and_flags & ~occupied_flag;
+}
+
+allocator_red_black_tree::block_color allocator_red_black_tree::color(block_header *block) noexcept
+{
+    return block->prev_and_flags & red_flag ? block_color::RED : block_color::BLACK;
+}
+
+void allocator_red_black_tree::set_color(
+    block_header *block,
+    block_color color) noexcept
+{
+    block->prev_and_flags = color == block_color::RED ? block->prev_and_flags | red_flag : block->prev_and_flags & ~red_flag;
+}
+
+bool allocator_red_black_tree::tree_less(
+    block_header *a,
+    block_header *b) const noexcept
+{
+    size_t a_size = block_size(a);
+    size_t b_size = block_size(b);
+
+    return a_size < b_size || (a_size == b_size && a < b);
+}
+
+void allocator_red_black_tree::update_lowest(block_header *node) noexcept
+{
+    node->lowest = node;
+    if (node->left != nullptr)
+        node->lowest = std::min(node->lowest, node->left->lowest);
+    if (node->right != nullptr)
+        node->lowest = std::min(node->lowest, node->right->lowest);
+}
+
+// Subtree of x keeps the same nodes, so only x and y need their lowest recomputed
+void allocator_red_black_tree::rotate_left(block_header *x) noexcept
+{
+    block_header *y = x->right;
+
+    x->right = y->left;
+    if (y->left != nullptr)
+        y->left->parent = x;
+
+    y->parent = x->parent;
+    if (x->parent == nullptr)
+        metadata()->root = y;
+    else if (x == x->parent->left)
+        x->parent->left = y;
+    else
+        x->parent->right = y;
+
+    y->left = x;
+    x->parent = y;
+
+    update_lowest(x);
+    update_lowest(y);
+}
+
+void allocator_red_black_tree::rotate_right(block_header *x) noexcept
+{
+    block_header *y = x->left;
+
+    x->left = y->right;
+    if (y->right != nullptr)
+        y->right->parent = x;
+
+    y->parent = x->parent;
+    if (x->parent == nullptr)
+        metadata()->root = y;
+    else if (x == x->parent->right)
+        x->parent->right = y;
+    else
+        x->parent->left = y;
+
+    y->right = x;
+    x->parent = y;
+
+    update_lowest(x);
+    update_lowest(y);
+}
+
+void allocator_red_black_tree::tree_insert(block_header *block) noexcept
+{
+    auto data = metadata();
+
+    set_occupied(block, false);
+    set_color(block, block_color::RED);
+    block->left = nullptr;
+    block->right = nullptr;
+    block->parent = nullptr;
+    block->lowest = block;
+
+    ++data->stats.free_blocks_count;
+    data->stats.free_bytes += block_size(block);
+
+    block_header **link = &data->root;
+    while (*link != nullptr)
+    {
+        block->parent = *link;
+        link = tree_less(block, *link) ? &(*link)->left : &(*link)->right;
+    }
+    *link = block;
+
+    for (block_header *node = block->parent; node != nullptr; node = node->parent)
+        node->lowest = std::min(node->lowest, block);
+
+    block_header *z = block;
+    while (z->parent != nullptr && color(z->parent) == block_color::RED)
+    {
+        // Red parent is never the root, so the grandparent exists
+        block_header *grandparent = z->parent->parent;
+
+        if (z->parent == grandparent->left)
+        {
+            block_header *uncle = grandparent->right;
+            if (uncle != nullptr && color(uncle) == block_color::RED)
+            {
+                set_color(z->parent, block_color::BLACK);
+                set_color(uncle, block_color::BLACK);
+                set_color(grandparent, block_color::RED);
+                z = grandparent;
+                continue;
+            }
+
+            if (z == z->parent->right)
+            {
+                z = z->parent;
+                rotate_left(z);
+            }
+
+            set_color(z->parent, block_color::BLACK);
+            set_color(grandparent, block_color::RED);
+            rotate_right(grandparent);
+        }
+        else
+        {
+            block_header *uncle = grandparent->left;
+            if (uncle != nullptr && color(uncle) == block_color::RED)
+            {
+                set_color(z->parent, block_color::BLACK);
+                set_color(uncle, block_color::BLACK);
+                set_color(grandparent, block_color::RED);
+                z = grandparent;
+                continue;
+            }
+
+            if (z == z->parent->left)
+            {
+                z = z->parent;
+                rotate_right(z);
+            }
+
+            set_color(z->parent, block_color::BLACK);
+            set_color(grandparent, block_color::RED);
+            rotate_left(grandparent);
+        }
+    }
+
+    set_color(data->root, block_color::BLACK);
+}
+
+void allocator_red_black_tree::tree_erase(block_header *block) noexcept
+{
+    auto data = metadata();
+
+    --data->stats.free_blocks_count;
+    data->stats.free_bytes -= block_size(block);
+
+    auto transplant = [data](block_header *u, block_header *v)
+    {
+        if (u->parent == nullptr)
+            data->root = v;
+        else if (u == u->parent->left)
+            u->parent->left = v;
+        else
+            u->parent->right = v;
+
+        if (v != nullptr)
+            v->parent = u->parent;
+    };
+
+    block_color removed_color = color(block);
+    block_header *x;
+    block_header *x_parent;
+
+    if (block->left == nullptr)
+    {
+        x = block->right;
+        x_parent = block->parent;
+        transplant(block, block->right);
+    }
+    else if (block->right == nullptr)
+    {
+        x = block->left;
+        x_parent = block->parent;
+        transplant(block, block->left);
+    }
+    else
+    {
+        block_header *successor = block->right;
+        while (successor->left != nullptr)
+            successor = successor->left;
+
+        removed_color = color(successor);
+        x = successor->right;
+
+        if (successor->parent == block)
+            x_parent = successor;
+        else
+        {
+            x_parent = successor->parent;
+            transplant(successor, successor->right);
+            successor->right = block->right;
+            successor->right->parent = successor;
+        }
+
+        transplant(block, successor);
+        successor->left = block->left;
+        successor->left->parent = successor;
+        set_color(successor, color(block));
+    }
+
+    // Everything above the lowest changed link may have lost its lowest block
+    for (block_header *node = x_parent; node != nullptr; node = node->parent)
+        update_lowest(node);
+
+    if (removed_color == block_color::BLACK)
+        tree_erase_fixup(x, x_parent);
+}
+
+// Empty leaves are nullptr, so the parent of x is passed along explicitly
+void allocator_red_black_tree::tree_erase_fixup(
+    block_header *x,
+    block_header *parent) noexcept
+{
+    auto is_black = [](block_header *node) { return node == nullptr || color(node) == block_color::BLACK; };
+    auto data = metadata();
+
+    while (x != data->root && is_black(x))
+    {
+        if (x == parent->left)
+        {
+            block_header *sibling = parent->right;
+            if (!is_black(sibling))
+            {
+                set_color(sibling, block_color::BLACK);
+                set_color(parent, block_color::RED);
+                rotate_left(parent);
+                sibling = parent->right;
+            }
+
+            if (is_black(sibling->left) && is_black(sibling->right))
+            {
+                set_color(sibling, block_color::RED);
+                x = parent;
+                parent = x->parent;
+                continue;
+            }
+
+            if (is_black(sibling->right))
+            {
+                set_color(sibling->left, block_color::BLACK);
+                set_color(sibling, block_color::RED);
+                rotate_right(sibling);
+                sibling = parent->right;
+            }
+
+            set_color(sibling, color(parent));
+            set_color(parent, block_color::BLACK);
+            set_color(sibling->right, block_color::BLACK);
+            rotate_left(parent);
+            x = data->root;
+        }
+        else
+        {
+            block_header *sibling = parent->left;
+            if (!is_black(sibling))
+            {
+                set_color(sibling, block_color::BLACK);
+                set_color(parent, block_color::RED);
+                rotate_right(parent);
+                sibling = parent->left;
+            }
+
+            if (is_black(sibling->left) && is_black(sibling->right))
+            {
+                set_color(sibling, block_color::RED);
+                x = parent;
+                parent = x->parent;
+                continue;
+            }
+
+            if (is_black(sibling->left))
+            {
+                set_color(sibling->right, block_color::BLACK);
+                set_color(sibling, block_color::RED);
+                rotate_left(sibling);
+                sibling = parent->left;
+            }
+
+            set_color(sibling, color(parent));
+            set_color(parent, block_color::BLACK);
+            set_color(sibling->left, block_color::BLACK);
+            rotate_right(parent);
+            x = data->root;
+        }
+    }
+
+    if (x != nullptr)
+        set_color(x, block_color::BLACK);
 }
 
 
 allocator_red_black_tree::rb_iterator allocator_red_black_tree::begin() const noexcept
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator allocator_red_black_tree::begin() const noexcept", "your code should be here...");
+    return rb_iterator(_trusted_memory);
 }
 
 allocator_red_black_tree::rb_iterator allocator_red_black_tree::end() const noexcept
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator allocator_red_black_tree::end() const noexcept", "your code should be here...");
+    return rb_iterator();
 }
 
 
 bool allocator_red_black_tree::rb_iterator::operator==(const allocator_red_black_tree::rb_iterator &other) const noexcept
 {
-    throw not_implemented("bool allocator_red_black_tree::rb_iterator::operator==(const allocator_red_black_tree::rb_iterator &) const noexcept", "your code should be here...");
+    return _block_ptr == other._block_ptr;
 }
 
 bool allocator_red_black_tree::rb_iterator::operator!=(const allocator_red_black_tree::rb_iterator &other) const noexcept
 {
-    throw not_implemented("bool allocator_red_black_tree::rb_iterator::operator!=(const allocator_red_black_tree::rb_iterator &) const noexcept", "your code should be here...");
+    return !(*this == other);
 }
 
 allocator_red_black_tree::rb_iterator &allocator_red_black_tree::rb_iterator::operator++() & noexcept
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator &allocator_red_black_tree::rb_iterator::operator++() & noexcept", "your code should be here...");
+    _block_ptr = reinterpret_cast<block_header *>(_block_ptr)->next;
+
+    return *this;
 }
 
 allocator_red_black_tree::rb_iterator allocator_red_black_tree::rb_iterator::operator++(int n)
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator allocator_red_black_tree::rb_iterator::operator++(int)", "your code should be here...");
+    auto copy = *this;
+    ++*this;
+
+    return copy;
 }
 
 size_t allocator_red_black_tree::rb_iterator::size() const noexcept
 {
-    throw not_implemented("size_t allocator_red_black_tree::rb_iterator::size() const noexcept", "your code should be here...");
+    auto block = reinterpret_cast<block_header *>(_block_ptr);
+    auto end = block->next != nullptr
+        ? reinterpret_cast<uintptr_t>(block->next)
+        : reinterpret_cast<uintptr_t>(_trusted) + allocator_metadata_size + reinterpret_cast<allocator_metadata *>(_trusted)->spaceSize;
+
+    return end - reinterpret_cast<uintptr_t>(block);
 }
 
 void *allocator_red_black_tree::rb_iterator::operator*() const noexcept
 {
-    throw not_implemented("void *allocator_red_black_tree::rb_iterator::operator*() const noexcept", "your code should be here...");
+    return _block_ptr;
 }
 
-allocator_red_black_tree::rb_iterator::rb_iterator()
+allocator_red_black_tree::rb_iterator::rb_iterator() : _block_ptr(nullptr), _trusted(nullptr)
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator::rb_iterator()", "your code should be here...");
 }
 
 allocator_red_black_tree::rb_iterator::rb_iterator(void *trusted)
+    : _block_ptr(reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(trusted) + allocator_metadata_size)), _trusted(trusted)
 {
-    throw not_implemented("allocator_red_black_tree::rb_iterator::rb_iterator(void *)", "your code should be here...");
 }
 
 bool allocator_red_black_tree::rb_iterator::occupied() const noexcept
 {
-    throw not_implemented("bool allocator_red_black_tree::rb_iterator::occupied() const noexcept", "your code should be here...");
+    return is_occupied(reinterpret_cast<block_header *>(_block_ptr));
 }
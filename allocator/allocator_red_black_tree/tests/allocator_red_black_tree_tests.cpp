@@ -1,8 +1,12 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <logger.h>
 #include <logger_builder.h>
 #include <client_logger_builder.h>
 #include <list>
+#include <cstring>
+#include <functional>
+#include <limits>
 #include <allocator_red_black_tree.h>
 
 logger *create_logger(
@@ -55,7 +59,8 @@ TEST(allocatorRBTPositiveTests, test1)
 													}
 												}));
 
-	std::unique_ptr<smart_mem_resource> alloc(new allocator_red_black_tree(3000, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
+	// First fit reuses the freed block at the front, so the third block has to fit in the tail, canaries of hardened builds included
+	std::unique_ptr<smart_mem_resource> alloc(new allocator_red_black_tree(3100 + 3 * smart_mem_resource::hardened_overhead, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
 
 	auto first_block = reinterpret_cast<int *>(alloc->allocate(sizeof(int) * 250));
 
@@ -220,6 +225,342 @@ TEST(allocatorRBTPositiveTests, test7)
 }
 
 
+TEST(allocatorRBTPositiveTests, fitModes)
+{
+	for (auto mode : { allocator_with_fit_mode::fit_mode::first_fit,
+					   allocator_with_fit_mode::fit_mode::the_best_fit,
+					   allocator_with_fit_mode::fit_mode::the_worst_fit })
+	{
+		std::unique_ptr<smart_mem_resource> allocator(new allocator_red_black_tree(4096, nullptr, nullptr, mode));
+
+		// Holes of three different sizes separated by occupied blocks, the tail is the biggest free block
+		void *small = allocator->allocate(100);
+		void *guard1 = allocator->allocate(50);
+		void *large = allocator->allocate(300);
+		void *guard2 = allocator->allocate(50);
+		void *medium = allocator->allocate(200);
+		void *guard3 = allocator->allocate(50);
+
+		allocator->deallocate(small, 1);
+		allocator->deallocate(large, 1);
+		allocator->deallocate(medium, 1);
+
+		// Too big for the small hole, so first and best fit disagree
+		void *block = allocator->allocate(150);
+		memset(block, 0xAB, 150);
+
+		switch (mode)
+		{
+			case allocator_with_fit_mode::fit_mode::the_best_fit:
+				ASSERT_EQ(block, medium);
+				break;
+			case allocator_with_fit_mode::fit_mode::the_worst_fit:
+				ASSERT_GT(block, guard3);
+				break;
+			default:
+				ASSERT_EQ(block, large);
+				break;
+		}
+
+		allocator->deallocate(block, 1);
+		allocator->deallocate(guard1, 1);
+		allocator->deallocate(guard2, 1);
+		allocator->deallocate(guard3, 1);
+
+		auto blocks = dynamic_cast<allocator_test_utils *>(allocator.get())->get_blocks_info();
+		ASSERT_EQ(blocks.size(), 1);
+		ASSERT_EQ(blocks[0], (allocator_test_utils::block_info{ .block_size = 4096, .is_block_occupied = false }));
+	}
+}
+
+TEST(allocatorRBTPositiveTests, firstFitAddressOrder)
+{
+	std::unique_ptr<smart_mem_resource> allocator(new allocator_red_black_tree(1 << 14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+	// Holes of mixed sizes at increasing addresses, each one followed by an occupied guard
+	std::vector<size_t> hole_sizes { 64, 256, 160, 960, 320, 640, 128, 800 };
+	std::vector<void *> holes, guards;
+	for (size_t size : hole_sizes)
+	{
+		holes.push_back(allocator->allocate(size));
+		guards.push_back(allocator->allocate(32));
+	}
+
+	for (void *hole : holes)
+	{
+		allocator->deallocate(hole, 1);
+	}
+
+	// Lowest-addressed hole big enough is taken, whatever its size
+	for (size_t size : { 10, 100, 200, 300, 500, 900 })
+	{
+		auto expected = std::find_if(hole_sizes.begin(), hole_sizes.end(), [size](size_t hole_size) { return hole_size >= size; });
+		void *block = allocator->allocate(size);
+		ASSERT_EQ(block, holes[expected - hole_sizes.begin()]);
+		allocator->deallocate(block, 1);
+	}
+
+	void *block = allocator->allocate(1000);
+	ASSERT_GT(block, guards.back());
+	allocator->deallocate(block, 1);
+
+	for (void *guard : guards)
+	{
+		allocator->deallocate(guard, 1);
+	}
+
+	ASSERT_EQ(dynamic_cast<allocator_test_utils *>(allocator.get())->get_blocks_info().size(), 1);
+}
+
+TEST(allocatorRBTPositiveTests, coalescing)
+{
+	for (auto mode : { allocator_with_fit_mode::fit_mode::first_fit,
+					   allocator_with_fit_mode::fit_mode::the_best_fit,
+					   allocator_with_fit_mode::fit_mode::the_worst_fit })
+	{
+		std::unique_ptr<smart_mem_resource> allocator(new allocator_red_black_tree(1 << 16, nullptr, nullptr, mode));
+		auto *utils = dynamic_cast<allocator_test_utils *>(allocator.get());
+		std::vector<void *> blocks;
+		srand(0);
+
+		for (size_t i = 0; i < 5000; ++i)
+		{
+			if (blocks.empty() || rand() % 3 != 0)
+			{
+				try
+				{
+					void *block = rand() % 5 == 0
+						? allocator->allocate(1 + rand() % 300, 64)
+						: allocator->allocate(1 + rand() % 300);
+					blocks.push_back(block);
+				}
+				catch (std::bad_alloc const &)
+				{
+				}
+				continue;
+			}
+
+			auto it = blocks.begin() + rand() % blocks.size();
+			allocator->deallocate(*it, 1);
+			blocks.erase(it);
+
+			// Free neighbours are always merged and the blocks cover the whole space
+			size_t total = 0;
+			bool previous_free = false;
+			for (auto const &block : utils->get_blocks_info())
+			{
+				ASSERT_FALSE(previous_free && !block.is_block_occupied);
+				previous_free = !block.is_block_occupied;
+				total += block.block_size;
+			}
+			ASSERT_EQ(total, 1 << 16);
+		}
+
+		for (void *block : blocks)
+		{
+			allocator->deallocate(block, 1);
+		}
+
+		auto stats = utils->get_stats();
+		ASSERT_EQ(stats.blocks_count, 1);
+		ASSERT_EQ(stats.free_bytes, 1 << 16);
+		ASSERT_EQ(stats.largest_free_block, 1 << 16);
+		ASSERT_EQ(stats.allocations_count, stats.deallocations_count);
+	}
+}
+
+TEST(allocatorRBTPositiveTests, alignedAllocation)
+{
+	std::unique_ptr<smart_mem_resource> allocator(new allocator_red_black_tree(8192, nullptr, nullptr, allocator_with_fit_mode::fit_mode::the_best_fit));
+	std::vector<std::pair<void *, size_t>> blocks;
+
+	for (size_t alignment : { 8, 16, 64, 256 })
+	{
+		for (size_t size : { 1, 24, 100 })
+		{
+			void *block = allocator->allocate(size, alignment);
+			ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % alignment, 0);
+			memset(block, 0xAB, size);
+			blocks.emplace_back(block, alignment);
+		}
+	}
+
+	for (auto &[block, alignment] : blocks)
+	{
+		allocator->deallocate(block, 1, alignment);
+	}
+
+	auto blocks_state = dynamic_cast<allocator_test_utils *>(allocator.get())->get_blocks_info();
+	ASSERT_EQ(blocks_state.size(), 1);
+}
+
+TEST(allocatorRBTPositiveTests, resizeInPlace)
+{
+	std::unique_ptr<smart_mem_resource> allocator(new allocator_red_black_tree(1 << 14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+	auto *utils = dynamic_cast<allocator_test_utils *>(allocator.get());
+
+	void *first = allocator->allocate(100);
+	void *second = allocator->allocate(100);
+	void *third = allocator->allocate(100);
+	allocator->deallocate(second, 1);
+
+	// Free neighbour is absorbed, the occupied block behind it stops the growth
+	ASSERT_TRUE(allocator->try_resize_in_place(first, 200));
+	ASSERT_FALSE(allocator->try_resize_in_place(first, 400));
+	ASSERT_TRUE(allocator->try_resize_in_place(first, 20));
+	ASSERT_TRUE(allocator->try_resize_in_place(third, 1000));
+	ASSERT_FALSE(allocator->try_resize_in_place(third, 1 << 15));
+	ASSERT_FALSE(allocator->try_resize_in_place(third, 100, 64));
+
+	allocator->deallocate(first, 1);
+	allocator->deallocate(third, 1);
+	ASSERT_EQ(utils->get_blocks_info().size(), 1);
+
+	// Contents up to the smaller of both sizes survive, other blocks are never touched
+	std::vector<std::pair<unsigned char *, size_t>> blocks;
+	srand(0);
+
+	auto check = [](unsigned char *block, size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			ASSERT_EQ(block[i], static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block) >> 4));
+		}
+	};
+
+	for (size_t i = 0; i < 3000; ++i)
+	{
+		switch (blocks.empty() ? 0 : rand() % 3)
+		{
+			case 0:
+				try
+				{
+					size_t size = 1 + rand() % 300;
+					auto block = reinterpret_cast<unsigned char *>(allocator->allocate(size));
+					memset(block, static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block) >> 4), size);
+					blocks.emplace_back(block, size);
+				}
+				catch (std::bad_alloc const &)
+				{
+				}
+				break;
+			case 1:
+			{
+				auto it = blocks.begin() + rand() % blocks.size();
+				check(it->first, it->second);
+				allocator->deallocate(it->first, 1);
+				blocks.erase(it);
+				break;
+			}
+			case 2:
+			{
+				auto &[block, size] = blocks[rand() % blocks.size()];
+				size_t new_size = 1 + rand() % 600;
+				if (allocator->try_resize_in_place(block, new_size))
+				{
+					check(block, std::min(size, new_size));
+					memset(block, static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block) >> 4), new_size);
+					size = new_size;
+				}
+				break;
+			}
+		}
+	}
+
+	for (auto &[block, size] : blocks)
+	{
+		check(block, size);
+		allocator->deallocate(block, 1);
+	}
+
+	auto stats = utils->get_stats();
+	ASSERT_EQ(stats.blocks_count, 1);
+	ASSERT_EQ(stats.free_bytes, 1 << 14);
+}
+
+TEST(allocatorRBTNegativeTests, test1)
+{
+	std::unique_ptr<smart_mem_resource> allocator(new allocator_red_black_tree(3000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+	void *block = allocator->allocate(100);
+	allocator->deallocate(block, 1);
+
+	ASSERT_THROW(allocator->deallocate(block, 1), std::logic_error);
+	ASSERT_THROW(static_cast<void>(allocator->allocate(5000)), std::bad_alloc);
+
+	// Header and padding would wrap the block size around
+	ASSERT_THROW(static_cast<void>(allocator->allocate(std::numeric_limits<size_t>::max() - 8)), std::bad_alloc);
+	ASSERT_THROW(static_cast<void>(allocator->allocate(std::numeric_limits<size_t>::max() - 8, 64)), std::bad_alloc);
+	ASSERT_EQ(dynamic_cast<allocator_test_utils *>(allocator.get())->get_blocks_info().size(), 1);
+}
+
+TEST(allocatorRBTNegativeTests, resizeOverflow)
+{
+	std::unique_ptr<smart_mem_resource> allocator(new allocator_red_black_tree(1 << 14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+	auto *utils = dynamic_cast<allocator_test_utils *>(allocator.get());
+
+	void *block = allocator->allocate(100);
+	auto blocks_state = utils->get_blocks_info();
+
+	// Header and padding would wrap the new block size around
+	for (size_t size : { std::numeric_limits<size_t>::max() - 8, std::numeric_limits<size_t>::max() })
+	{
+		ASSERT_FALSE(allocator->try_resize_in_place(block, size));
+		ASSERT_EQ(utils->get_blocks_info(), blocks_state);
+	}
+
+	allocator->deallocate(block, 1);
+}
+
+TEST(allocatorRBTNegativeTests, hardening)
+{
+	if (!smart_mem_resource::hardened)
+	{
+		GTEST_SKIP() << "Built without MP_OS_ALLOCATOR_HARDENED";
+	}
+
+	allocator_red_black_tree alloc(3000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit);
+
+	auto error_of = [&](std::function<void()> const &action) -> std::string
+	{
+		try
+		{
+			action();
+		}
+		catch (std::logic_error const &error)
+		{
+			return error.what();
+		}
+
+		return "";
+	};
+
+	// Overrun is caught on free and on resize, the block stays allocated
+	auto block = reinterpret_cast<unsigned char *>(alloc.allocate(100));
+	block[100] ^= 1;
+	ASSERT_EQ(error_of([&] { alloc.deallocate(block, 1); }), "[HARDENED] Block overrun, tail canary is corrupted!");
+	ASSERT_EQ(error_of([&] { alloc.try_resize_in_place(block, 50); }), "[HARDENED] Block overrun, tail canary is corrupted!");
+	block[100] ^= 1;
+
+	ASSERT_TRUE(alloc.try_resize_in_place(block, 50));
+	block[49] = 1;
+	alloc.deallocate(block, 1);
+
+	// Freed bytes are poisoned until the allocator hands them out again, the tree node of the free block covers the first ones
+	for (size_t i = 16; i < 48; ++i)
+	{
+		ASSERT_EQ(block[i], smart_mem_resource::poison_byte);
+	}
+
+	// Tree node overwrites the hardened header, so a double free is caught by either layer
+	ASSERT_THROW(alloc.deallocate(block, 1), std::logic_error);
+	ASSERT_EQ(error_of([&] { alloc.deallocate(block + 16, 1); }), "[HARDENED] Block header is corrupted or the pointer is not a block!");
+
+	auto blocks = alloc.get_blocks_info();
+	ASSERT_EQ(blocks.size(), 1);
+	ASSERT_FALSE(blocks[0].is_block_occupied);
+}
+
 int main(
     int argc,
     char *argv[])
@@ -0,0 +1,127 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_SLAB_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_SLAB_H
+
+#include <pp_allocator.h>
+#include <allocator_test_utils.h>
+#include <logger_guardant.h>
+#include <typename_holder.h>
+#include <array>
+#include <mutex>
+#include <utility>
+
+/** Fixed size classes, each served from slabs of slab_size bytes taken from the parent resource.
+ *  Slabs are aligned to their size, so the owning slab of a pointer is found by masking its address.
+ *  Requests above the largest class get a slab of their own.
+ */
+class allocator_slab final:
+    public smart_mem_resource,
+    public allocator_test_utils,
+    private logger_guardant,
+    private typename_holder
+{
+
+private:
+
+    static constexpr const std::array<size_t, 12> size_classes = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024 };
+
+    static constexpr const size_t large_class = size_classes.size();
+
+    static constexpr const size_t min_slab_size = 4096;
+
+    struct slab_metadata;
+
+    struct free_slot
+    {
+        free_slot *next;
+    };
+
+    struct alignas(std::max_align_t) slab_header
+    {
+        slab_metadata *owner;
+        slab_header *next;
+        slab_header *prev;
+        slab_header *next_partial;
+        slab_header *prev_partial;
+        free_slot *free_list;
+        size_t size_class;
+        size_t slot_size;
+        size_t slots_count;
+        size_t used;
+    };
+
+    struct slab_metadata
+    {
+        logger *loggerObj;
+        std::pmr::memory_resource *allocatorObj;
+        size_t slabSize;
+        std::mutex globalLock;
+        slab_header *slabs;
+        std::array<slab_header *, size_classes.size()> partial;
+    };
+
+    static constexpr const size_t slab_header_size = sizeof(slab_header);
+
+    void *_trusted_memory;
+
+public:
+
+    explicit allocator_slab(
+        size_t slab_size = min_slab_size,
+        std::pmr::memory_resource *parent_allocator = nullptr,
+        logger *logger = nullptr);
+
+    allocator_slab(
+        allocator_slab const &other) = delete;
+
+    allocator_slab &operator=(
+        allocator_slab const &other) = delete;
+
+    allocator_slab(
+        allocator_slab &&other) noexcept;
+
+    allocator_slab &operator=(
+        allocator_slab &&other) noexcept;
+
+    ~allocator_slab() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    // Slots never move, so a block can only change its size within its slot
+    bool do_try_resize_in_place_sm(
+        void *at,
+        size_t new_size) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info() const override;
+
+private:
+
+    std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
+
+    static size_t size_to_class(size_t size) noexcept;
+
+    slab_header *create_slab(size_t size_class, size_t slot_size, size_t total_size);
+
+    void release_slab(slab_header *slab);
+
+    void push_partial(slab_header *slab) noexcept;
+
+    void remove_partial(slab_header *slab) noexcept;
+
+    slab_header *slab_of(void *at) const noexcept;
+
+    std::mutex &mutex() const noexcept;
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATOR_SLAB_H
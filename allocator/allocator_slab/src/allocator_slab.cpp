@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <bit_utils.h>
+#include <limits>
+#include "../include/allocator_slab.h"
+
+allocator_slab::allocator_slab(
+    size_t slab_size,
+    std::pmr::memory_resource *parent_allocator,
+    logger *logger)
+{
+    if (slab_size < min_slab_size || (slab_size & (slab_size - 1)) != 0)
+        throw std::logic_error("[SLAB] Slab size must be a power of two not less than " + std::to_string(min_slab_size));
+
+    if (parent_allocator == nullptr)
+        parent_allocator = std::pmr::get_default_resource();
+
+    _trusted_memory = parent_allocator->allocate(sizeof(slab_metadata), alignof(slab_metadata));
+
+    auto data = new (_trusted_memory) slab_metadata();
+    data->loggerObj = logger;
+    data->allocatorObj = parent_allocator;
+    data->slabSize = slab_size;
+    data->slabs = nullptr;
+    data->partial.fill(nullptr);
+}
+
+allocator_slab::allocator_slab(
+    allocator_slab &&other) noexcept : _trusted_memory(std::exchange(other._trusted_memory, nullptr))
+{
+}
+
+allocator_slab &allocator_slab::operator=(
+    allocator_slab &&other) noexcept
+{
+    if (this != &other)
+        std::swap(_trusted_memory, other._trusted_memory);
+
+    return *this;
+}
+
+allocator_slab::~allocator_slab()
+{
+    if (_trusted_memory == nullptr)
+        return;
+
+    auto data = reinterpret_cast<slab_metadata *>(_trusted_memory);
+
+    while (data->slabs != nullptr)
+    {
+        release_slab(data->slabs);
+    }
+
+    std::pmr::memory_resource *parent = data->allocatorObj;
+    data->~slab_metadata();
+    parent->deallocate(_trusted_memory, sizeof(slab_metadata), alignof(slab_metadata));
+}
+
+[[nodiscard]] void *allocator_slab::do_allocate_sm(
+    size_t size)
+{
+    std::lock_guard lock(mutex());
+    auto data = reinterpret_cast<slab_metadata *>(_trusted_memory);
+
+    size_t size_class = size_to_class(size);
+
+    if (size_class == large_class)
+    {
+        debug_with_guard([&] { return "[SLAB] Allocating " + std::to_string(size) + " bytes in a dedicated slab"; });
+
+        if (size > std::numeric_limits<size_t>::max() - slab_header_size)
+        {
+            error_with_guard([&] { return "[SLAB] Unable to allocate " + std::to_string(size) + " bytes"; });
+            throw std::bad_alloc();
+        }
+
+        slab_header *slab = create_slab(large_class, size, slab_header_size + size);
+        slab->used = 1;
+        return reinterpret_cast<char *>(slab) + slab_header_size;
+    }
+
+    slab_header *slab = data->partial[size_class];
+    if (slab == nullptr)
+    {
+        debug_with_guard([&] { return "[SLAB] New slab for " + std::to_string(size_classes[size_class]) + " bytes class"; });
+
+        slab = create_slab(size_class, size_classes[size_class], data->slabSize);
+        push_partial(slab);
+    }
+
+    free_slot *slot = slab->free_list;
+    slab->free_list = slot->next;
+
+    if (++slab->used == slab->slots_count)
+        remove_partial(slab);
+
+    return slot;
+}
+
+void allocator_slab::do_deallocate_sm(
+    void *at)
+{
+    if (at == nullptr)
+        return;
+
+    std::lock_guard lock(mutex());
+
+    slab_header *slab = slab_of(at);
+    if (slab == nullptr)
+    {
+        error_with_guard("[SLAB] Invalid deallocation");
+        throw std::logic_error("[SLAB] Invalid deallocation!");
+    }
+
+    if (slab->size_class == large_class)
+    {
+        release_slab(slab);
+        return;
+    }
+
+    auto slot = reinterpret_cast<free_slot *>(at);
+    slot->next = slab->free_list;
+    slab->free_list = slot;
+
+    if (slab->used-- == slab->slots_count)
+        push_partial(slab);
+
+    // Keep a single empty slab per class around to avoid thrashing the parent resource
+    if (slab->used == 0 && (slab->next_partial != nullptr || slab->prev_partial != nullptr))
+    {
+        debug_with_guard([&] { return "[SLAB] Returning empty slab of " + std::to_string(slab->slot_size) + " bytes class"; });
+
+        remove_partial(slab);
+        release_slab(slab);
+    }
+}
+
+bool allocator_slab::do_try_resize_in_place_sm(
+    void *at,
+    size_t new_size)
+{
+    std::lock_guard lock(mutex());
+
+    slab_header *slab = slab_of(at);
+    if (slab == nullptr)
+    {
+        error_with_guard("[SLAB] Invalid resize");
+        throw std::logic_error("[SLAB] Invalid resize!");
+    }
+
+    return new_size <= slab->slot_size;
+}
+
+bool allocator_slab::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+std::vector<allocator_test_utils::block_info> allocator_slab::get_blocks_info() const
+{
+    std::lock_guard lock(mutex());
+
+    return get_blocks_info_inner();
+}
+
+std::vector<allocator_test_utils::block_info> allocator_slab::get_blocks_info_inner() const
+{
+    auto data = reinterpret_cast<slab_metadata *>(_trusted_memory);
+    std::vector<allocator_test_utils::block_info> res;
+
+    for (slab_header *slab = data->slabs; slab != nullptr; slab = slab->next)
+    {
+        if (slab->size_class == large_class)
+        {
+            res.push_back({ .block_size = slab->slot_size, .is_block_occupied = true });
+            continue;
+        }
+
+        auto first_slot = reinterpret_cast<char *>(slab) + slab_header_size;
+        std::vector<bool> occupied(slab->slots_count, true);
+
+        for (free_slot *slot = slab->free_list; slot != nullptr; slot = slot->next)
+        {
+            occupied[(reinterpret_cast<char *>(slot) - first_slot) / slab->slot_size] = false;
+        }
+
+        for (bool is_occupied : occupied)
+        {
+            res.push_back({ .block_size = slab->slot_size, .is_block_occupied = is_occupied });
+        }
+    }
+
+    return res;
+}
+
+size_t allocator_slab::size_to_class(size_t size) noexcept
+{
+    return __detail::size_class_table<16, size_classes>::of(size);
+}
+
+allocator_slab::slab_header *allocator_slab::create_slab(
+    size_t size_class,
+    size_t slot_size,
+    size_t total_size)
+{
+    auto data = reinterpret_cast<slab_metadata *>(_trusted_memory);
+
+    void *memory;
+    try
+    {
+        memory = data->allocatorObj->allocate(total_size, data->slabSize);
+    }
+    catch (std::bad_alloc const &)
+    {
+        memory = nullptr;
+    }
+
+    if (memory == nullptr)
+    {
+        error_with_guard([&] { return "[SLAB] Parent allocator is unable to provide " + std::to_string(total_size) + " bytes"; });
+        throw std::bad_alloc();
+    }
+
+    auto slab = new (memory) slab_header();
+    slab->owner = data;
+    slab->size_class = size_class;
+    slab->slot_size = slot_size;
+    slab->slots_count = size_class == large_class ? 1 : (total_size - slab_header_size) / slot_size;
+
+    if (size_class != large_class)
+    {
+        // Slots are linked in address order, so a fresh slab is handed out sequentially
+        auto first_slot = reinterpret_cast<char *>(slab) + slab_header_size;
+        for (size_t i = slab->slots_count; i-- > 0;)
+        {
+            auto slot = reinterpret_cast<free_slot *>(first_slot + i * slot_size);
+            slot->next = slab->free_list;
+            slab->free_list = slot;
+        }
+    }
+
+    slab->next = data->slabs;
+    if (data->slabs != nullptr)
+        data->slabs->prev = slab;
+    data->slabs = slab;
+
+    return slab;
+}
+
+void allocator_slab::release_slab(
+    slab_header *slab)
+{
+    auto data = reinterpret_cast<slab_metadata *>(_trusted_memory);
+
+    if (slab->prev != nullptr)
+        slab->prev->next = slab->next;
+    else
+        data->slabs = slab->next;
+
+    if (slab->next != nullptr)
+        slab->next->prev = slab->prev;
+
+    size_t total_size = slab->size_class == large_class ? slab_header_size + slab->slot_size : data->slabSize;
+    data->allocatorObj->deallocate(slab, total_size, data->slabSize);
+}
+
+void allocator_slab::push_partial(
+    slab_header *slab) noexcept
+{
+    auto data = reinterpret_cast<slab_metadata *>(_trusted_memory);
+    slab_header *&head = data->partial[slab->size_class];
+
+    slab->prev_partial = nullptr;
+    slab->next_partial = head;
+    if (head != nullptr)
+        head->prev_partial = slab;
+    head = slab;
+}
+
+void allocator_slab::remove_partial(
+    slab_header *slab) noexcept
+{
+    auto data = reinterpret_cast<slab_metadata *>(_trusted_memory);
+
+    if (slab->prev_partial != nullptr)
+        slab->prev_partial->next_partial = slab->next_partial;
+    else
+        data->partial[slab->size_class] = slab->next_partial;
+
+    if (slab->next_partial != nullptr)
+        slab->next_partial->prev_partial = slab->prev_partial;
+
+    slab->next_partial = slab->prev_partial = nullptr;
+}
+
+allocator_slab::slab_header *allocator_slab::slab_of(
+    void *at) const noexcept
+{
+    auto data = reinterpret_cast<slab_metadata *>(_trusted_memory);
+    auto slab = reinterpret_cast<slab_header *>(reinterpret_cast<uintptr_t>(at) & ~(uintptr_t(data->slabSize) - 1));
+
+    return slab->owner == data ? slab : nullptr;
+}
+
+std::mutex &allocator_slab::mutex() const noexcept
+{
+    return reinterpret_cast<slab_metadata *>(_trusted_memory)->globalLock;
+}
+
+inline logger *allocator_slab::get_logger() const
+{
+    return reinterpret_cast<slab_metadata *>(_trusted_memory)->loggerObj;
+}
+
+inline std::string allocator_slab::get_typename() const
+{
+    return "allocator_slab";
+}
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+#include <allocator_slab.h>
+#include <client_logger_builder.h>
+#include <cstring>
+#include <limits>
+#include <list>
+
+logger *create_logger(
+    std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
+    bool use_console_stream = true,
+    logger::severity console_stream_severity = logger::severity::debug)
+{
+    std::unique_ptr<logger_builder> logger_builder_instance(new client_logger_builder);
+
+    if (use_console_stream)
+    {
+        logger_builder_instance->add_console_stream(console_stream_severity);
+    }
+
+    for (auto &output_file_stream_setup: output_file_streams_setup)
+    {
+        logger_builder_instance->add_file_stream(output_file_stream_setup.first, output_file_stream_setup.second);
+    }
+
+    logger *logger_instance = logger_builder_instance->build();
+
+    return logger_instance;
+}
+
+TEST(allocatorSlabPositiveTests, test1)
+{
+    std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
+        {
+            {
+                "allocator_slab_tests_positive_test1.txt",
+                logger::severity::debug
+            }
+        }, false));
+
+    allocator_slab subject(4096, nullptr, logger_instance.get());
+
+    auto first_block = reinterpret_cast<int *>(subject.allocate(sizeof(int) * 10));
+    auto second_block = reinterpret_cast<int *>(subject.allocate(sizeof(int) * 10));
+
+    ASSERT_NE(first_block, second_block);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(first_block) % alignof(std::max_align_t), 0);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        first_block[i] = i;
+        second_block[i] = -i;
+    }
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(first_block[i], i);
+        ASSERT_EQ(second_block[i], -i);
+    }
+
+    subject.deallocate(first_block, 1);
+
+    // Freed slot is the first one handed out again
+    auto third_block = reinterpret_cast<int *>(subject.allocate(sizeof(int) * 10));
+    ASSERT_EQ(first_block, third_block);
+
+    subject.deallocate(third_block, 1);
+    subject.deallocate(second_block, 1);
+}
+
+TEST(allocatorSlabPositiveTests, test2)
+{
+    allocator_slab subject(4096);
+
+    // Sizes of the blocks the allocator sees, canaries of hardened builds included
+    auto first_block = subject.allocate(60 - smart_mem_resource::hardened_overhead);
+    auto second_block = subject.allocate(64 - smart_mem_resource::hardened_overhead);
+    auto third_block = subject.allocate(200 - smart_mem_resource::hardened_overhead);
+
+    auto blocks = subject.get_blocks_info();
+
+    size_t occupied_64 = 0, free_64 = 0, occupied_256 = 0;
+    for (auto const &block : blocks)
+    {
+        if (block.block_size == 64)
+            (block.is_block_occupied ? occupied_64 : free_64)++;
+        else if (block.block_size == 256 && block.is_block_occupied)
+            ++occupied_256;
+    }
+
+    ASSERT_EQ(occupied_64, 2);
+    ASSERT_GT(free_64, 0);
+    ASSERT_EQ(occupied_256, 1);
+
+    subject.deallocate(first_block, 1);
+    subject.deallocate(second_block, 1);
+    subject.deallocate(third_block, 1);
+
+    for (auto const &block : subject.get_blocks_info())
+    {
+        ASSERT_FALSE(block.is_block_occupied);
+    }
+}
+
+TEST(allocatorSlabPositiveTests, test3)
+{
+    allocator_slab subject(4096);
+
+    // Larger than any size class and than the slab itself
+    auto large_block = reinterpret_cast<char *>(subject.allocate(10000));
+    memset(large_block, 'a', 10000);
+
+    auto blocks = subject.get_blocks_info();
+    ASSERT_EQ(blocks.size(), 1);
+    ASSERT_EQ(blocks[0].block_size, 10000 + smart_mem_resource::hardened_overhead);
+    ASSERT_TRUE(blocks[0].is_block_occupied);
+
+    subject.deallocate(large_block, 1);
+
+    ASSERT_TRUE(subject.get_blocks_info().empty());
+}
+
+TEST(allocatorSlabPositiveTests, test4)
+{
+    allocator_slab subject(8192);
+
+    std::list<void *> allocated_blocks;
+    srand(0);
+
+    for (size_t iterations_count = 0; iterations_count < 20000; ++iterations_count)
+    {
+        if (allocated_blocks.empty() || rand() % 2 == 0)
+        {
+            // Every block keeps its size in the first word
+            size_t size = std::max(sizeof(size_t), size_t(1 + rand() % 1500));
+            auto block = reinterpret_cast<unsigned char *>(subject.allocate(size));
+            memset(block, static_cast<int>(size & 0xFF), size);
+            *reinterpret_cast<size_t *>(block) = size;
+            allocated_blocks.push_back(block);
+        }
+        else
+        {
+            auto it = allocated_blocks.begin();
+            std::advance(it, rand() % allocated_blocks.size());
+            auto block = reinterpret_cast<unsigned char *>(*it);
+            size_t size = *reinterpret_cast<size_t *>(block);
+            if (size > sizeof(size_t))
+            {
+                ASSERT_EQ(block[size - 1], static_cast<unsigned char>(size & 0xFF));
+            }
+            subject.deallocate(block, 1);
+            allocated_blocks.erase(it);
+        }
+    }
+
+    for (auto block : allocated_blocks)
+    {
+        subject.deallocate(block, 1);
+    }
+
+    for (auto const &block : subject.get_blocks_info())
+    {
+        ASSERT_FALSE(block.is_block_occupied);
+    }
+}
+
+TEST(allocatorSlabPositiveTests, resizeInPlace)
+{
+    allocator_slab subject(4096);
+
+    // Block may change its size only within the slot of its class, canaries of hardened builds take a bigger one
+    size_t slot = smart_mem_resource::hardened ? 48 : 32;
+    void *block = subject.allocate(20);
+    ASSERT_TRUE(subject.try_resize_in_place(block, slot - smart_mem_resource::hardened_overhead));
+    ASSERT_TRUE(subject.try_resize_in_place(block, 1));
+    ASSERT_FALSE(subject.try_resize_in_place(block, slot - smart_mem_resource::hardened_overhead + 1));
+
+    void *large_block = subject.allocate(10000);
+    ASSERT_TRUE(subject.try_resize_in_place(large_block, 5000));
+    ASSERT_FALSE(subject.try_resize_in_place(large_block, 10001));
+
+    subject.deallocate(block, 1);
+    subject.deallocate(large_block, 1);
+}
+
+TEST(allocatorSlabNegativeTests, test1)
+{
+    ASSERT_THROW(allocator_slab(1000), std::logic_error);
+    ASSERT_THROW(allocator_slab(5000), std::logic_error);
+}
+
+TEST(allocatorSlabNegativeTests, test2)
+{
+    allocator_slab first(4096);
+    allocator_slab second(4096);
+
+    auto block = first.allocate(32);
+
+    ASSERT_THROW(second.deallocate(block, 1), std::logic_error);
+
+    first.deallocate(block, 1);
+}
+
+TEST(allocatorSlabNegativeTests, test3)
+{
+    allocator_slab subject(4096);
+
+    // Size of the dedicated slab would wrap around
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max() - 16)), std::bad_alloc);
+
+    // Rounding to the size class granule would wrap around into the smallest class
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max())), std::bad_alloc);
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max() - 8)), std::bad_alloc);
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
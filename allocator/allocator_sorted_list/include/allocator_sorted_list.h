@@ -6,9 +6,15 @@
 #include <allocator_with_fit_mode.h>
 #include <logger_guardant.h>
 #include <typename_holder.h>
+#include <cstddef>
 #include <iterator>
+#include <limits>
 #include <mutex>
 
+/** Free blocks form a doubly linked list kept in address order, so first fit stays close to the start of the space.
+ *  A free block repeats its size in its last word and the block after it has prev_free_flag set,
+ *  so freeing finds and merges both physical neighbours without walking the list.
+ */
 class allocator_sorted_list final:
     public smart_mem_resource,
     public allocator_test_utils,
@@ -18,12 +24,49 @@ class allocator_sorted_list final:
 {
 
 private:
-    
+
+    // Block sizes are multiples of max_align_t, so the low bits of the size are free for these
+    static constexpr const size_t occupied_flag = 1;
+    static constexpr const size_t prev_free_flag = 2;
+    static constexpr const size_t flags_mask = alignof(std::max_align_t) - 1;
+
+    struct block_header
+    {
+        size_t size_and_flags;
+        union
+        {
+            void *trusted;              // while occupied
+            block_header *next_free;    // while free
+        };
+        // Present in free blocks only
+        block_header *prev_free;
+    };
+
+    struct alignas(std::max_align_t) allocator_metadata
+    {
+        logger *loggerObj;
+        std::pmr::memory_resource *allocatorObj;
+        allocator_with_fit_mode::fit_mode fitMode;
+        size_t spaceSize;
+        std::mutex globalLock;
+        block_header *freeHead;
+        block_header *freeTail;
+        // stats.largest_free_block only grows in mark_free, taking or shrinking a block of that size sets the flag
+        bool largestFreeStale;
+        allocator_test_utils::allocator_stats stats;
+    };
+
     void *_trusted_memory;
 
-    static constexpr const size_t allocator_metadata_size = sizeof(logger*) + sizeof(std::pmr::memory_resource *) + sizeof(fit_mode) + sizeof(size_t) + sizeof(std::mutex) + sizeof(void*);
+    static constexpr const size_t allocator_metadata_size = sizeof(allocator_metadata);
 
-    static constexpr const size_t block_metadata_size = sizeof(void*) + sizeof(size_t);
+    static constexpr const size_t block_metadata_size = offsetof(block_header, prev_free);
+
+    // Free block keeps both links and the footer
+    static constexpr const size_t min_block_size = sizeof(block_header) + sizeof(size_t);
+
+    // Largest size whose block, header and padding included, still fits in size_t
+    static constexpr const size_t max_request_size = std::numeric_limits<size_t>::max() - block_metadata_size - (alignof(std::max_align_t) - 1);
 
 public:
 
@@ -34,10 +77,10 @@ public:
             allocator_with_fit_mode::fit_mode allocate_fit_mode = allocator_with_fit_mode::fit_mode::first_fit);
     
     allocator_sorted_list(
-        allocator_sorted_list const &other);
+        allocator_sorted_list const &other) = delete;
     
     allocator_sorted_list &operator=(
-        allocator_sorted_list const &other);
+        allocator_sorted_list const &other) = delete;
 
     allocator_sorted_list(
         allocator_sorted_list &&other) noexcept;
@@ -53,6 +96,27 @@ public:
     void do_deallocate_sm(
         void *at) override;
 
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_aligned_sm(
+        void *at,
+        size_t alignment) override;
+
+    bool do_try_resize_in_place_sm(
+        void *at,
+        size_t new_size) override;
+
+    void do_allocate_batch_sm(
+        size_t size,
+        size_t count,
+        void **out) override;
+
+    void do_deallocate_batch_sm(
+        void *const *ptrs,
+        size_t count) override;
+
     bool do_is_equal(const std::pmr::memory_resource&) const noexcept override;
     
     inline void set_fit_mode(
@@ -60,6 +124,8 @@ public:
 
     std::vector<allocator_test_utils::block_info> get_blocks_info() const noexcept override;
 
+    allocator_test_utils::allocator_stats get_stats() const override;
+
 private:
 
     std::vector<allocator_test_utils::block_info> get_blocks_info_inner() const override;
@@ -68,6 +134,47 @@ private:
     
     inline std::string get_typename() const override;
 
+    allocator_metadata *metadata() const noexcept;
+
+    block_header *space_begin() const noexcept;
+
+    // Throws std::bad_alloc when the block would not fit in size_t
+    static size_t block_size_for(size_t size);
+
+    static size_t block_size(block_header *block) noexcept;
+
+    static void set_block_size(block_header *block, size_t size) noexcept;
+
+    static void set_flag(block_header *block, size_t flag, bool value) noexcept;
+
+    block_header *next_block(block_header *block) const noexcept;
+
+    // Header of an occupied block of this allocator, throws std::logic_error for anything else
+    block_header *checked_block(void *at);
+
+    // Writes the footer and tells the next block its predecessor is free
+    void mark_free(block_header *block) noexcept;
+
+    // Called before a free block is taken or cut, it may have been the largest one
+    void on_free_block_shrink(block_header *block) noexcept;
+
+    void link_after(block_header *prev, block_header *block) noexcept;
+
+    void unlink(block_header *block) noexcept;
+
+    void replace(block_header *old_block, block_header *new_block) noexcept;
+
+    // Links a block with no free neighbours right before the next free block in address order
+    void link_in_order(block_header *block) noexcept;
+
+    // Caller holds globalLock, block is occupied
+    void free_block(block_header *block);
+
+    // Block has to be in the free list, the split off tail takes its place there
+    void *take_block(block_header *block, size_t size);
+
+    block_header *find_free_block(size_t size) const noexcept;
+
     class sorted_free_iterator
     {
         void* _free_ptr;
@@ -1,190 +1,761 @@
-#include <not_implemented.h>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <bit_utils.h>
 #include "../include/allocator_sorted_list.h"
 
 allocator_sorted_list::~allocator_sorted_list()
 {
-    throw not_implemented("allocator_sorted_list::~allocator_sorted_list()", "your code should be here...");
+    if (_trusted_memory == nullptr)
+        return;
+
+    auto data = metadata();
+    std::pmr::memory_resource *parent = data->allocatorObj;
+    size_t total_size = allocator_metadata_size + data->spaceSize;
+
+    // Mutex lives inside the memory being released, so it can't be held here
+    data->~allocator_metadata();
+    parent->deallocate(_trusted_memory, total_size, alignof(allocator_metadata));
 }
 
 allocator_sorted_list::allocator_sorted_list(
-    allocator_sorted_list &&other) noexcept
+    allocator_sorted_list &&other) noexcept : _trusted_memory(std::exchange(other._trusted_memory, nullptr))
 {
-    throw not_implemented("allocator_sorted_list::allocator_sorted_list(allocator_sorted_list &&) noexcept", "your code should be here...");
 }
 
 allocator_sorted_list &allocator_sorted_list::operator=(
     allocator_sorted_list &&other) noexcept
 {
-    throw not_implemented("allocator_sorted_list &allocator_sorted_list::operator=(allocator_sorted_list &&) noexcept", "your code should be here...");
+    if (this != &other)
+        std::swap(_trusted_memory, other._trusted_memory);
+
+    return *this;
 }
 
+/** Space is rounded up to max_align_t, so that every block size leaves room for the flags.
+ */
 allocator_sorted_list::allocator_sorted_list(
         size_t space_size,
         std::pmr::memory_resource *parent_allocator,
         logger *logger,
         allocator_with_fit_mode::fit_mode allocate_fit_mode)
 {
-    throw not_implemented("allocator_sorted_list::allocator_sorted_list(size_t, std::pmr::memory_resource *,logger *,allocator_with_fit_mode::fit_mode)", "your code should be here...");
+    space_size = __detail::round_up(space_size, alignof(std::max_align_t));
+    if (space_size < min_block_size)
+        throw std::logic_error("[SORTED_LIST] Insufficient space");
+
+    if (parent_allocator == nullptr)
+        parent_allocator = std::pmr::get_default_resource();
+
+    _trusted_memory = parent_allocator->allocate(allocator_metadata_size + space_size, alignof(allocator_metadata));
+
+    auto data = new (_trusted_memory) allocator_metadata();
+    data->loggerObj = logger;
+    data->allocatorObj = parent_allocator;
+    data->fitMode = allocate_fit_mode;
+    data->spaceSize = space_size;
+    data->freeHead = nullptr;
+    data->freeTail = nullptr;
+    data->largestFreeStale = false;
+
+    auto first_block = new (space_begin()) block_header();
+    first_block->size_and_flags = space_size;
+    link_after(nullptr, first_block);
+    mark_free(first_block);
+
+    data->stats.blocks_count = 1;
+    data->stats.free_blocks_count = 1;
+    data->stats.free_bytes = space_size;
 }
 
 [[nodiscard]] void *allocator_sorted_list::do_allocate_sm(
     size_t size)
 {
-    throw not_implemented("[[nodiscard]] void *allocator_sorted_list::do_allocate_sm(size_t)", "your code should be here...");
-}
+    auto data = metadata();
+    auto lock = lock_counting_wait(data->globalLock, data->stats);
+    debug_with_guard([&] { return "[SORTED_LIST] Allocating " + std::to_string(size) + " bytes"; });
 
-allocator_sorted_list::allocator_sorted_list(const allocator_sorted_list &other)
-{
-    throw not_implemented("allocator_sorted_list::allocator_sorted_list(const allocator_sorted_list &other)", "your code should be here...");
-}
+    size_t need = block_size_for(size);
 
-allocator_sorted_list &allocator_sorted_list::operator=(const allocator_sorted_list &other)
-{
-    throw not_implemented("allocator_sorted_list &allocator_sorted_list::operator=(const allocator_sorted_list &other)", "your code should be here...");
+    block_header *block = find_free_block(need);
+    if (block == nullptr)
+    {
+        error_with_guard([&] { return "[SORTED_LIST] Unable to allocate " + std::to_string(size) + " bytes"; });
+        throw std::bad_alloc();
+    }
+
+    data->stats.on_allocation(size);
+
+    return take_block(block, need);
 }
 
 bool allocator_sorted_list::do_is_equal(const std::pmr::memory_resource &other) const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::do_is_equal(const std::pmr::memory_resource &other) const noexcept", "your code should be here...");
+    return this == &other;
 }
 
 void allocator_sorted_list::do_deallocate_sm(
     void *at)
 {
-    throw not_implemented("void allocator_sorted_list::do_deallocate_sm(void *)", "your code should be here...");
+    if (at == nullptr)
+        return;
+
+    auto data = metadata();
+    auto lock = lock_counting_wait(data->globalLock, data->stats);
+    debug_with_guard("[SORTED_LIST] Freeing block");
+
+    free_block(checked_block(at));
+}
+
+/** Whole batch is carved out of one free block when there is one big enough, the blocks are then consecutive.
+ *  Otherwise every block is searched for on its own, still under a single lock.
+ */
+void allocator_sorted_list::do_allocate_batch_sm(
+    size_t size,
+    size_t count,
+    void **out)
+{
+    if (count == 0)
+        return;
+
+    auto data = metadata();
+    auto lock = lock_counting_wait(data->globalLock, data->stats);
+    debug_with_guard([&] { return "[SORTED_LIST] Allocating " + std::to_string(count) + " blocks of " + std::to_string(size) + " bytes"; });
+
+    size_t need = block_size_for(size);
+
+    block_header *block = need <= data->spaceSize / count ? find_free_block(need * count) : nullptr;
+    if (block != nullptr)
+    {
+        // Split off tail is the next block to take, it has already replaced the taken one in the list
+        for (size_t i = 0; i < count; ++i)
+        {
+            data->stats.on_allocation(size);
+            out[i] = take_block(block, need);
+            block = next_block(block);
+        }
+
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        block = find_free_block(need);
+        if (block == nullptr)
+        {
+            error_with_guard([&] { return "[SORTED_LIST] Unable to allocate " + std::to_string(count) + " blocks of " + std::to_string(size) + " bytes"; });
+
+            for (size_t j = 0; j < i; ++j)
+                free_block(checked_block(out[j]));
+
+            throw std::bad_alloc();
+        }
+
+        data->stats.on_allocation(size);
+        out[i] = take_block(block, need);
+    }
+}
+
+void allocator_sorted_list::do_deallocate_batch_sm(
+    void *const *ptrs,
+    size_t count)
+{
+    auto data = metadata();
+    auto lock = lock_counting_wait(data->globalLock, data->stats);
+    debug_with_guard([&] { return "[SORTED_LIST] Freeing " + std::to_string(count) + " blocks"; });
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (ptrs[i] != nullptr)
+            free_block(checked_block(ptrs[i]));
+    }
+}
+
+/** Physical neighbours are found through the header and the footer of the previous block,
+ *  only a block with no free neighbour walks forward over occupied blocks to find its place in the list.
+ */
+void allocator_sorted_list::free_block(block_header *block)
+{
+    auto data = metadata();
+
+    data->stats.on_deallocation();
+    data->stats.free_bytes += block_size(block);
+    ++data->stats.free_blocks_count;
+    set_flag(block, occupied_flag, false);
+
+    block_header *next = next_block(block);
+    bool next_free = next != nullptr && !(next->size_and_flags & occupied_flag);
+
+    block_header *prev = nullptr;
+    if (block->size_and_flags & prev_free_flag)
+    {
+        size_t prev_size = *reinterpret_cast<size_t *>(reinterpret_cast<uintptr_t>(block) - sizeof(size_t));
+        prev = reinterpret_cast<block_header *>(reinterpret_cast<uintptr_t>(block) - prev_size);
+    }
+
+    if (prev != nullptr)
+    {
+        // Previous block is already in the list right before the next free one
+        if (next_free)
+        {
+            unlink(next);
+            set_block_size(block, block_size(block) + block_size(next));
+            --data->stats.blocks_count;
+            --data->stats.free_blocks_count;
+        }
+
+        set_block_size(prev, block_size(prev) + block_size(block));
+        --data->stats.blocks_count;
+        --data->stats.free_blocks_count;
+        block = prev;
+    }
+    else if (next_free)
+    {
+        replace(next, block);
+        set_block_size(block, block_size(block) + block_size(next));
+        --data->stats.blocks_count;
+        --data->stats.free_blocks_count;
+    }
+    else
+    {
+        link_in_order(block);
+    }
+
+    mark_free(block);
+}
+
+/** Growing takes the front of the physically next block when it is free, the rest stays in its list node.
+ *  A shrunk tail joins the next free block or, with an occupied neighbour, becomes a new free block.
+ */
+bool allocator_sorted_list::do_try_resize_in_place_sm(
+    void *at,
+    size_t new_size)
+{
+    auto data = metadata();
+    auto lock = lock_counting_wait(data->globalLock, data->stats);
+    debug_with_guard([&] { return "[SORTED_LIST] Resizing block to " + std::to_string(new_size) + " bytes"; });
+
+    block_header *block = checked_block(at);
+
+    if (new_size > max_request_size)
+        return false;
+
+    size_t need = block_size_for(new_size);
+    size_t size = block_size(block);
+
+    block_header *next = next_block(block);
+    bool next_free = next != nullptr && !(next->size_and_flags & occupied_flag);
+    size_t available = size + (next_free ? block_size(next) : 0);
+
+    if (need > available)
+        return false;
+
+    if (next_free)
+    {
+        on_free_block_shrink(next);
+        data->stats.free_bytes -= block_size(next);
+
+        if (available - need >= min_block_size)
+        {
+            // Header of the rest may overlap the one of next, so the list node is saved first
+            block_header node = *next;
+            auto rest = new (reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(block) + need)) block_header();
+            rest->size_and_flags = available - need;
+            replace(&node, rest);
+            mark_free(rest);
+
+            set_block_size(block, need);
+            data->stats.free_bytes += block_size(rest);
+        }
+        else
+        {
+            unlink(next);
+            set_block_size(block, available);
+
+            block_header *following = next_block(block);
+            if (following != nullptr)
+                set_flag(following, prev_free_flag, false);
+
+            --data->stats.blocks_count;
+            --data->stats.free_blocks_count;
+        }
+    }
+    else if (size - need >= min_block_size)
+    {
+        auto rest = new (reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(block) + need)) block_header();
+        rest->size_and_flags = size - need;
+        set_block_size(block, need);
+        link_in_order(rest);
+        mark_free(rest);
+
+        ++data->stats.blocks_count;
+        ++data->stats.free_blocks_count;
+        data->stats.free_bytes += size - need;
+    }
+
+    return true;
+}
+
+/** Header has to end exactly at an aligned address, so the block is searched with room for the worst padding
+ *  and the gap in front of the header is split off as a separate free block.
+ */
+[[nodiscard]] void *allocator_sorted_list::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    if ((alignment & (alignment - 1)) != 0)
+        throw std::bad_alloc();
+
+    auto data = metadata();
+    auto lock = lock_counting_wait(data->globalLock, data->stats);
+    debug_with_guard([&] { return "[SORTED_LIST] Allocating " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+
+    size_t need = block_size_for(size);
+    if (need > std::numeric_limits<size_t>::max() - alignment - min_block_size)
+    {
+        error_with_guard([&] { return "[SORTED_LIST] Unable to allocate " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+        throw std::bad_alloc();
+    }
+
+    block_header *block = find_free_block(need + alignment + min_block_size);
+    if (block == nullptr)
+    {
+        error_with_guard([&] { return "[SORTED_LIST] Unable to allocate " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+        throw std::bad_alloc();
+    }
+
+    data->stats.on_allocation(size);
+
+    auto block_addr = reinterpret_cast<uintptr_t>(block);
+    uintptr_t payload = __detail::round_up(block_addr + block_metadata_size, alignment);
+    size_t gap = payload - block_metadata_size - block_addr;
+
+    // Leading block must at least fit its own free header and footer
+    if (gap != 0 && gap < min_block_size)
+        gap += alignment;
+
+    if (gap != 0)
+    {
+        on_free_block_shrink(block);
+
+        // Leading part stays free in its place and the aligned tail goes right after it
+        auto tail = new (reinterpret_cast<void *>(block_addr + gap)) block_header();
+        tail->size_and_flags = block_size(block) - gap;
+        set_block_size(block, gap);
+        mark_free(block);
+        link_after(block, tail);
+
+        ++data->stats.blocks_count;
+        ++data->stats.free_blocks_count;
+        block = tail;
+    }
+
+    return take_block(block, need);
+}
+
+// Header always sits right before the payload, padding lives in a separate free block
+void allocator_sorted_list::do_deallocate_aligned_sm(
+    void *at,
+    size_t /* alignment */)
+{
+    do_deallocate_sm(at);
 }
 
 inline void allocator_sorted_list::set_fit_mode(
     allocator_with_fit_mode::fit_mode mode)
 {
-    throw not_implemented("inline void allocator_sorted_list::set_fit_mode(allocator_with_fit_mode::fit_mode)", "your code should be here...");
+    std::lock_guard lock(metadata()->globalLock);
+    metadata()->fitMode = mode;
 }
 
 std::vector<allocator_test_utils::block_info> allocator_sorted_list::get_blocks_info() const noexcept
 {
-    throw not_implemented("std::vector<allocator_test_utils::block_info> allocator_sorted_list::get_blocks_info() const noexcept", "your code should be here...");
+    std::lock_guard lock(metadata()->globalLock);
+
+    return get_blocks_info_inner();
+}
+
+/** Largest free block is kept in the metadata, the free list is walked only once after the block
+ *  of that size has been taken or cut, and the result is cached until that happens again.
+ */
+allocator_test_utils::allocator_stats allocator_sorted_list::get_stats() const
+{
+    auto data = metadata();
+    std::lock_guard lock(data->globalLock);
+
+    if (data->largestFreeStale)
+    {
+        data->stats.largest_free_block = 0;
+        for (auto it = free_begin(), stop = free_end(); it != stop; ++it)
+            data->stats.largest_free_block = std::max(data->stats.largest_free_block, it.size());
+        data->largestFreeStale = false;
+    }
+
+    allocator_test_utils::allocator_stats stats = data->stats;
+    stats.bytes_in_use = data->spaceSize - stats.free_bytes;
+
+    return stats;
 }
 
 inline logger *allocator_sorted_list::get_logger() const
 {
-    throw not_implemented("inline logger *allocator_sorted_list::get_logger() const", "your code should be here...");
+    return metadata()->loggerObj;
 }
 
 inline std::string allocator_sorted_list::get_typename() const
 {
-    throw not_implemented("inline std::string allocator_sorted_list::get_typename() const", "your code should be here...");
+    return "allocator_sorted_list";
 }
 
-
 std::vector<allocator_test_utils::block_info> allocator_sorted_list::get_blocks_info_inner() const
 {
-    throw not_implemented("std::vector<allocator_test_utils::block_info> allocator_sorted_list::get_blocks_info_inner() const", "your code should be here...");
+    std::vector<allocator_test_utils::block_info> out;
+
+    for (auto it = begin(), stop = end(); it != stop; ++it)
+        out.push_back({ it.size(), it.occupied() });
+
+    return out;
+}
+
+allocator_sorted_list::allocator_metadata *allocator_sorted_list::metadata() const noexcept
+{
+    return reinterpret_cast<allocator_metadata *>(_trusted_memory);
+}
+
+allocator_sorted_list::block_header *allocator_sorted_list::space_begin() const noexcept
+{
+    return reinterpret_cast<block_header *>(reinterpret_cast<uintptr_t>(_trusted_memory) + allocator_metadata_size);
+}
+
+size_t allocator_sorted_list::block_size_for(size_t size)
+{
+    if (size > max_request_size)
+        throw std::bad_alloc();
+
+    return std::max(__detail::round_up(block_metadata_size + size, alignof(std::max_align_t)), min_block_size);
+}
+
+size_t allocator_sorted_list::block_size(block_header *block) noexcept
+{
+    return block->size_and_flags & ~flags_mask;
+}
+
+void allocator_sorted_list::set_block_size(
+    block_header *block,
+    size_t size) noexcept
+{
+    block->size_and_flags = size | (block->size_and_flags & flags_mask);
+}
+
+void allocator_sorted_list::set_flag(
+    block_header *block,
+    size_t flag,
+    bool value) noexcept
+{
+    block->size_and_flags = value ? block->size_and_flags | flag : block->size_and_flags & ~flag;
+}
+
+allocator_sorted_list::block_header *allocator_sorted_list::next_block(block_header *block) const noexcept
+{
+    auto next = reinterpret_cast<uintptr_t>(block) + block_size(block);
+
+    return next < reinterpret_cast<uintptr_t>(space_begin()) + metadata()->spaceSize
+        ? reinterpret_cast<block_header *>(next)
+        : nullptr;
+}
+
+allocator_sorted_list::block_header *allocator_sorted_list::checked_block(void *at)
+{
+    auto space = reinterpret_cast<uintptr_t>(space_begin());
+    auto addr = reinterpret_cast<uintptr_t>(at);
+    auto block = reinterpret_cast<block_header *>(addr - block_metadata_size);
+
+    if (addr < space + block_metadata_size || addr >= space + metadata()->spaceSize
+        || (addr - space) % alignof(std::max_align_t) != 0
+        || !(block->size_and_flags & occupied_flag) || block->trusted != _trusted_memory)
+    {
+        error_with_guard("[SORTED_LIST] Invalid block pointer");
+        throw std::logic_error("[SORTED_LIST] Invalid block pointer!");
+    }
+
+    return block;
+}
+
+void allocator_sorted_list::mark_free(block_header *block) noexcept
+{
+    auto data = metadata();
+    size_t size = block_size(block);
+    *reinterpret_cast<size_t *>(reinterpret_cast<uintptr_t>(block) + size - sizeof(size_t)) = size;
+
+    block_header *next = next_block(block);
+    if (next != nullptr)
+        set_flag(next, prev_free_flag, true);
+
+    data->stats.largest_free_block = std::max(data->stats.largest_free_block, size);
+}
+
+void allocator_sorted_list::on_free_block_shrink(block_header *block) noexcept
+{
+    auto data = metadata();
+    if (block_size(block) >= data->stats.largest_free_block)
+        data->largestFreeStale = true;
+}
+
+void allocator_sorted_list::link_after(
+    block_header *prev,
+    block_header *block) noexcept
+{
+    auto data = metadata();
+
+    block->prev_free = prev;
+    block->next_free = prev != nullptr ? prev->next_free : data->freeHead;
+
+    if (block->next_free != nullptr)
+        block->next_free->prev_free = block;
+    else
+        data->freeTail = block;
+
+    if (prev != nullptr)
+        prev->next_free = block;
+    else
+        data->freeHead = block;
+}
+
+void allocator_sorted_list::unlink(block_header *block) noexcept
+{
+    auto data = metadata();
+
+    if (block->prev_free != nullptr)
+        block->prev_free->next_free = block->next_free;
+    else
+        data->freeHead = block->next_free;
+
+    if (block->next_free != nullptr)
+        block->next_free->prev_free = block->prev_free;
+    else
+        data->freeTail = block->prev_free;
+}
+
+void allocator_sorted_list::replace(
+    block_header *old_block,
+    block_header *new_block) noexcept
+{
+    auto data = metadata();
+
+    new_block->prev_free = old_block->prev_free;
+    new_block->next_free = old_block->next_free;
+
+    if (new_block->prev_free != nullptr)
+        new_block->prev_free->next_free = new_block;
+    else
+        data->freeHead = new_block;
+
+    if (new_block->next_free != nullptr)
+        new_block->next_free->prev_free = new_block;
+    else
+        data->freeTail = new_block;
+}
+
+void allocator_sorted_list::link_in_order(block_header *block) noexcept
+{
+    block_header *following = next_block(block);
+    while (following != nullptr && (following->size_and_flags & occupied_flag))
+        following = next_block(following);
+
+    link_after(following != nullptr ? following->prev_free : metadata()->freeTail, block);
+}
+
+void *allocator_sorted_list::take_block(
+    block_header *block,
+    size_t size)
+{
+    auto data = metadata();
+    size_t block_full_size = block_size(block);
+    on_free_block_shrink(block);
+
+    if (block_full_size - size >= min_block_size)
+    {
+        // Tail is at the same place in address order, so it simply takes over the list node
+        auto rest = new (reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(block) + size)) block_header();
+        rest->size_and_flags = block_full_size - size;
+        replace(block, rest);
+        mark_free(rest);
+
+        set_block_size(block, size);
+        ++data->stats.blocks_count;
+        data->stats.free_bytes -= size;
+    }
+    else
+    {
+        unlink(block);
+
+        block_header *next = next_block(block);
+        if (next != nullptr)
+            set_flag(next, prev_free_flag, false);
+
+        --data->stats.free_blocks_count;
+        data->stats.free_bytes -= block_full_size;
+    }
+
+    set_flag(block, occupied_flag, true);
+    block->trusted = _trusted_memory;
+
+    return reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(block) + block_metadata_size);
+}
+
+allocator_sorted_list::block_header *allocator_sorted_list::find_free_block(size_t size) const noexcept
+{
+    auto data = metadata();
+    block_header *found = nullptr;
+
+    for (block_header *block = data->freeHead; block != nullptr; block = block->next_free)
+    {
+        size_t cur_size = block_size(block);
+        if (cur_size < size)
+            continue;
+
+        switch (data->fitMode)
+        {
+            case allocator_with_fit_mode::fit_mode::first_fit:
+                return block;
+            case allocator_with_fit_mode::fit_mode::the_best_fit:
+                if (found == nullptr || cur_size < block_size(found))
+                    found = block;
+                if (cur_size == size)
+                    return found;
+                break;
+            case allocator_with_fit_mode::fit_mode::the_worst_fit:
+                if (found == nullptr || cur_size > block_size(found))
+                    found = block;
+                break;
+        }
+    }
+
+    return found;
 }
 
 allocator_sorted_list::sorted_free_iterator allocator_sorted_list::free_begin() const noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator allocator_sorted_list::free_begin() const noexcept", "your code should be here...");
+    return sorted_free_iterator(_trusted_memory);
 }
 
 allocator_sorted_list::sorted_free_iterator allocator_sorted_list::free_end() const noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator allocator_sorted_list::free_end() const noexcept", "your code should be here...");
+    return sorted_free_iterator();
 }
 
 allocator_sorted_list::sorted_iterator allocator_sorted_list::begin() const noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator allocator_sorted_list::begin() const noexcept", "your code should be here...");
+    return sorted_iterator(_trusted_memory);
 }
 
 allocator_sorted_list::sorted_iterator allocator_sorted_list::end() const noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator allocator_sorted_list::end() const noexcept", "your code should be here...");
+    return sorted_iterator();
 }
 
 
 bool allocator_sorted_list::sorted_free_iterator::operator==(
         const allocator_sorted_list::sorted_free_iterator & other) const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::sorted_free_iterator::operator==(const allocator_sorted_list::sorted_free_iterator &) const noexcept", "your code should be here...");
+    return _free_ptr == other._free_ptr;
 }
 
 bool allocator_sorted_list::sorted_free_iterator::operator!=(
         const allocator_sorted_list::sorted_free_iterator &other) const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::sorted_free_iterator::operator!=(const allocator_sorted_list::sorted_free_iterator &) const noexcept", "your code should be here...");
+    return !(*this == other);
 }
 
 allocator_sorted_list::sorted_free_iterator &allocator_sorted_list::sorted_free_iterator::operator++() & noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator &allocator_sorted_list::sorted_free_iterator::operator++() & noexcept", "your code should be here...");
+    _free_ptr = reinterpret_cast<block_header *>(_free_ptr)->next_free;
+
+    return *this;
 }
 
 allocator_sorted_list::sorted_free_iterator allocator_sorted_list::sorted_free_iterator::operator++(int n)
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator allocator_sorted_list::sorted_free_iterator::operator++(int)", "your code should be here...");
+    auto copy = *this;
+    ++*this;
+
+    return copy;
 }
 
 size_t allocator_sorted_list::sorted_free_iterator::size() const noexcept
 {
-    throw not_implemented("size_t allocator_sorted_list::sorted_free_iterator::size() const noexcept", "your code should be here...");
+    return block_size(reinterpret_cast<block_header *>(_free_ptr));
 }
 
 void *allocator_sorted_list::sorted_free_iterator::operator*() const noexcept
 {
-    throw not_implemented("void *allocator_sorted_list::sorted_free_iterator::operator*() const noexcept", "your code should be here...");
+    return _free_ptr;
 }
 
-allocator_sorted_list::sorted_free_iterator::sorted_free_iterator()
+allocator_sorted_list::sorted_free_iterator::sorted_free_iterator() : _free_ptr(nullptr)
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator::sorted_free_iterator()", "your code should be here...");
 }
 
 allocator_sorted_list::sorted_free_iterator::sorted_free_iterator(void *trusted)
+    : _free_ptr(reinterpret_cast<allocator_metadata *>(trusted)->freeHead)
 {
-    throw not_implemented("allocator_sorted_list::sorted_free_iterator::sorted_free_iterator(void *)", "your code should be here...");
 }
 
 bool allocator_sorted_list::sorted_iterator::operator==(const allocator_sorted_list::sorted_iterator & other) const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::sorted_iterator::operator==(const allocator_sorted_list::sorted_iterator &) const noexcept", "your code should be here...");
+    return _current_ptr == other._current_ptr;
 }
 
 bool allocator_sorted_list::sorted_iterator::operator!=(const allocator_sorted_list::sorted_iterator &other) const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::sorted_iterator::operator!=(const allocator_sorted_list::sorted_iterator &) const noexcept", "your code should be here...");
+    return !(*this == other);
 }
 
+// Free list is in address order, so the next free block is always the next one to be met
 allocator_sorted_list::sorted_iterator &allocator_sorted_list::sorted_iterator::operator++() & noexcept
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator &allocator_sorted_list::sorted_iterator::operator++() & noexcept", "your code should be here...");
+    if (_current_ptr == _free_ptr)
+        _free_ptr = reinterpret_cast<block_header *>(_free_ptr)->next_free;
+
+    auto next = reinterpret_cast<uintptr_t>(_current_ptr) + size();
+    auto space_end = reinterpret_cast<uintptr_t>(_trusted_memory) + allocator_metadata_size
+        + reinterpret_cast<allocator_metadata *>(_trusted_memory)->spaceSize;
+
+    _current_ptr = next < space_end ? reinterpret_cast<void *>(next) : nullptr;
+
+    return *this;
 }
 
 allocator_sorted_list::sorted_iterator allocator_sorted_list::sorted_iterator::operator++(int n)
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator allocator_sorted_list::sorted_iterator::operator++(int)", "your code should be here...");
+    auto copy = *this;
+    ++*this;
+
+    return copy;
 }
 
 size_t allocator_sorted_list::sorted_iterator::size() const noexcept
 {
-    throw not_implemented("size_t allocator_sorted_list::sorted_iterator::size() const noexcept", "your code should be here...");
+    return block_size(reinterpret_cast<block_header *>(_current_ptr));
 }
 
 void *allocator_sorted_list::sorted_iterator::operator*() const noexcept
 {
-    throw not_implemented("void *allocator_sorted_list::sorted_iterator::operator*() const noexcept", "your code should be here...");
+    return _current_ptr;
 }
 
-allocator_sorted_list::sorted_iterator::sorted_iterator()
+allocator_sorted_list::sorted_iterator::sorted_iterator() : _free_ptr(nullptr), _current_ptr(nullptr), _trusted_memory(nullptr)
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator::sorted_iterator() ", "your code should be here...");
 }
 
 allocator_sorted_list::sorted_iterator::sorted_iterator(void *trusted)
+    : _free_ptr(reinterpret_cast<allocator_metadata *>(trusted)->freeHead),
+      _current_ptr(reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(trusted) + allocator_metadata_size)),
+      _trusted_memory(trusted)
 {
-    throw not_implemented("allocator_sorted_list::sorted_iterator::sorted_iterator(void *)", "your code should be here...");
 }
 
 bool allocator_sorted_list::sorted_iterator::occupied() const noexcept
 {
-    throw not_implemented("bool allocator_sorted_list::sorted_iterator::occupied() const noexcept", "your code should be here...");
+    return _current_ptr != _free_ptr;
 }
@@ -1,8 +1,12 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <logger.h>
 #include <logger_builder.h>
 #include <client_logger_builder.h>
 #include <list>
+#include <cstring>
+#include <functional>
+#include <limits>
 
 #include "../include/allocator_sorted_list.h"
 
@@ -145,7 +149,8 @@ TEST(allocatorSortedListPositiveTests, test4)
                                                             }
                                                     }));
 
-    std::unique_ptr<smart_mem_resource> alloc(new allocator_sorted_list(1000, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
+    // Each of the five blocks carries the canaries of hardened builds
+    std::unique_ptr<smart_mem_resource> alloc(new allocator_sorted_list(1000 + 5 * smart_mem_resource::hardened_overhead, nullptr, logger_instance.get(), allocator_with_fit_mode::fit_mode::first_fit));
     
     auto first_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(unsigned char) * 250));
     auto second_block = reinterpret_cast<unsigned char *>(alloc->allocate(sizeof(char) * 150));
@@ -242,6 +247,332 @@ TEST(allocatorSortedListPositiveTests, test5)
     }
 }
 
+TEST(allocatorSortedListPositiveTests, fitModes)
+{
+    for (auto mode : { allocator_with_fit_mode::fit_mode::first_fit,
+                       allocator_with_fit_mode::fit_mode::the_best_fit,
+                       allocator_with_fit_mode::fit_mode::the_worst_fit })
+    {
+        std::unique_ptr<smart_mem_resource> allocator(new allocator_sorted_list(4096, nullptr, nullptr, mode));
+
+        // Holes of three different sizes separated by occupied blocks, the tail is the biggest free block
+        void *large = allocator->allocate(300);
+        void *guard1 = allocator->allocate(50);
+        void *small = allocator->allocate(100);
+        void *guard2 = allocator->allocate(50);
+        void *medium = allocator->allocate(200);
+        void *guard3 = allocator->allocate(50);
+
+        allocator->deallocate(small, 1);
+        allocator->deallocate(large, 1);
+        allocator->deallocate(medium, 1);
+
+        void *block = allocator->allocate(90);
+        memset(block, 0xAB, 90);
+
+        switch (mode)
+        {
+            case allocator_with_fit_mode::fit_mode::first_fit:
+                ASSERT_EQ(block, large);
+                break;
+            case allocator_with_fit_mode::fit_mode::the_best_fit:
+                ASSERT_EQ(block, small);
+                break;
+            case allocator_with_fit_mode::fit_mode::the_worst_fit:
+                ASSERT_GT(block, guard3);
+                break;
+        }
+
+        allocator->deallocate(block, 1);
+        allocator->deallocate(guard1, 1);
+        allocator->deallocate(guard2, 1);
+        allocator->deallocate(guard3, 1);
+
+        auto blocks = dynamic_cast<allocator_test_utils *>(allocator.get())->get_blocks_info();
+        ASSERT_EQ(blocks.size(), 1);
+        ASSERT_EQ(blocks[0], (allocator_test_utils::block_info{ .block_size = 4096, .is_block_occupied = false }));
+    }
+}
+
+TEST(allocatorSortedListPositiveTests, coalescing)
+{
+    for (auto mode : { allocator_with_fit_mode::fit_mode::first_fit,
+                       allocator_with_fit_mode::fit_mode::the_best_fit,
+                       allocator_with_fit_mode::fit_mode::the_worst_fit })
+    {
+        std::unique_ptr<smart_mem_resource> allocator(new allocator_sorted_list(1 << 16, nullptr, nullptr, mode));
+        auto *utils = dynamic_cast<allocator_test_utils *>(allocator.get());
+        std::vector<void *> blocks;
+        srand(0);
+
+        for (size_t i = 0; i < 5000; ++i)
+        {
+            if (blocks.empty() || rand() % 3 != 0)
+            {
+                try
+                {
+                    void *block = rand() % 5 == 0
+                        ? allocator->allocate(1 + rand() % 300, 64)
+                        : allocator->allocate(1 + rand() % 300);
+                    blocks.push_back(block);
+                }
+                catch (std::bad_alloc const &)
+                {
+                }
+                continue;
+            }
+
+            auto it = blocks.begin() + rand() % blocks.size();
+            allocator->deallocate(*it, 1);
+            blocks.erase(it);
+
+            // Free neighbours are always merged and the blocks cover the whole space
+            size_t total = 0;
+            size_t free_blocks = 0;
+            size_t largest_free = 0;
+            bool previous_free = false;
+            for (auto const &block : utils->get_blocks_info())
+            {
+                ASSERT_FALSE(previous_free && !block.is_block_occupied);
+                previous_free = !block.is_block_occupied;
+                free_blocks += previous_free;
+                if (previous_free)
+                    largest_free = std::max(largest_free, block.block_size);
+                total += block.block_size;
+            }
+            ASSERT_EQ(total, 1 << 16);
+            ASSERT_EQ(free_blocks, utils->get_stats().free_blocks_count);
+            ASSERT_EQ(largest_free, utils->get_stats().largest_free_block);
+        }
+
+        for (void *block : blocks)
+        {
+            allocator->deallocate(block, 1);
+        }
+
+        auto stats = utils->get_stats();
+        ASSERT_EQ(stats.blocks_count, 1);
+        ASSERT_EQ(stats.free_bytes, 1 << 16);
+        ASSERT_EQ(stats.largest_free_block, 1 << 16);
+        ASSERT_EQ(stats.allocations_count, stats.deallocations_count);
+    }
+}
+
+TEST(allocatorSortedListPositiveTests, alignedAllocation)
+{
+    std::unique_ptr<smart_mem_resource> allocator(new allocator_sorted_list(8192, nullptr, nullptr, allocator_with_fit_mode::fit_mode::the_best_fit));
+    std::vector<std::pair<void *, size_t>> blocks;
+
+    for (size_t alignment : { 8, 16, 64, 256 })
+    {
+        for (size_t size : { 1, 24, 100 })
+        {
+            void *block = allocator->allocate(size, alignment);
+            ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % alignment, 0);
+            memset(block, 0xAB, size);
+            blocks.emplace_back(block, alignment);
+        }
+    }
+
+    for (auto &[block, alignment] : blocks)
+    {
+        allocator->deallocate(block, 1, alignment);
+    }
+
+    auto blocks_state = dynamic_cast<allocator_test_utils *>(allocator.get())->get_blocks_info();
+    ASSERT_EQ(blocks_state.size(), 1);
+}
+
+TEST(allocatorSortedListPositiveTests, resizeInPlace)
+{
+    std::unique_ptr<smart_mem_resource> allocator(new allocator_sorted_list(1 << 14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    auto *utils = dynamic_cast<allocator_test_utils *>(allocator.get());
+
+    void *first = allocator->allocate(100);
+    void *second = allocator->allocate(100);
+    void *third = allocator->allocate(100);
+    allocator->deallocate(second, 1);
+
+    // Free neighbour is absorbed, the occupied block behind it stops the growth
+    ASSERT_TRUE(allocator->try_resize_in_place(first, 200));
+    ASSERT_FALSE(allocator->try_resize_in_place(first, 400));
+    ASSERT_TRUE(allocator->try_resize_in_place(first, 20));
+    ASSERT_TRUE(allocator->try_resize_in_place(third, 1000));
+    ASSERT_FALSE(allocator->try_resize_in_place(third, 1 << 15));
+    ASSERT_FALSE(allocator->try_resize_in_place(third, 100, 64));
+
+    allocator->deallocate(first, 1);
+    allocator->deallocate(third, 1);
+    ASSERT_EQ(utils->get_blocks_info().size(), 1);
+
+    // Growing by less than a header moves the free neighbour onto its own list node
+    first = allocator->allocate(100);
+    second = allocator->allocate(100);
+    third = allocator->allocate(100);
+    void *fourth = allocator->allocate(100);
+    allocator->deallocate(first, 1);
+    allocator->deallocate(third, 1);
+    ASSERT_TRUE(allocator->try_resize_in_place(second, 116));
+    ASSERT_EQ(utils->get_stats().free_blocks_count, 3);
+
+    allocator->deallocate(second, 1);
+    allocator->deallocate(fourth, 1);
+    ASSERT_EQ(utils->get_blocks_info().size(), 1);
+
+    // Contents up to the smaller of both sizes survive, other blocks are never touched
+    std::vector<std::pair<unsigned char *, size_t>> blocks;
+    srand(0);
+
+    auto check = [](unsigned char *block, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            ASSERT_EQ(block[i], static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block) >> 4));
+        }
+    };
+
+    for (size_t i = 0; i < 3000; ++i)
+    {
+        switch (blocks.empty() ? 0 : rand() % 3)
+        {
+            case 0:
+                try
+                {
+                    size_t size = 1 + rand() % 300;
+                    auto block = reinterpret_cast<unsigned char *>(allocator->allocate(size));
+                    memset(block, static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block) >> 4), size);
+                    blocks.emplace_back(block, size);
+                }
+                catch (std::bad_alloc const &)
+                {
+                }
+                break;
+            case 1:
+            {
+                auto it = blocks.begin() + rand() % blocks.size();
+                check(it->first, it->second);
+                allocator->deallocate(it->first, 1);
+                blocks.erase(it);
+                break;
+            }
+            case 2:
+            {
+                auto &[block, size] = blocks[rand() % blocks.size()];
+                size_t new_size = 1 + rand() % 600;
+                if (allocator->try_resize_in_place(block, new_size))
+                {
+                    check(block, std::min(size, new_size));
+                    memset(block, static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block) >> 4), new_size);
+                    size = new_size;
+                }
+                break;
+            }
+        }
+    }
+
+    for (auto &[block, size] : blocks)
+    {
+        check(block, size);
+        allocator->deallocate(block, 1);
+    }
+
+    auto stats = utils->get_stats();
+    ASSERT_EQ(stats.blocks_count, 1);
+    ASSERT_EQ(stats.free_bytes, 1 << 14);
+}
+
+TEST(allocatorSortedListPositiveTests, ppAllocatorResize)
+{
+    allocator_sorted_list resource(4096);
+    pp_allocator<int> allocator(&resource);
+
+    int *numbers = allocator.allocate(10);
+    ASSERT_TRUE(allocator.try_resize(numbers, 10, 100));
+    ASSERT_FALSE(allocator.try_resize(numbers, 100, 2000));
+    allocator.deallocate(numbers, 100);
+
+    // Plain memory resources can't resize anything
+    pp_allocator<int> heap_allocator(std::pmr::new_delete_resource());
+    numbers = heap_allocator.allocate(10);
+    ASSERT_FALSE(heap_allocator.try_resize(numbers, 10, 11));
+    heap_allocator.deallocate(numbers, 10);
+}
+
+TEST(allocatorSortedListPositiveTests, batchAllocation)
+{
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_sorted_list(1 << 14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    auto *utils = dynamic_cast<allocator_test_utils *>(allocator_instance.get());
+    std::vector<void *> blocks(50);
+
+    allocator_instance->allocate_batch(40, blocks.size(), blocks.data());
+
+    // Whole batch is carved out of one free block, so every block follows the previous one
+    for (size_t i = 1; i < blocks.size(); ++i)
+    {
+        ASSERT_GT(blocks[i], blocks[i - 1]);
+        ASSERT_EQ(reinterpret_cast<char *>(blocks[i]) - reinterpret_cast<char *>(blocks[i - 1]),
+                  reinterpret_cast<char *>(blocks[1]) - reinterpret_cast<char *>(blocks[0]));
+    }
+
+    auto stats = utils->get_stats();
+    ASSERT_EQ(stats.allocations_count, 50);
+    ASSERT_EQ(stats.blocks_count, 51);
+
+    std::vector<void *> fillers;
+    try
+    {
+        while (true)
+        {
+            fillers.push_back(allocator_instance->allocate(40));
+        }
+    }
+    catch (std::bad_alloc const &)
+    {
+    }
+
+    // Blocks of a batch are ordinary blocks, each one can be freed on its own
+    for (size_t i = 0; i < blocks.size(); i += 2)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+
+    // No free block holds the batch any more, so it is assembled from the holes
+    std::vector<void *> refill(25), holes;
+    allocator_instance->allocate_batch(40, refill.size(), refill.data());
+    for (size_t i = 0; i < blocks.size(); i += 2)
+    {
+        holes.push_back(blocks[i]);
+    }
+    std::vector<void *> sorted_refill(refill);
+    std::sort(sorted_refill.begin(), sorted_refill.end());
+    ASSERT_EQ(sorted_refill, holes);
+
+    allocator_instance->deallocate_batch(refill.data(), refill.size());
+    allocator_instance->deallocate_batch(fillers.data(), fillers.size());
+    for (size_t i = 1; i < blocks.size(); i += 2)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+    ASSERT_EQ(utils->get_blocks_info().size(), 1);
+
+    // Nothing stays allocated when the batch doesn't fit
+    blocks.resize(100);
+    ASSERT_THROW(allocator_instance->allocate_batch(200, blocks.size(), blocks.data()), std::bad_alloc);
+    stats = utils->get_stats();
+    ASSERT_EQ(stats.blocks_count, 1);
+    ASSERT_EQ(stats.bytes_in_use, 0);
+
+    pp_allocator<double> allocator(allocator_instance.get());
+    double *numbers[10];
+    allocator.allocate_batch(10, numbers);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        *numbers[i] = static_cast<double>(i);
+    }
+    allocator.deallocate_batch(numbers, 10);
+    ASSERT_EQ(utils->get_blocks_info().size(), 1);
+}
+
 TEST(allocatorSortedListNegativeTests, test1)
 {
     std::unique_ptr<logger> logger(create_logger(std::vector<std::pair<std::string, logger::severity>>
@@ -253,7 +584,93 @@ TEST(allocatorSortedListNegativeTests, test1)
         }));
     std::unique_ptr<smart_mem_resource> alloc(new allocator_sorted_list(3000, nullptr, logger.get(), allocator_with_fit_mode::fit_mode::first_fit));
     
-    ASSERT_THROW(alloc->allocate(sizeof(char) * 3100), std::bad_alloc);
+    ASSERT_THROW(static_cast<void>(alloc->allocate(sizeof(char) * 3100)), std::bad_alloc);
+
+    // Header and padding would wrap the block size around
+    ASSERT_THROW(static_cast<void>(alloc->allocate(std::numeric_limits<size_t>::max() - 8)), std::bad_alloc);
+    ASSERT_THROW(static_cast<void>(alloc->allocate(std::numeric_limits<size_t>::max() - 8, 64)), std::bad_alloc);
+
+    std::vector<void *> blocks(2);
+    ASSERT_THROW(alloc->allocate_batch(std::numeric_limits<size_t>::max() - 8, blocks.size(), blocks.data()), std::bad_alloc);
+    ASSERT_EQ(dynamic_cast<allocator_test_utils *>(alloc.get())->get_blocks_info().size(), 1);
+}
+
+TEST(allocatorSortedListNegativeTests, test2)
+{
+    std::unique_ptr<smart_mem_resource> alloc(new allocator_sorted_list(3000, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    void *block = alloc->allocate(100);
+    alloc->deallocate(block, 1);
+
+    ASSERT_THROW(alloc->deallocate(block, 1), std::logic_error);
+    ASSERT_THROW(alloc->deallocate(reinterpret_cast<char *>(block) + 8, 1), std::logic_error);
+    ASSERT_THROW(alloc->try_resize_in_place(block, 200), std::logic_error);
+}
+
+TEST(allocatorSortedListNegativeTests, resizeOverflow)
+{
+    std::unique_ptr<smart_mem_resource> allocator(new allocator_sorted_list(1 << 14, nullptr, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    auto *utils = dynamic_cast<allocator_test_utils *>(allocator.get());
+
+    void *block = allocator->allocate(100);
+    auto blocks_state = utils->get_blocks_info();
+
+    // Header and padding would wrap the new block size around
+    for (size_t size : { std::numeric_limits<size_t>::max() - 8, std::numeric_limits<size_t>::max() })
+    {
+        ASSERT_FALSE(allocator->try_resize_in_place(block, size));
+        ASSERT_EQ(utils->get_blocks_info(), blocks_state);
+    }
+
+    allocator->deallocate(block, 1);
+}
+
+TEST(allocatorSortedListNegativeTests, hardening)
+{
+    if (!smart_mem_resource::hardened)
+    {
+        GTEST_SKIP() << "Built without MP_OS_ALLOCATOR_HARDENED";
+    }
+
+    allocator_sorted_list alloc(3000);
+
+    auto error_of = [&](std::function<void()> const &action) -> std::string
+    {
+        try
+        {
+            action();
+        }
+        catch (std::logic_error const &error)
+        {
+            return error.what();
+        }
+
+        return "";
+    };
+
+    // Overrun is caught on free and on resize, the block stays allocated
+    auto block = reinterpret_cast<unsigned char *>(alloc.allocate(100));
+    block[100] ^= 1;
+    ASSERT_EQ(error_of([&] { alloc.deallocate(block, 1); }), "[HARDENED] Block overrun, tail canary is corrupted!");
+    ASSERT_EQ(error_of([&] { alloc.try_resize_in_place(block, 50); }), "[HARDENED] Block overrun, tail canary is corrupted!");
+    block[100] ^= 1;
+
+    ASSERT_TRUE(alloc.try_resize_in_place(block, 50));
+    block[49] = 1;
+    alloc.deallocate(block, 1);
+
+    // Freed bytes are poisoned until the allocator hands them out again
+    for (size_t i = 0; i < 32; ++i)
+    {
+        ASSERT_EQ(block[i], smart_mem_resource::poison_byte);
+    }
+
+    ASSERT_EQ(error_of([&] { alloc.deallocate(block, 1); }), "[HARDENED] Double free!");
+    ASSERT_EQ(error_of([&] { alloc.deallocate(block + 16, 1); }), "[HARDENED] Block header is corrupted or the pointer is not a block!");
+
+    auto blocks = alloc.get_blocks_info();
+    ASSERT_EQ(blocks.size(), 1);
+    ASSERT_FALSE(blocks[0].is_block_occupied);
 }
 
 int main(
@@ -0,0 +1,84 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATION_TRACE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATION_TRACE_H
+
+#include <tracing_resource.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** Sequence of allocations and deallocations addressed by slot numbers instead of pointers,
+ *  so the same trace can be replayed against any memory resource. Every trace ends with all slots free.
+ *
+ *  Text form is one operation per line: "a <slot> <size>" or "f <slot>", lines starting with '#' are skipped.
+ *  Binary logs written by tracing_resource are accepted as well.
+ */
+class allocation_trace final
+{
+
+public:
+
+    struct operation
+    {
+        uint32_t slot;
+        // Deallocation of the block in the slot when 0
+        uint32_t size;
+    };
+
+public:
+
+    std::string name;
+
+    size_t slots_count = 0;
+
+    std::vector<operation> operations;
+
+public:
+
+    // Sizes uniform in [16, 512], allocations and frees of random live blocks interleaved
+    static allocation_trace uniform(
+        size_t operations_count,
+        size_t live_count,
+        uint64_t seed);
+
+    // Same mix with Pareto distributed sizes: mostly small blocks and a long tail of big ones
+    static allocation_trace power_law(
+        size_t operations_count,
+        size_t live_count,
+        uint64_t seed);
+
+    // Bursts of allocations freed oldest first, like a queue between two stages
+    static allocation_trace producer_consumer(
+        size_t operations_count,
+        size_t live_count,
+        uint64_t seed);
+
+    // Newest block is always freed first
+    static allocation_trace lifo(
+        size_t operations_count,
+        size_t live_count,
+        uint64_t seed);
+
+    // Rounds of live_count allocations, each round freed in shuffled order
+    static allocation_trace random_free(
+        size_t operations_count,
+        size_t live_count,
+        uint64_t seed);
+
+    /** Events of all threads are merged into one sequence in time order, slots follow the addresses.
+     *  Frees of blocks allocated before recording started are dropped, blocks still live at the end are freed.
+     */
+    static allocation_trace from_events(
+        std::string name,
+        std::vector<tracing_resource::event> const &events);
+
+    // Text trace or tracing_resource log. Throws std::runtime_error for a file that can't be read or a malformed line
+    static allocation_trace load(
+        std::string const &path);
+
+    void save(
+        std::string const &path) const;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_ALLOCATION_TRACE_H
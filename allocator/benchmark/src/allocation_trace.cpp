@@ -0,0 +1,365 @@
+#include "../include/allocation_trace.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+
+    // Freed slot numbers are handed out again, so the slot table stays as small as the peak live set
+    class trace_builder
+    {
+
+    public:
+
+        allocation_trace trace;
+
+    private:
+
+        std::vector<uint32_t> _free_slots;
+
+    public:
+
+        explicit trace_builder(
+            std::string name)
+        {
+            trace.name = std::move(name);
+        }
+
+        uint32_t allocate(
+            uint32_t size)
+        {
+            uint32_t slot;
+            if (_free_slots.empty())
+            {
+                slot = static_cast<uint32_t>(trace.slots_count++);
+            }
+            else
+            {
+                slot = _free_slots.back();
+                _free_slots.pop_back();
+            }
+
+            trace.operations.push_back({ slot, std::max<uint32_t>(size, 1) });
+            return slot;
+        }
+
+        void deallocate(
+            uint32_t slot)
+        {
+            trace.operations.push_back({ slot, 0 });
+            _free_slots.push_back(slot);
+        }
+
+    };
+
+    // Live set is filled up first and then kept at about live_count blocks by fair coin flips
+    template<typename size_generator>
+    allocation_trace random_mix(
+        std::string name,
+        size_t operations_count,
+        size_t live_count,
+        uint64_t seed,
+        size_generator next_size)
+    {
+        std::mt19937_64 random(seed);
+        trace_builder builder(std::move(name));
+        std::vector<uint32_t> live;
+
+        // Every allocation also costs its deallocation, so the trace never gets longer than operations_count
+        while (builder.trace.operations.size() + live.size() + 2 <= operations_count)
+        {
+            if (live.empty() || (live.size() < live_count && (live.size() * 2 < live_count || random() % 2 == 0)))
+            {
+                live.push_back(builder.allocate(next_size(random)));
+                continue;
+            }
+
+            size_t victim = random() % live.size();
+            builder.deallocate(live[victim]);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+
+        std::shuffle(live.begin(), live.end(), random);
+        for (uint32_t slot : live)
+        {
+            builder.deallocate(slot);
+        }
+
+        return std::move(builder.trace);
+    }
+
+    uint32_t uniform_size(
+        std::mt19937_64 &random)
+    {
+        return static_cast<uint32_t>(16 + random() % 497);
+    }
+
+}
+
+allocation_trace allocation_trace::uniform(
+    size_t operations_count,
+    size_t live_count,
+    uint64_t seed)
+{
+    return random_mix("uniform", operations_count, live_count, seed, uniform_size);
+}
+
+allocation_trace allocation_trace::power_law(
+    size_t operations_count,
+    size_t live_count,
+    uint64_t seed)
+{
+    return random_mix("power_law", operations_count, live_count, seed, [](std::mt19937_64 &random)
+    {
+        // Pareto with alpha 1.5 starting at 16 bytes, capped at 64 KiB
+        double u = 1.0 - std::uniform_real_distribution<double>(0.0, 1.0)(random);
+        return static_cast<uint32_t>(std::min(16.0 / std::pow(u, 1.0 / 1.5), 65536.0));
+    });
+}
+
+allocation_trace allocation_trace::producer_consumer(
+    size_t operations_count,
+    size_t live_count,
+    uint64_t seed)
+{
+    std::mt19937_64 random(seed);
+    trace_builder builder("producer_consumer");
+    std::deque<uint32_t> queue;
+
+    while (builder.trace.operations.size() + queue.size() + 2 <= operations_count)
+    {
+        size_t burst = 1 + random() % 32;
+
+        if (queue.empty() || (queue.size() < live_count && random() % 2 == 0))
+        {
+            for (size_t i = 0; i < burst && queue.size() < live_count
+                && builder.trace.operations.size() + queue.size() + 2 <= operations_count; ++i)
+            {
+                queue.push_back(builder.allocate(static_cast<uint32_t>(32 + random() % 225)));
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < burst && !queue.empty(); ++i)
+        {
+            builder.deallocate(queue.front());
+            queue.pop_front();
+        }
+    }
+
+    for (uint32_t slot : queue)
+    {
+        builder.deallocate(slot);
+    }
+
+    return std::move(builder.trace);
+}
+
+allocation_trace allocation_trace::lifo(
+    size_t operations_count,
+    size_t live_count,
+    uint64_t seed)
+{
+    std::mt19937_64 random(seed);
+    trace_builder builder("lifo");
+    std::vector<uint32_t> stack;
+
+    while (builder.trace.operations.size() + stack.size() + 2 <= operations_count)
+    {
+        if (stack.empty() || (stack.size() < live_count && random() % 2 == 0))
+        {
+            stack.push_back(builder.allocate(uniform_size(random)));
+            continue;
+        }
+
+        builder.deallocate(stack.back());
+        stack.pop_back();
+    }
+
+    for (auto it = stack.rbegin(); it != stack.rend(); ++it)
+    {
+        builder.deallocate(*it);
+    }
+
+    return std::move(builder.trace);
+}
+
+allocation_trace allocation_trace::random_free(
+    size_t operations_count,
+    size_t live_count,
+    uint64_t seed)
+{
+    std::mt19937_64 random(seed);
+    trace_builder builder("random_free");
+    std::vector<uint32_t> round;
+
+    while (builder.trace.operations.size() + 1 < operations_count)
+    {
+        size_t round_size = std::min(live_count, (operations_count - builder.trace.operations.size()) / 2);
+
+        for (size_t i = 0; i < round_size; ++i)
+        {
+            round.push_back(builder.allocate(uniform_size(random)));
+        }
+
+        std::shuffle(round.begin(), round.end(), random);
+        for (uint32_t slot : round)
+        {
+            builder.deallocate(slot);
+        }
+        round.clear();
+    }
+
+    return std::move(builder.trace);
+}
+
+allocation_trace allocation_trace::from_events(
+    std::string name,
+    std::vector<tracing_resource::event> const &events)
+{
+    trace_builder builder(std::move(name));
+    std::unordered_map<uint64_t, uint32_t> live;
+
+    for (auto const &e : events)
+    {
+        auto found = live.find(e.address);
+
+        if (e.kind == tracing_resource::event_kind::deallocation)
+        {
+            if (found != live.end())
+            {
+                builder.deallocate(found->second);
+                live.erase(found);
+            }
+            continue;
+        }
+
+        // Free and reuse of an address by two threads within the same nanosecond may come out swapped
+        if (found != live.end())
+        {
+            builder.deallocate(found->second);
+            live.erase(found);
+        }
+
+        live.emplace(e.address, builder.allocate(e.size));
+    }
+
+    std::vector<uint32_t> rest;
+    for (auto const &[address, slot] : live)
+    {
+        rest.push_back(slot);
+    }
+
+    std::sort(rest.begin(), rest.end());
+    for (uint32_t slot : rest)
+    {
+        builder.deallocate(slot);
+    }
+
+    return std::move(builder.trace);
+}
+
+allocation_trace allocation_trace::load(
+    std::string const &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+    {
+        throw std::runtime_error("Can't open trace " + path);
+    }
+
+    std::string name = std::filesystem::path(path).stem().string();
+
+    std::array<char, tracing_resource::log_magic.size()> magic{};
+    if (stream.read(magic.data(), magic.size()) && magic == tracing_resource::log_magic)
+    {
+        return from_events(std::move(name), tracing_resource::load(path));
+    }
+
+    stream.clear();
+    stream.seekg(0);
+
+    allocation_trace trace;
+    trace.name = std::move(name);
+    std::vector<bool> occupied;
+
+    std::string line;
+    for (size_t line_number = 1; std::getline(stream, line); ++line_number)
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        char kind = 0;
+        uint64_t slot = 0, size = 0;
+        fields >> kind >> slot;
+        if (kind == 'a')
+        {
+            fields >> size;
+        }
+
+        if (fields.fail() || (kind != 'a' && kind != 'f') || slot > UINT32_MAX || size > UINT32_MAX || (kind == 'a' && size == 0))
+        {
+            throw std::runtime_error(path + ":" + std::to_string(line_number) + ": malformed operation");
+        }
+
+        if (slot >= occupied.size())
+        {
+            occupied.resize(slot + 1, false);
+        }
+
+        if (occupied[slot] == (kind == 'a'))
+        {
+            throw std::runtime_error(path + ":" + std::to_string(line_number) + (kind == 'a' ? ": slot is already allocated" : ": slot is not allocated"));
+        }
+
+        occupied[slot] = kind == 'a';
+        trace.operations.push_back({ static_cast<uint32_t>(slot), static_cast<uint32_t>(size) });
+    }
+
+    // Recordings may stop while blocks are still live
+    for (size_t slot = 0; slot < occupied.size(); ++slot)
+    {
+        if (occupied[slot])
+        {
+            trace.operations.push_back({ static_cast<uint32_t>(slot), 0 });
+        }
+    }
+
+    trace.slots_count = occupied.size();
+    return trace;
+}
+
+void allocation_trace::save(
+    std::string const &path) const
+{
+    std::ofstream stream(path);
+    if (!stream)
+    {
+        throw std::runtime_error("Can't open trace " + path);
+    }
+
+    stream << "# " << name << '\n';
+    for (auto const &op : operations)
+    {
+        if (op.size == 0)
+        {
+            stream << "f " << op.slot << '\n';
+        }
+        else
+        {
+            stream << "a " << op.slot << ' ' << op.size << '\n';
+        }
+    }
+}
@@ -0,0 +1,324 @@
+#include "../include/allocation_trace.h"
+#include <allocator_global_heap.h>
+#include <allocator_sorted_list.h>
+#include <allocator_boundary_tags.h>
+#include <allocator_buddies_system.h>
+#include <allocator_red_black_tree.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <latch>
+#include <memory>
+#include <thread>
+
+namespace
+{
+
+    struct allocator_setup
+    {
+        std::string name;
+        bool has_fit_mode;
+        std::function<std::unique_ptr<smart_mem_resource>(size_t, allocator_with_fit_mode::fit_mode)> create;
+    };
+
+    struct run_result
+    {
+        double ns_per_op = 0.0;
+        // Negative when the allocator keeps no statistics or the run was concurrent
+        double peak_fragmentation = -1.0;
+        size_t failed_allocations = 0;
+    };
+
+    // Fragmentation is sampled this often, outside of the measured time
+    constexpr const size_t sample_period = 1024;
+
+    std::vector<allocator_setup> allocator_setups()
+    {
+        return
+            {
+                { "global_heap", false, [](size_t, allocator_with_fit_mode::fit_mode)
+                    {
+                        return std::unique_ptr<smart_mem_resource>(new allocator_global_heap());
+                    } },
+                { "sorted_list", true, [](size_t space_size, allocator_with_fit_mode::fit_mode mode)
+                    {
+                        return std::unique_ptr<smart_mem_resource>(new allocator_sorted_list(space_size, nullptr, nullptr, mode));
+                    } },
+                { "boundary_tags", true, [](size_t space_size, allocator_with_fit_mode::fit_mode mode)
+                    {
+                        return std::unique_ptr<smart_mem_resource>(new allocator_boundary_tags(space_size, nullptr, nullptr, mode));
+                    } },
+                { "buddies", true, [](size_t space_size, allocator_with_fit_mode::fit_mode mode)
+                    {
+                        return std::unique_ptr<smart_mem_resource>(new allocator_buddies_system(space_size, nullptr, nullptr, mode));
+                    } },
+                { "red_black_tree", true, [](size_t space_size, allocator_with_fit_mode::fit_mode mode)
+                    {
+                        return std::unique_ptr<smart_mem_resource>(new allocator_red_black_tree(space_size, nullptr, nullptr, mode));
+                    } }
+            };
+    }
+
+    std::string fit_mode_name(
+        allocator_with_fit_mode::fit_mode mode)
+    {
+        switch (mode)
+        {
+            case allocator_with_fit_mode::fit_mode::first_fit:
+                return "first_fit";
+            case allocator_with_fit_mode::fit_mode::the_best_fit:
+                return "best_fit";
+            case allocator_with_fit_mode::fit_mode::the_worst_fit:
+                return "worst_fit";
+        }
+
+        return "";
+    }
+
+    // Operations [begin, end) of the trace, slots holds the block and its size for every slot. Returns the failed allocations
+    size_t replay(
+        smart_mem_resource &resource,
+        allocation_trace const &trace,
+        std::vector<std::pair<void *, size_t>> &slots,
+        size_t begin,
+        size_t end)
+    {
+        size_t failed = 0;
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto const &op = trace.operations[i];
+            auto &[block, size] = slots[op.slot];
+
+            if (op.size == 0)
+            {
+                if (block != nullptr)
+                {
+                    resource.deallocate(block, size);
+                    block = nullptr;
+                }
+                continue;
+            }
+
+            try
+            {
+                block = resource.allocate(op.size);
+                size = op.size;
+            }
+            catch (std::bad_alloc const &)
+            {
+                block = nullptr;
+            }
+
+            // Buddies reports failure with nullptr
+            if (block == nullptr)
+            {
+                ++failed;
+            }
+        }
+
+        return failed;
+    }
+
+    run_result run_single(
+        smart_mem_resource &resource,
+        allocation_trace const &trace)
+    {
+        run_result result;
+        auto *utils = dynamic_cast<allocator_test_utils *>(&resource);
+        std::vector<std::pair<void *, size_t>> slots(trace.slots_count, { nullptr, 0 });
+        std::chrono::steady_clock::duration elapsed{};
+
+        for (size_t begin = 0; begin < trace.operations.size(); begin += sample_period)
+        {
+            size_t end = std::min(begin + sample_period, trace.operations.size());
+
+            auto start = std::chrono::steady_clock::now();
+            result.failed_allocations += replay(resource, trace, slots, begin, end);
+            elapsed += std::chrono::steady_clock::now() - start;
+
+            if (utils != nullptr)
+            {
+                result.peak_fragmentation = std::max(result.peak_fragmentation, utils->get_stats().fragmentation());
+            }
+        }
+
+        result.ns_per_op = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+            / static_cast<double>(trace.operations.size());
+        return result;
+    }
+
+    /** Every thread replays its own copy of the trace against the shared allocator.
+     *  Workers time their own replay, the run spans from the first start to the last stop.
+     */
+    run_result run_concurrent(
+        smart_mem_resource &resource,
+        allocation_trace const &trace,
+        size_t threads_count)
+    {
+        run_result result;
+        std::vector<size_t> failed(threads_count, 0);
+        std::vector<std::chrono::steady_clock::time_point> starts(threads_count), stops(threads_count);
+        std::vector<std::thread> threads;
+        std::latch ready(threads_count + 1);
+
+        for (size_t t = 0; t < threads_count; ++t)
+        {
+            threads.emplace_back([&, t]
+            {
+                std::vector<std::pair<void *, size_t>> slots(trace.slots_count, { nullptr, 0 });
+                ready.arrive_and_wait();
+                starts[t] = std::chrono::steady_clock::now();
+                failed[t] = replay(resource, trace, slots, 0, trace.operations.size());
+                stops[t] = std::chrono::steady_clock::now();
+            });
+        }
+
+        ready.arrive_and_wait();
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        auto elapsed = *std::max_element(stops.begin(), stops.end()) - *std::min_element(starts.begin(), starts.end());
+
+        for (size_t count : failed)
+        {
+            result.failed_allocations += count;
+        }
+
+        result.ns_per_op = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+            / static_cast<double>(trace.operations.size() * threads_count);
+        return result;
+    }
+
+    void print_usage(
+        char const *program)
+    {
+        std::cerr << "Usage: " << program << " [options]\n"
+                  << "  --ops N          operations per synthetic trace (200000)\n"
+                  << "  --live N         live blocks per synthetic trace (1024)\n"
+                  << "  --threads N      scaling runs use 1, 2, 4, ... up to N threads (hardware concurrency, at most 8)\n"
+                  << "  --space N        bytes of space per allocator (64 MiB)\n"
+                  << "  --trace PATH     replay a text trace or tracing_resource log instead of the synthetic traces, may repeat\n"
+                  << "  --allocator NAME run only this allocator, may repeat\n";
+    }
+
+}
+
+int main(
+    int argc,
+    char **argv)
+{
+    size_t operations_count = 200000, live_count = 1024, space_size = size_t(1) << 26;
+    size_t max_threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 8);
+    std::vector<std::string> trace_paths, allocator_names;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        if (i + 1 >= argc)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        try
+        {
+            if (option == "--ops") operations_count = std::stoull(value);
+            else if (option == "--live") live_count = std::stoull(value);
+            else if (option == "--threads") max_threads = std::max<size_t>(std::stoull(value), 1);
+            else if (option == "--space") space_size = std::stoull(value);
+            else if (option == "--trace") trace_paths.push_back(value);
+            else if (option == "--allocator") allocator_names.push_back(value);
+            else
+            {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        catch (std::logic_error const &)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<allocation_trace> traces;
+    try
+    {
+        for (auto const &path : trace_paths)
+        {
+            traces.push_back(allocation_trace::load(path));
+        }
+    }
+    catch (std::runtime_error const &error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    if (traces.empty())
+    {
+        traces.push_back(allocation_trace::uniform(operations_count, live_count, 1));
+        traces.push_back(allocation_trace::power_law(operations_count, live_count, 2));
+        traces.push_back(allocation_trace::producer_consumer(operations_count, live_count, 3));
+        traces.push_back(allocation_trace::lifo(operations_count, live_count, 4));
+        traces.push_back(allocation_trace::random_free(operations_count, live_count, 5));
+    }
+
+    std::cout << std::left << std::setw(16) << "allocator" << std::setw(11) << "fit_mode" << std::setw(19) << "trace"
+              << std::right << std::setw(8) << "threads" << std::setw(12) << "ns/op" << std::setw(12) << "peak_frag"
+              << std::setw(10) << "failed" << '\n';
+
+    for (auto const &setup : allocator_setups())
+    {
+        if (!allocator_names.empty() && std::find(allocator_names.begin(), allocator_names.end(), setup.name) == allocator_names.end())
+        {
+            continue;
+        }
+
+        std::vector<allocator_with_fit_mode::fit_mode> modes{ allocator_with_fit_mode::fit_mode::first_fit };
+        if (setup.has_fit_mode)
+        {
+            modes.push_back(allocator_with_fit_mode::fit_mode::the_best_fit);
+            modes.push_back(allocator_with_fit_mode::fit_mode::the_worst_fit);
+        }
+
+        for (auto mode : modes)
+        {
+            for (auto const &trace : traces)
+            {
+                for (size_t threads_count = 1; threads_count <= max_threads; threads_count *= 2)
+                {
+                    // Fresh allocator for every run, so no run inherits the fragmentation of the previous one
+                    auto resource = setup.create(space_size, mode);
+                    run_result result = threads_count == 1
+                        ? run_single(*resource, trace)
+                        : run_concurrent(*resource, trace, threads_count);
+
+                    std::cout << std::left << std::setw(16) << setup.name
+                              << std::setw(11) << (setup.has_fit_mode ? fit_mode_name(mode) : "-")
+                              << std::setw(19) << trace.name
+                              << std::right << std::setw(8) << threads_count
+                              << std::setw(12) << std::fixed << std::setprecision(1) << result.ns_per_op;
+
+                    if (result.peak_fragmentation < 0.0)
+                    {
+                        std::cout << std::setw(12) << "-";
+                    }
+                    else
+                    {
+                        std::cout << std::setw(12) << std::setprecision(3) << result.peak_fragmentation;
+                    }
+
+                    std::cout << std::setw(10) << result.failed_allocations << std::endl;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
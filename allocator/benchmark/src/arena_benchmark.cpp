@@ -0,0 +1,76 @@
+#include <allocator_arena.h>
+#include <allocator_global_heap.h>
+#include <AVL_tree.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+    using tree_type = AVL_tree<int, int>;
+
+    // Time to destroy a tree of nodes_count nodes and, for an arena, to release its chunks
+    double teardown_ms(
+        int nodes_count,
+        std::pmr::memory_resource &resource,
+        allocator_arena *arena)
+    {
+        auto tree = new tree_type(pp_allocator<typename tree_type::value_type>(&resource));
+        for (int i = 0; i < nodes_count; ++i)
+        {
+            tree->insert(std::make_pair((i * 7919) % nodes_count, i));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        delete tree;
+        if (arena != nullptr)
+        {
+            arena->release();
+        }
+
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+}
+
+int main(
+    int argc,
+    char **argv)
+{
+    int max_nodes = 1000000;
+    if (argc > 1)
+    {
+        try
+        {
+            max_nodes = std::max(std::stoi(argv[1]), 1);
+        }
+        catch (std::logic_error const &)
+        {
+            std::cerr << "Usage: " << argv[0] << " [max nodes]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << std::left << std::setw(12) << "nodes"
+              << std::right << std::setw(28) << "global heap teardown ms" << std::setw(22) << "arena teardown ms" << '\n';
+
+    for (int nodes_count = 10000; nodes_count <= max_nodes; nodes_count *= 10)
+    {
+        allocator_global_heap global_heap;
+        double heap_ms = teardown_ms(nodes_count, global_heap, nullptr);
+
+        allocator_arena arena(1 << 16);
+        double arena_ms = teardown_ms(nodes_count, arena, &arena);
+
+        std::cout << std::left << std::setw(12) << nodes_count
+                  << std::right << std::setw(28) << std::fixed << std::setprecision(3) << heap_ms
+                  << std::setw(22) << arena_ms << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <bit_utils.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+    constexpr const std::array<size_t, 12> size_classes = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024 };
+
+    // What the buddies system used before bit_utils.h: a scan over every bit of the request
+    size_t legacy_ceil_log2(size_t size) noexcept
+    {
+        int ones_counter = 0, index = -1;
+
+        constexpr const size_t o = 1;
+
+        for (int i = sizeof(size_t) * 8 - 1; i >= 0; --i) {
+            if (size & (o << i)) {
+                if (ones_counter == 0)
+                    index = i;
+                ++ones_counter;
+            }
+        }
+
+        return ones_counter <= 1 ? index : index + 1;
+    }
+
+    size_t legacy_floor_log2(size_t size) noexcept
+    {
+        return static_cast<size_t>(std::floor(std::log2(size)));
+    }
+
+    size_t legacy_block_size(size_t k) noexcept
+    {
+        return static_cast<size_t>(std::pow(2, k));
+    }
+
+    size_t legacy_size_class(size_t size) noexcept
+    {
+        return std::lower_bound(size_classes.begin(), size_classes.end(), size) - size_classes.begin();
+    }
+
+    // Sum of the results is printed, so the compiler can not drop the loop
+    template<typename F>
+    void measure(
+        std::string const &name,
+        std::vector<size_t> const &sizes,
+        size_t rounds,
+        F &&f)
+    {
+        size_t sum = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            for (size_t size : sizes)
+            {
+                sum += f(size);
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        double ns_per_op = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+            / static_cast<double>(sizes.size() * rounds);
+
+        std::cout << std::left << std::setw(28) << name
+                  << std::right << std::setw(10) << std::fixed << std::setprecision(2) << ns_per_op
+                  << std::setw(24) << sum << std::endl;
+    }
+
+}
+
+int main(
+    int argc,
+    char **argv)
+{
+    size_t rounds = 200;
+    if (argc > 1)
+    {
+        try
+        {
+            rounds = std::max<size_t>(std::stoull(argv[1]), 1);
+        }
+        catch (std::logic_error const &)
+        {
+            std::cerr << "Usage: " << argv[0] << " [rounds]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::mt19937_64 random(1);
+    std::uniform_int_distribution<size_t> small(1, 1024), exponent(4, 40);
+
+    std::vector<size_t> small_sizes(1 << 16), exponents(1 << 16);
+    std::generate(small_sizes.begin(), small_sizes.end(), [&] { return small(random); });
+    std::generate(exponents.begin(), exponents.end(), [&] { return exponent(random); });
+
+    std::cout << std::left << std::setw(28) << "operation"
+              << std::right << std::setw(10) << "ns/op" << std::setw(24) << "checksum" << '\n';
+
+    measure("ceil_log2 loop", small_sizes, rounds, legacy_ceil_log2);
+    measure("ceil_log2 bit_width", small_sizes, rounds, __detail::ceil_log2);
+    measure("floor_log2 std::log2", small_sizes, rounds, legacy_floor_log2);
+    measure("floor_log2 bit_width", small_sizes, rounds, __detail::floor_log2);
+    measure("block size std::pow", exponents, rounds, legacy_block_size);
+    measure("block size shift", exponents, rounds, [](size_t k) { return size_t(1) << k; });
+    measure("size class lower_bound", small_sizes, rounds, legacy_size_class);
+    measure("size class table", small_sizes, rounds, __detail::size_class_table<16, size_classes>::of);
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <allocator_buddies_system.h>
+#include <allocator_buddies_system_concurrent.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+    // 1024 live blocks of 8 bytes to 4 KiB, every iteration frees a random one and allocates in its place
+    template<typename allocator_type>
+    void measure(
+        std::string const &name,
+        size_t iterations)
+    {
+        size_t const live_count = 1024;
+
+        allocator_type allocator_instance(1 << 24);
+        std::vector<void *> live(live_count, nullptr);
+        srand(0);
+
+        std::chrono::steady_clock::duration allocation_time{}, deallocation_time{};
+        size_t deallocations = 0;
+
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            auto &slot = live[rand() % live_count];
+            if (slot != nullptr)
+            {
+                auto start = std::chrono::steady_clock::now();
+                allocator_instance.deallocate(slot, 1);
+                deallocation_time += std::chrono::steady_clock::now() - start;
+                ++deallocations;
+            }
+
+            size_t size = 1 << (3 + rand() % 10);
+            auto start = std::chrono::steady_clock::now();
+            slot = allocator_instance.allocate(size);
+            allocation_time += std::chrono::steady_clock::now() - start;
+        }
+
+        for (auto block : live)
+        {
+            if (block != nullptr)
+            {
+                allocator_instance.deallocate(block, 1);
+            }
+        }
+
+        std::cout << std::left << std::setw(36) << name
+                  << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+                  << std::chrono::duration<double, std::nano>(allocation_time).count() / static_cast<double>(iterations)
+                  << std::setw(12) << std::chrono::duration<double, std::nano>(deallocation_time).count() / static_cast<double>(std::max<size_t>(deallocations, 1))
+                  << std::endl;
+    }
+
+}
+
+int main(
+    int argc,
+    char **argv)
+{
+    size_t iterations = 200000;
+    if (argc > 1)
+    {
+        try
+        {
+            iterations = std::max<size_t>(std::stoull(argv[1]), 1);
+        }
+        catch (std::logic_error const &)
+        {
+            std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << std::left << std::setw(36) << "allocator"
+              << std::right << std::setw(12) << "alloc ns/op" << std::setw(12) << "free ns/op" << '\n';
+
+    measure<allocator_buddies_system>("allocator_buddies_system", iterations);
+    measure<allocator_buddies_system_concurrent>("allocator_buddies_system_concurrent", iterations);
+
+    return 0;
+}
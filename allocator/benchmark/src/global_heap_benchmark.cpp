@@ -0,0 +1,67 @@
+#include <allocator_global_heap.h>
+#include <client_logger_builder.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+    // Debug records of the allocator go nowhere, so the cost of building them is all the logger adds
+    void measure(
+        std::string const &name,
+        logger *logger_instance,
+        size_t iterations)
+    {
+        allocator_global_heap allocator_instance(logger_instance);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            void *block = allocator_instance.allocate(64 + i % 64);
+            allocator_instance.deallocate(block, 1);
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::left << std::setw(20) << name
+                  << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+                  << elapsed / static_cast<double>(iterations) << std::endl;
+    }
+
+}
+
+int main(
+    int argc,
+    char **argv)
+{
+    size_t iterations = 1000000;
+    if (argc > 1)
+    {
+        try
+        {
+            iterations = std::max<size_t>(std::stoull(argv[1]), 1);
+        }
+        catch (std::logic_error const &)
+        {
+            std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::unique_ptr<logger_builder> logger_builder_instance(new client_logger_builder);
+    std::unique_ptr<logger> errors_only_logger(logger_builder_instance
+        ->add_console_stream(logger::severity::error)
+        .build());
+
+    std::cout << std::left << std::setw(20) << "logger"
+              << std::right << std::setw(12) << "ns/pair" << '\n';
+
+    measure("null", nullptr, iterations);
+    measure("errors only", errors_only_logger.get(), iterations);
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <thread_caching_resource.h>
+#include <allocator_buddies_system.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+    // Every thread keeps 64 blocks of 16..184 bytes alive and replaces one of them per iteration
+    double run_workload(
+        std::pmr::memory_resource &resource,
+        size_t threads_count,
+        size_t iterations)
+    {
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t t = 0; t < threads_count; ++t)
+        {
+            threads.emplace_back([&resource, iterations, t]()
+            {
+                std::vector<void *> live(64, nullptr);
+
+                for (size_t i = 0; i < iterations; ++i)
+                {
+                    auto &slot = live[(i * 7 + t) % live.size()];
+                    if (slot != nullptr)
+                    {
+                        resource.deallocate(slot, 1);
+                    }
+                    slot = resource.allocate(16 + (i % 8) * 24);
+                }
+
+                for (auto block : live)
+                {
+                    if (block != nullptr)
+                    {
+                        resource.deallocate(block, 1);
+                    }
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        return elapsed / static_cast<double>(threads_count * iterations);
+    }
+
+}
+
+int main(
+    int argc,
+    char **argv)
+{
+    size_t iterations = 100000;
+    if (argc > 1)
+    {
+        try
+        {
+            iterations = std::max<size_t>(std::stoull(argv[1]), 1);
+        }
+        catch (std::logic_error const &)
+        {
+            std::cerr << "Usage: " << argv[0] << " [iterations per thread]" << std::endl;
+            return 1;
+        }
+    }
+
+    size_t const max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 4);
+
+    std::cout << std::left << std::setw(10) << "threads"
+              << std::right << std::setw(16) << "buddies ns/op" << std::setw(24) << "cached buddies ns/op" << '\n';
+
+    for (size_t threads_count = 1; threads_count <= max_threads; threads_count *= 2)
+    {
+        allocator_buddies_system inner(1 << 24, nullptr, nullptr);
+        double direct = run_workload(inner, threads_count, iterations);
+
+        double cached;
+        {
+            thread_caching_resource subject(&inner);
+            cached = run_workload(subject, threads_count, iterations);
+        }
+
+        std::cout << std::left << std::setw(10) << threads_count
+                  << std::right << std::setw(16) << std::fixed << std::setprecision(2) << direct
+                  << std::setw(24) << cached << std::endl;
+    }
+
+    return 0;
+}
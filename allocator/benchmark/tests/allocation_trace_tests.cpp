@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <allocation_trace.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+
+    // Every slot alternates between allocation and deallocation and ends free, the live set stays in bounds
+    void check_balanced(
+        allocation_trace const &trace,
+        size_t live_count)
+    {
+        std::vector<bool> occupied(trace.slots_count, false);
+        size_t live = 0, peak = 0;
+
+        for (auto const &op : trace.operations)
+        {
+            ASSERT_LT(op.slot, trace.slots_count);
+            ASSERT_NE(occupied[op.slot], op.size != 0);
+            occupied[op.slot] = op.size != 0;
+
+            live = op.size != 0 ? live + 1 : live - 1;
+            peak = std::max(peak, live);
+        }
+
+        ASSERT_EQ(live, 0);
+        ASSERT_LE(peak, live_count);
+        ASSERT_LE(trace.slots_count, live_count);
+    }
+
+}
+
+TEST(allocationTraceTests, generators)
+{
+    for (auto const &trace :
+        {
+            allocation_trace::uniform(20000, 500, 1),
+            allocation_trace::power_law(20000, 500, 2),
+            allocation_trace::producer_consumer(20000, 500, 3),
+            allocation_trace::lifo(20000, 500, 4),
+            allocation_trace::random_free(20000, 500, 5)
+        })
+    {
+        SCOPED_TRACE(trace.name);
+        check_balanced(trace, 500);
+        ASSERT_GE(trace.operations.size(), 19000);
+        ASSERT_LE(trace.operations.size(), 20000);
+    }
+
+    // Same seed gives the same trace
+    auto first = allocation_trace::power_law(1000, 100, 7), second = allocation_trace::power_law(1000, 100, 7);
+    ASSERT_EQ(first.operations.size(), second.operations.size());
+    for (size_t i = 0; i < first.operations.size(); ++i)
+    {
+        ASSERT_EQ(first.operations[i].slot, second.operations[i].slot);
+        ASSERT_EQ(first.operations[i].size, second.operations[i].size);
+    }
+}
+
+TEST(allocationTraceTests, saveAndLoad)
+{
+    auto trace = allocation_trace::producer_consumer(5000, 200, 1);
+    trace.save("allocation_trace_tests_save_and_load.trace");
+
+    auto loaded = allocation_trace::load("allocation_trace_tests_save_and_load.trace");
+    std::remove("allocation_trace_tests_save_and_load.trace");
+
+    ASSERT_EQ(loaded.name, "allocation_trace_tests_save_and_load");
+    ASSERT_EQ(loaded.slots_count, trace.slots_count);
+    ASSERT_EQ(loaded.operations.size(), trace.operations.size());
+    for (size_t i = 0; i < trace.operations.size(); ++i)
+    {
+        ASSERT_EQ(loaded.operations[i].slot, trace.operations[i].slot);
+        ASSERT_EQ(loaded.operations[i].size, trace.operations[i].size);
+    }
+}
+
+TEST(allocationTraceTests, loadClosesLiveBlocks)
+{
+    std::ofstream("allocation_trace_tests_live.trace") << "# recorded\na 3 100\na 0 8\nf 3\n";
+
+    auto loaded = allocation_trace::load("allocation_trace_tests_live.trace");
+    std::remove("allocation_trace_tests_live.trace");
+
+    ASSERT_EQ(loaded.slots_count, 4);
+    ASSERT_EQ(loaded.operations.size(), 4);
+    ASSERT_EQ(loaded.operations.back().slot, 0);
+    ASSERT_EQ(loaded.operations.back().size, 0);
+}
+
+TEST(allocationTraceTests, recordedLog)
+{
+    tracing_resource recorder;
+    void *first = recorder.allocate(100);
+    void *second = recorder.allocate(200);
+    recorder.deallocate(first, 100);
+    void *third = recorder.allocate(300);
+    recorder.deallocate(second, 200);
+    recorder.save("allocation_trace_tests_recorded.log");
+
+    auto loaded = allocation_trace::load("allocation_trace_tests_recorded.log");
+    std::remove("allocation_trace_tests_recorded.log");
+
+    // Third block is still live when recording stops, so the trace frees it at the end,
+    // recorded sizes include the canaries of hardened builds
+    ASSERT_EQ(loaded.name, "allocation_trace_tests_recorded");
+    ASSERT_EQ(loaded.operations.size(), 6);
+    check_balanced(loaded, 2);
+    ASSERT_EQ(loaded.operations[0].size, 100 + smart_mem_resource::hardened_overhead);
+    ASSERT_EQ(loaded.operations[1].size, 200 + smart_mem_resource::hardened_overhead);
+    ASSERT_EQ(loaded.operations[2].slot, loaded.operations[0].slot);
+    ASSERT_EQ(loaded.operations[2].size, 0);
+    ASSERT_EQ(loaded.operations[3].size, 300 + smart_mem_resource::hardened_overhead);
+    ASSERT_EQ(loaded.operations[4].slot, loaded.operations[1].slot);
+    ASSERT_EQ(loaded.operations[5].slot, loaded.operations[3].slot);
+
+    recorder.deallocate(third, 300);
+
+    // Free of a block allocated before recording is dropped
+    auto events = recorder.events();
+    events.erase(events.begin());
+    ASSERT_EQ(allocation_trace::from_events("partial", events).operations.size(), 4);
+}
+
+TEST(allocationTraceNegativeTests, test1)
+{
+    ASSERT_THROW(allocation_trace::load("allocation_trace_tests_missing.trace"), std::runtime_error);
+
+    for (auto const *contents : { "a 0 100\na 0 20\n", "f 1\n", "a 0\n", "x 0 1\n", "a 0 0\n" })
+    {
+        std::ofstream("allocation_trace_tests_bad.trace") << contents;
+        ASSERT_THROW(allocation_trace::load("allocation_trace_tests_bad.trace"), std::runtime_error);
+    }
+    std::remove("allocation_trace_tests_bad.trace");
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
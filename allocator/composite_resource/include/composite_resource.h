@@ -0,0 +1,109 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_COMPOSITE_RESOURCE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_COMPOSITE_RESOURCE_H
+
+#include <pp_allocator.h>
+#include <address_registry.h>
+#include <registered_arena_parent.h>
+#include <logger_guardant.h>
+#include <typename_holder.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+/** Grows a pool of arenas of any smart_mem_resource: allocations go to the arena that served the last one,
+ *  then to the others, and a new arena is built when all of them are full. Arena memory is registered
+ *  in an address_registry, so a free finds its arena with one lookup instead of asking every arena.
+ */
+class composite_resource final:
+    public smart_mem_resource,
+    private logger_guardant,
+    private typename_holder
+{
+
+public:
+
+    // Builds one arena, all its memory has to be taken from parent
+    using arena_factory = std::function<std::unique_ptr<smart_mem_resource>(std::pmr::memory_resource *parent)>;
+
+private:
+
+    arena_factory _create_arena;
+
+    std::pmr::memory_resource *_upstream;
+
+    logger *_logger;
+
+    size_t _max_arenas;
+
+    address_registry _registry;
+
+    // Shared while allocating from the arenas, exclusive while a new one is added. Frees don't take it
+    mutable std::shared_mutex _arenas_lock;
+
+    std::vector<std::unique_ptr<registered_arena_parent>> _parents;
+
+    std::vector<std::unique_ptr<smart_mem_resource>> _arenas;
+
+    std::atomic<size_t> _current;
+
+public:
+
+    // upstream gives the memory of the arenas in whole granules, get_default_resource() when nullptr
+    explicit composite_resource(
+        arena_factory create_arena,
+        size_t max_arenas = SIZE_MAX,
+        std::pmr::memory_resource *upstream = nullptr,
+        logger *logger = nullptr);
+
+    composite_resource(
+        composite_resource const &other) = delete;
+
+    composite_resource &operator=(
+        composite_resource const &other) = delete;
+
+    composite_resource(
+        composite_resource &&other) noexcept = delete;
+
+    composite_resource &operator=(
+        composite_resource &&other) noexcept = delete;
+
+    ~composite_resource() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    size_t arenas_count() const;
+
+    // Arena holding the block, nullptr for memory of no arena
+    smart_mem_resource *owner_of(
+        void const *at) const noexcept;
+
+protected:
+
+    bool do_try_resize_in_place_sm(
+        void *at,
+        size_t new_size) override;
+
+private:
+
+    // Called with the lock held exclusively
+    smart_mem_resource &add_arena();
+
+    smart_mem_resource &checked_owner(
+        void *at);
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_COMPOSITE_RESOURCE_H
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include "../include/composite_resource.h"
+
+composite_resource::composite_resource(
+    arena_factory create_arena,
+    size_t max_arenas,
+    std::pmr::memory_resource *upstream,
+    logger *logger) :
+        _create_arena(std::move(create_arena)),
+        _upstream(upstream == nullptr ? std::pmr::get_default_resource() : upstream),
+        _logger(logger),
+        _max_arenas(std::max<size_t>(max_arenas, 1)),
+        _current(0)
+{
+    std::lock_guard lock(_arenas_lock);
+    add_arena();
+}
+
+composite_resource::~composite_resource()
+{
+    // Arenas give their memory back through the parents, so they go first
+    _arenas.clear();
+}
+
+[[nodiscard]] void *composite_resource::do_allocate_sm(
+    size_t size)
+{
+    while (true)
+    {
+        size_t count;
+
+        {
+            std::shared_lock lock(_arenas_lock);
+            count = _arenas.size();
+            size_t start = _current.load(std::memory_order_relaxed) % count;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                size_t index = (start + i) % count;
+
+                try
+                {
+                    // Buddies reports failure with nullptr
+                    void *at = _arenas[index]->allocate(size);
+                    if (at != nullptr)
+                    {
+                        _current.store(index, std::memory_order_relaxed);
+                        return at;
+                    }
+                }
+                catch (std::bad_alloc const &)
+                {
+                }
+            }
+        }
+
+        std::lock_guard lock(_arenas_lock);
+
+        // Another thread added an arena in between, it is tried first
+        if (_arenas.size() != count)
+            continue;
+
+        if (count == _max_arenas)
+        {
+            error_with_guard([&] { return "[COMPOSITE] Unable to allocate " + std::to_string(size) + " bytes, all " + std::to_string(count) + " arenas are full"; });
+            throw std::bad_alloc();
+        }
+
+        void *at = nullptr;
+        try
+        {
+            at = add_arena().allocate(size);
+        }
+        catch (std::bad_alloc const &)
+        {
+        }
+
+        if (at == nullptr)
+        {
+            error_with_guard([&] { return "[COMPOSITE] Unable to allocate " + std::to_string(size) + " bytes even from a new arena"; });
+            throw std::bad_alloc();
+        }
+
+        _current.store(count, std::memory_order_relaxed);
+        return at;
+    }
+}
+
+void composite_resource::do_deallocate_sm(
+    void *at)
+{
+    if (at == nullptr)
+        return;
+
+    checked_owner(at).deallocate(at, 1);
+}
+
+bool composite_resource::do_try_resize_in_place_sm(
+    void *at,
+    size_t new_size)
+{
+    return checked_owner(at).try_resize_in_place(at, new_size);
+}
+
+bool composite_resource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+size_t composite_resource::arenas_count() const
+{
+    std::shared_lock lock(_arenas_lock);
+    return _arenas.size();
+}
+
+smart_mem_resource *composite_resource::owner_of(
+    void const *at) const noexcept
+{
+    return _registry.owner_of(at);
+}
+
+smart_mem_resource &composite_resource::add_arena()
+{
+    _parents.push_back(std::make_unique<registered_arena_parent>(_upstream, _registry));
+
+    try
+    {
+        _arenas.push_back(_create_arena(_parents.back().get()));
+        if (_arenas.back() == nullptr)
+            throw std::logic_error("[COMPOSITE] Arena factory returned nothing!");
+
+        _parents.back()->claim(_arenas.back().get());
+    }
+    catch (...)
+    {
+        if (_arenas.size() == _parents.size())
+            _arenas.pop_back();
+        _parents.pop_back();
+        throw;
+    }
+
+    debug_with_guard([&] { return "[COMPOSITE] Added arena " + std::to_string(_arenas.size()); });
+
+    return *_arenas.back();
+}
+
+smart_mem_resource &composite_resource::checked_owner(
+    void *at)
+{
+    smart_mem_resource *owner = _registry.owner_of(at);
+    if (owner == nullptr)
+    {
+        error_with_guard("[COMPOSITE] Block belongs to no arena");
+        throw std::logic_error("[COMPOSITE] Block belongs to no arena!");
+    }
+
+    return *owner;
+}
+
+inline logger *composite_resource::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string composite_resource::get_typename() const
+{
+    return "composite_resource";
+}
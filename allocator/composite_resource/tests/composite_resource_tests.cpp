@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include <composite_resource.h>
+#include <allocator_sorted_list.h>
+#include <allocator_buddies_system.h>
+#include <client_logger_builder.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <set>
+#include <thread>
+#include <vector>
+
+logger *create_logger(
+    std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
+    bool use_console_stream = true,
+    logger::severity console_stream_severity = logger::severity::debug)
+{
+    std::unique_ptr<logger_builder> logger_builder_instance(new client_logger_builder);
+
+    if (use_console_stream)
+    {
+        logger_builder_instance->add_console_stream(console_stream_severity);
+    }
+
+    for (auto &output_file_stream_setup: output_file_streams_setup)
+    {
+        logger_builder_instance->add_file_stream(output_file_stream_setup.first, output_file_stream_setup.second);
+    }
+
+    logger *logger_instance = logger_builder_instance->build();
+
+    return logger_instance;
+}
+
+TEST(addressRegistryTests, test1)
+{
+    address_registry registry;
+    allocator_sorted_list first(1024), second(1024);
+
+    // Far apart, so the ranges land in different nodes of the tree
+    auto low = reinterpret_cast<void *>(uintptr_t(1) << 32);
+    auto high = reinterpret_cast<void *>((uintptr_t(1) << 46) + 3 * address_registry::granule);
+
+    registry.add(low, 3 * address_registry::granule - 100, &first);
+    registry.add(high, 1, &second);
+
+    auto at = [](void *base, ptrdiff_t offset)
+    {
+        return reinterpret_cast<unsigned char *>(base) + offset;
+    };
+
+    ASSERT_EQ(registry.owner_of(low), &first);
+    ASSERT_EQ(registry.owner_of(at(low, 3 * address_registry::granule - 1)), &first);
+    ASSERT_EQ(registry.owner_of(at(low, 3 * address_registry::granule)), nullptr);
+    ASSERT_EQ(registry.owner_of(at(low, -1)), nullptr);
+    ASSERT_EQ(registry.owner_of(at(high, address_registry::granule - 1)), &second);
+    ASSERT_EQ(registry.owner_of(nullptr), nullptr);
+    ASSERT_EQ(registry.owner_of(reinterpret_cast<void *>(~uintptr_t(0))), nullptr);
+
+    registry.remove(low, address_registry::granule);
+    ASSERT_EQ(registry.owner_of(low), nullptr);
+    ASSERT_EQ(registry.owner_of(at(low, address_registry::granule)), &first);
+
+    // Same owner may add its granules again, another one may not take any of them
+    registry.add(low, 2 * address_registry::granule, &first);
+    ASSERT_THROW(registry.add(at(low, 2 * address_registry::granule), 2 * address_registry::granule, &second), std::logic_error);
+    ASSERT_EQ(registry.owner_of(at(low, 3 * address_registry::granule)), nullptr);
+
+    ASSERT_THROW(registry.add(at(low, 8), 100, &first), std::logic_error);
+    ASSERT_THROW(registry.add(reinterpret_cast<void *>(uintptr_t(1) << 48), 100, &first), std::logic_error);
+    ASSERT_THROW(registry.add(low, 100, nullptr), std::logic_error);
+}
+
+TEST(compositeResourceTests, test1)
+{
+    std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
+        {
+            {
+                "composite_resource_tests_test1.txt",
+                logger::severity::debug
+            }
+        }, false));
+
+    composite_resource subject([](std::pmr::memory_resource *parent)
+    {
+        return std::unique_ptr<smart_mem_resource>(new allocator_sorted_list(4096, parent));
+    }, SIZE_MAX, nullptr, logger_instance.get());
+
+    ASSERT_EQ(subject.arenas_count(), 1);
+
+    // Every arena holds a few blocks, the rest grows the pool
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 40; ++i)
+    {
+        blocks.push_back(subject.allocate(1000));
+        memset(blocks.back(), static_cast<int>(i), 1000);
+    }
+
+    ASSERT_GE(subject.arenas_count(), 10);
+
+    std::set<smart_mem_resource *> owners;
+    for (void *block : blocks)
+    {
+        ASSERT_NE(subject.owner_of(block), nullptr);
+        owners.insert(subject.owner_of(block));
+    }
+    ASSERT_EQ(owners.size(), subject.arenas_count());
+
+    ASSERT_TRUE(subject.try_resize_in_place(blocks.back(), 10));
+
+    // Freed space of an old arena is reused before the pool grows again
+    size_t arenas_count = subject.arenas_count();
+    smart_mem_resource *first_owner = subject.owner_of(blocks[0]);
+    subject.deallocate(blocks[0], 1000);
+    blocks[0] = subject.allocate(1000);
+    ASSERT_EQ(subject.arenas_count(), arenas_count);
+
+    // Newest arena has no room left only without canaries, then the freed block is the one taken
+    if (!smart_mem_resource::hardened)
+    {
+        ASSERT_EQ(subject.owner_of(blocks[0]), first_owner);
+    }
+
+    for (void *block : blocks)
+    {
+        subject.deallocate(block, 1000);
+    }
+
+    for (auto owner : owners)
+    {
+        auto arena_blocks = dynamic_cast<allocator_test_utils *>(owner)->get_blocks_info();
+        ASSERT_EQ(arena_blocks.size(), 1);
+        ASSERT_FALSE(arena_blocks[0].is_block_occupied);
+    }
+}
+
+TEST(compositeResourceTests, test2)
+{
+    size_t const threads_count = 4, iterations = 2000;
+
+    composite_resource subject([](std::pmr::memory_resource *parent)
+    {
+        return std::unique_ptr<smart_mem_resource>(new allocator_buddies_system(1 << 14, parent));
+    });
+
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            std::vector<std::pair<unsigned char *, size_t>> blocks;
+
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                if (blocks.size() < 50 || i % 3 == 0)
+                {
+                    size_t size = 1 + (i * 37 + t) % 700;
+                    auto block = reinterpret_cast<unsigned char *>(subject.allocate(size));
+                    memset(block, static_cast<int>(t), size);
+                    blocks.emplace_back(block, size);
+                    continue;
+                }
+
+                auto [block, size] = blocks[i % blocks.size()];
+                ASSERT_TRUE(std::all_of(block, block + size, [t](unsigned char value) { return value == t; }));
+                subject.deallocate(block, size);
+                blocks.erase(blocks.begin() + static_cast<ptrdiff_t>(i % blocks.size()));
+            }
+
+            for (auto [block, size] : blocks)
+            {
+                subject.deallocate(block, size);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_GT(subject.arenas_count(), 1);
+}
+
+TEST(compositeResourceNegativeTests, test1)
+{
+    composite_resource subject([](std::pmr::memory_resource *parent)
+    {
+        return std::unique_ptr<smart_mem_resource>(new allocator_sorted_list(4096, parent));
+    }, 2);
+
+    void *first = subject.allocate(3000);
+    void *second = subject.allocate(3000);
+    ASSERT_EQ(subject.arenas_count(), 2);
+
+    // Pool is at its limit, and no arena holds a block bigger than itself
+    ASSERT_THROW(static_cast<void>(subject.allocate(3000)), std::bad_alloc);
+    subject.deallocate(second, 3000);
+    ASSERT_THROW(static_cast<void>(subject.allocate(10000)), std::bad_alloc);
+
+    // Padding of the default aligned path would wrap around
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max() - 70, 64)), std::bad_alloc);
+
+    // Room in front of the block keeps the hardened header check inside the buffer
+    alignas(std::max_align_t) std::array<unsigned char, 64> outside{};
+    ASSERT_THROW(subject.deallocate(outside.data() + 32, sizeof(int)), std::logic_error);
+    ASSERT_THROW(subject.try_resize_in_place(outside.data() + 32, 8), std::logic_error);
+
+    subject.deallocate(first, 3000);
+
+    ASSERT_THROW(composite_resource([](std::pmr::memory_resource *)
+    {
+        return std::unique_ptr<smart_mem_resource>();
+    }), std::logic_error);
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
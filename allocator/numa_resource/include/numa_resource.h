@@ -0,0 +1,109 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_NUMA_RESOURCE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_NUMA_RESOURCE_H
+
+#include <pp_allocator.h>
+#include <address_registry.h>
+#include <registered_arena_parent.h>
+#include <page_resource.h>
+#include <logger_guardant.h>
+#include <typename_holder.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "numa_topology.h"
+
+/** One arena per NUMA node in front of any smart_mem_resource. Every arena gets its memory from a parent bound
+ *  to its node, so its pages live there whichever thread built the resource. Allocations go to the arena of the
+ *  node the calling thread runs on and spill over to the other nodes when it is full, frees find the arena
+ *  holding the block in an address_registry.
+ */
+class numa_resource final:
+    public smart_mem_resource,
+    private logger_guardant,
+    private typename_holder
+{
+
+public:
+
+    // Builds the arena of one node, all its memory has to be taken from parent
+    using arena_factory = std::function<std::unique_ptr<smart_mem_resource>(std::pmr::memory_resource *parent)>;
+
+private:
+
+    class node_resource;
+
+    numa_topology const *_topology;
+
+    logger *_logger;
+
+    page_resource _pages;
+
+    std::pmr::memory_resource *_upstream;
+
+    address_registry _registry;
+
+    std::vector<std::unique_ptr<node_resource>> _parents;
+
+    std::vector<std::unique_ptr<smart_mem_resource>> _arenas;
+
+public:
+
+    /** upstream gives the memory of the arenas before it is bound, page_resource when nullptr.
+     *  topology is numa_topology::system() when nullptr and has to outlive the resource.
+     */
+    explicit numa_resource(
+        arena_factory const &create_arena,
+        numa_topology const *topology = nullptr,
+        std::pmr::memory_resource *upstream = nullptr,
+        logger *logger = nullptr);
+
+    numa_resource(
+        numa_resource const &other) = delete;
+
+    numa_resource &operator=(
+        numa_resource const &other) = delete;
+
+    numa_resource(
+        numa_resource &&other) noexcept = delete;
+
+    numa_resource &operator=(
+        numa_resource &&other) noexcept = delete;
+
+    ~numa_resource() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    size_t nodes_count() const noexcept;
+
+    smart_mem_resource &arena(
+        size_t node) const;
+
+    // Node whose arena holds the block, throws std::logic_error for an address of no arena
+    size_t node_of(
+        void const *at) const;
+
+protected:
+
+    bool do_try_resize_in_place_sm(
+        void *at,
+        size_t new_size) override;
+
+private:
+
+    smart_mem_resource &checked_owner(
+        void *at);
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_NUMA_RESOURCE_H
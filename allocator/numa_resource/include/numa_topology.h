@@ -0,0 +1,39 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_NUMA_TOPOLOGY_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_NUMA_TOPOLOGY_H
+
+#include <cstddef>
+
+/** What numa_resource needs to know about the machine. system() asks the kernel,
+ *  tests put a fake topology in its place to get several nodes on a single-node box.
+ */
+class numa_topology
+{
+
+public:
+
+    virtual ~numa_topology() noexcept = default;
+
+public:
+
+    // Nodes are numbered 0 .. nodes_count() - 1
+    virtual size_t nodes_count() const = 0;
+
+    // Node of the CPU the calling thread runs on right now
+    virtual size_t current_node() const = 0;
+
+    // Pages of [at, at + size) are placed on the node when first touched, at is page aligned. False when the kernel refused
+    virtual bool bind(
+        void *at,
+        size_t size,
+        size_t node) const = 0;
+
+public:
+
+    /** Node count comes from /sys/devices/system/node/online, the current node from getcpu and binding is done with mbind.
+     *  Without NUMA support in the kernel it is a single node and binding always fails.
+     */
+    static numa_topology const &system();
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_NUMA_TOPOLOGY_H
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <stdexcept>
+#include "../include/numa_resource.h"
+
+// Parent of the arena of one node, binds every range to the node before it is registered
+class numa_resource::node_resource final:
+    public registered_arena_parent
+{
+
+private:
+
+    numa_resource &_owner;
+
+    size_t _node;
+
+public:
+
+    // mbind needs whole pages, the registry whole granules
+    node_resource(
+        numa_resource &owner,
+        size_t node) :
+            registered_arena_parent(owner._upstream, owner._registry, page_resource::page_size()),
+            _owner(owner),
+            _node(node)
+    {
+    }
+
+private:
+
+    void prepare(
+        void *at,
+        size_t size) override
+    {
+        if (!_owner._topology->bind(at, size, _node))
+            _owner.warning_with_guard([&] { return "[NUMA] Unable to bind the arena of node " + std::to_string(_node) + ", its pages go wherever they are touched first"; });
+    }
+
+};
+
+numa_resource::numa_resource(
+    arena_factory const &create_arena,
+    numa_topology const *topology,
+    std::pmr::memory_resource *upstream,
+    logger *logger) :
+        _topology(topology == nullptr ? &numa_topology::system() : topology),
+        _logger(logger),
+        _pages(page_resource::huge_pages::none, logger),
+        _upstream(upstream == nullptr ? &_pages : upstream)
+{
+    size_t count = std::max<size_t>(_topology->nodes_count(), 1);
+
+    for (size_t node = 0; node < count; ++node)
+    {
+        _parents.push_back(std::make_unique<node_resource>(*this, node));
+    }
+
+    for (size_t node = 0; node < count; ++node)
+    {
+        _arenas.push_back(create_arena(_parents[node].get()));
+        if (_arenas.back() == nullptr)
+            throw std::logic_error("[NUMA] Arena factory returned nothing!");
+
+        _parents[node]->claim(_arenas.back().get());
+    }
+
+    debug_with_guard([&] { return "[NUMA] Built arenas for " + std::to_string(count) + " nodes"; });
+}
+
+numa_resource::~numa_resource()
+{
+    // Arenas give their memory back through the parents, so they go first
+    _arenas.clear();
+}
+
+[[nodiscard]] void *numa_resource::do_allocate_sm(
+    size_t size)
+{
+    size_t home = _topology->current_node() % _arenas.size();
+
+    for (size_t i = 0; i < _arenas.size(); ++i)
+    {
+        size_t node = (home + i) % _arenas.size();
+
+        try
+        {
+            // Buddies reports failure with nullptr
+            void *at = _arenas[node]->allocate(size);
+            if (at != nullptr)
+            {
+                if (node != home)
+                    debug_with_guard([&] { return "[NUMA] Node " + std::to_string(home) + " is full, allocated on node " + std::to_string(node); });
+
+                return at;
+            }
+        }
+        catch (std::bad_alloc const &)
+        {
+        }
+    }
+
+    error_with_guard([&] { return "[NUMA] Unable to allocate " + std::to_string(size) + " bytes on any node"; });
+    throw std::bad_alloc();
+}
+
+void numa_resource::do_deallocate_sm(
+    void *at)
+{
+    if (at == nullptr)
+        return;
+
+    checked_owner(at).deallocate(at, 1);
+}
+
+bool numa_resource::do_try_resize_in_place_sm(
+    void *at,
+    size_t new_size)
+{
+    return checked_owner(at).try_resize_in_place(at, new_size);
+}
+
+bool numa_resource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+size_t numa_resource::nodes_count() const noexcept
+{
+    return _arenas.size();
+}
+
+smart_mem_resource &numa_resource::arena(
+    size_t node) const
+{
+    return *_arenas.at(node);
+}
+
+size_t numa_resource::node_of(
+    void const *at) const
+{
+    smart_mem_resource *owner = _registry.owner_of(at);
+
+    for (size_t node = 0; owner != nullptr && node < _arenas.size(); ++node)
+    {
+        if (_arenas[node].get() == owner)
+            return node;
+    }
+
+    throw std::logic_error("[NUMA] Block belongs to no arena!");
+}
+
+smart_mem_resource &numa_resource::checked_owner(
+    void *at)
+{
+    smart_mem_resource *owner = _registry.owner_of(at);
+    if (owner == nullptr)
+    {
+        error_with_guard("[NUMA] Block belongs to no arena");
+        throw std::logic_error("[NUMA] Block belongs to no arena!");
+    }
+
+    return *owner;
+}
+
+inline logger *numa_resource::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string numa_resource::get_typename() const
+{
+    return "numa_resource";
+}
@@ -0,0 +1,82 @@
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "../include/numa_topology.h"
+
+namespace
+{
+    // From <numaif.h>, mbind is called through syscall so libnuma isn't needed
+    constexpr const int mpol_bind = 2;
+
+    constexpr const unsigned mpol_mf_move = 1 << 1;
+
+    constexpr const size_t mask_bits = sizeof(unsigned long) * 8;
+
+    // Online nodes are listed like "0-1" or "0,2-3", the count is the highest node plus one
+    size_t read_nodes_count()
+    {
+        std::ifstream stream("/sys/devices/system/node/online");
+        std::string online;
+        if (!(stream >> online))
+            return 1;
+
+        size_t end = online.find_last_of("0123456789");
+        if (end == std::string::npos)
+            return 1;
+
+        size_t begin = online.find_last_not_of("0123456789", end);
+        begin = begin == std::string::npos ? 0 : begin + 1;
+
+        return std::stoull(online.substr(begin, end - begin + 1)) + 1;
+    }
+
+    class system_topology final:
+        public numa_topology
+    {
+
+    private:
+
+        size_t _nodes_count;
+
+    public:
+
+        system_topology() :
+            _nodes_count(read_nodes_count())
+        {
+        }
+
+        size_t nodes_count() const override
+        {
+            return _nodes_count;
+        }
+
+        size_t current_node() const override
+        {
+            unsigned cpu, node;
+
+            return getcpu(&cpu, &node) == 0 && node < _nodes_count ? node : 0;
+        }
+
+        bool bind(
+            void *at,
+            size_t size,
+            size_t node) const override
+        {
+            std::vector<unsigned long> mask(node / mask_bits + 1, 0);
+            mask[node / mask_bits] |= 1ul << (node % mask_bits);
+
+            // Kernel reads one bit less than maxnode
+            return syscall(SYS_mbind, at, size, mpol_bind, mask.data(), mask.size() * mask_bits + 1, mpol_mf_move) == 0;
+        }
+
+    };
+}
+
+numa_topology const &numa_topology::system()
+{
+    static const system_topology topology;
+    return topology;
+}
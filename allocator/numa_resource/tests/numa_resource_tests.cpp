@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+#include <numa_resource.h>
+#include <allocator_sorted_list.h>
+#include <allocator_buddies_system.h>
+#include <allocator_boundary_tags.h>
+#include <client_logger_builder.h>
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+logger *create_logger(
+    std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
+    bool use_console_stream = true,
+    logger::severity console_stream_severity = logger::severity::debug)
+{
+    std::unique_ptr<logger_builder> logger_builder_instance(new client_logger_builder);
+
+    if (use_console_stream)
+    {
+        logger_builder_instance->add_console_stream(console_stream_severity);
+    }
+
+    for (auto &output_file_stream_setup: output_file_streams_setup)
+    {
+        logger_builder_instance->add_file_stream(output_file_stream_setup.first, output_file_stream_setup.second);
+    }
+
+    logger *logger_instance = logger_builder_instance->build();
+
+    return logger_instance;
+}
+
+// Every thread says which node it runs on, binds are only recorded
+class fake_topology final:
+    public numa_topology
+{
+
+public:
+
+    struct bind_call
+    {
+        void *at;
+        size_t size;
+        size_t node;
+    };
+
+    static thread_local size_t node;
+
+    size_t count;
+
+    mutable std::mutex lock;
+
+    mutable std::vector<bind_call> binds;
+
+    explicit fake_topology(
+        size_t count) :
+            count(count)
+    {
+    }
+
+    size_t nodes_count() const override
+    {
+        return count;
+    }
+
+    size_t current_node() const override
+    {
+        return node;
+    }
+
+    bool bind(
+        void *at,
+        size_t size,
+        size_t node) const override
+    {
+        std::lock_guard guard(lock);
+        binds.push_back({ at, size, node });
+        return true;
+    }
+
+};
+
+thread_local size_t fake_topology::node = 0;
+
+TEST(numaResourceTests, test1)
+{
+    std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
+        {
+            {
+                "numa_resource_tests_test1.txt",
+                logger::severity::debug
+            }
+        }, false));
+
+    fake_topology topology(2);
+    numa_resource subject([](std::pmr::memory_resource *parent)
+    {
+        return std::unique_ptr<smart_mem_resource>(new allocator_sorted_list(1 << 14, parent));
+    }, &topology, nullptr, logger_instance.get());
+
+    ASSERT_EQ(subject.nodes_count(), 2);
+    ASSERT_EQ(topology.binds.size(), 2);
+    ASSERT_EQ(topology.binds[0].node, 0);
+    ASSERT_EQ(topology.binds[1].node, 1);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(topology.binds[0].at) % page_resource::page_size(), 0);
+
+    fake_topology::node = 0;
+    void *first = subject.allocate(100);
+    fake_topology::node = 1;
+    void *second = subject.allocate(100);
+    void *third = subject.allocate(300);
+
+    ASSERT_EQ(subject.node_of(first), 0);
+    ASSERT_EQ(subject.node_of(second), 1);
+    ASSERT_EQ(subject.node_of(third), 1);
+
+    for (size_t node = 0; node < 2; ++node)
+    {
+        auto bound = reinterpret_cast<unsigned char *>(topology.binds[node].at);
+        auto block = reinterpret_cast<unsigned char *>(node == 0 ? first : second);
+        ASSERT_TRUE(block >= bound && block < bound + topology.binds[node].size);
+    }
+
+    // Frees go back by address whatever node the freeing thread runs on
+    subject.deallocate(first, 100);
+    subject.deallocate(second, 100);
+    ASSERT_TRUE(subject.try_resize_in_place(third, 400));
+    fake_topology::node = 0;
+    subject.deallocate(third, 400);
+
+    for (size_t node = 0; node < 2; ++node)
+    {
+        auto blocks = dynamic_cast<allocator_test_utils &>(subject.arena(node)).get_blocks_info();
+        ASSERT_EQ(blocks.size(), 1);
+        ASSERT_FALSE(blocks[0].is_block_occupied);
+    }
+}
+
+TEST(numaResourceTests, test2)
+{
+    fake_topology topology(2);
+    numa_resource subject([](std::pmr::memory_resource *parent)
+    {
+        return std::unique_ptr<smart_mem_resource>(new allocator_buddies_system(1 << 12, parent));
+    }, &topology);
+
+    // Full home node spills over to the other one
+    fake_topology::node = 1;
+    void *first = subject.allocate(3000);
+    void *second = subject.allocate(3000);
+
+    ASSERT_EQ(subject.node_of(first), 1);
+    ASSERT_EQ(subject.node_of(second), 0);
+    ASSERT_THROW(static_cast<void>(subject.allocate(3000)), std::bad_alloc);
+
+    subject.deallocate(first, 3000);
+    subject.deallocate(second, 3000);
+
+    // Aligned blocks are routed by the address of the block they sit in
+    void *aligned = subject.allocate(100, 256);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned) % 256, 0);
+    ASSERT_EQ(subject.node_of(aligned), 1);
+    subject.deallocate(aligned, 100, 256);
+}
+
+TEST(numaResourceTests, test3)
+{
+    size_t const threads_count = 4, iterations = 2000;
+
+    fake_topology topology(threads_count);
+    numa_resource subject([](std::pmr::memory_resource *parent)
+    {
+        return std::unique_ptr<smart_mem_resource>(new allocator_boundary_tags(1 << 20, parent, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+    }, &topology);
+
+    std::vector<std::thread> threads;
+    std::vector<size_t> foreign(threads_count, 0);
+
+    // Blocks are handed to the next thread to free, so half of the frees cross nodes. A thread that finishes early
+    // leaves the blocks handed to it behind, the arenas are big enough to hold all of them
+    std::vector<std::vector<void *>> handed(threads_count);
+    std::vector<std::mutex> locks(threads_count);
+
+    for (size_t t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            fake_topology::node = t;
+
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                size_t size = 1 + i % 200;
+                auto block = reinterpret_cast<unsigned char *>(subject.allocate(size));
+                memset(block, static_cast<int>(t), size);
+
+                if (subject.node_of(block) != t)
+                    ++foreign[t];
+
+                if (i % 2 == 0)
+                {
+                    subject.deallocate(block, size);
+                    continue;
+                }
+
+                void *taken = nullptr;
+                {
+                    std::lock_guard guard(locks[(t + 1) % threads_count]);
+                    handed[(t + 1) % threads_count].push_back(block);
+                }
+                {
+                    std::lock_guard guard(locks[t]);
+                    if (!handed[t].empty())
+                    {
+                        taken = handed[t].back();
+                        handed[t].pop_back();
+                    }
+                }
+
+                if (taken != nullptr)
+                    subject.deallocate(taken, 1);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    for (auto &blocks : handed)
+    {
+        for (void *block : blocks)
+        {
+            subject.deallocate(block, 1);
+        }
+    }
+
+    for (size_t t = 0; t < threads_count; ++t)
+    {
+        ASSERT_EQ(foreign[t], 0);
+
+        auto blocks = dynamic_cast<allocator_test_utils &>(subject.arena(t)).get_blocks_info();
+        ASSERT_EQ(blocks.size(), 1);
+        ASSERT_FALSE(blocks[0].is_block_occupied);
+    }
+}
+
+TEST(numaResourceTests, systemTopology)
+{
+    auto const &topology = numa_topology::system();
+
+    ASSERT_GE(topology.nodes_count(), 1);
+    ASSERT_LT(topology.current_node(), topology.nodes_count());
+
+    // Binding may be refused in a container, the resource works either way
+    numa_resource subject([](std::pmr::memory_resource *parent)
+    {
+        return std::unique_ptr<smart_mem_resource>(new allocator_sorted_list(1 << 14, parent));
+    });
+
+    ASSERT_EQ(subject.nodes_count(), topology.nodes_count());
+    void *block = subject.allocate(1000);
+    memset(block, 1, 1000);
+    subject.deallocate(block, 1000);
+}
+
+TEST(numaResourceNegativeTests, test1)
+{
+    fake_topology topology(2);
+    numa_resource subject([](std::pmr::memory_resource *parent)
+    {
+        return std::unique_ptr<smart_mem_resource>(new allocator_sorted_list(1 << 12, parent));
+    }, &topology);
+
+    // Room in front of the block keeps the hardened header check inside the buffer
+    alignas(std::max_align_t) std::array<unsigned char, 64> outside{};
+    ASSERT_THROW(subject.deallocate(outside.data() + 32, sizeof(int)), std::logic_error);
+    ASSERT_THROW(static_cast<void>(subject.allocate(1 << 13)), std::bad_alloc);
+
+    ASSERT_THROW(numa_resource([](std::pmr::memory_resource *)
+    {
+        return std::unique_ptr<smart_mem_resource>();
+    }, &topology), std::logic_error);
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,96 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_PAGE_RESOURCE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_PAGE_RESOURCE_H
+
+#include <memory_resource>
+#include <resource_with_decommit.h>
+#include <logger_guardant.h>
+#include <typename_holder.h>
+#include <atomic>
+
+/** Parent resource for large arenas: every request is its own anonymous private mapping.
+ *  Pages are committed by the first touch only, so a multi-gigabyte arena costs nothing until it is used,
+ *  and decommit() gives pages of free regions back with MADV_DONTNEED.
+ */
+class page_resource final:
+    public std::pmr::memory_resource,
+    public resource_with_decommit,
+    private logger_guardant,
+    private typename_holder
+{
+
+public:
+
+    enum class huge_pages
+    {
+        none,
+        // Mappings of at least huge_page_size are aligned to it and marked with MADV_HUGEPAGE
+        transparent,
+        // Same mappings are asked from the MAP_HUGETLB pool first, falling back to transparent ones
+        explicit_pool
+    };
+
+    static constexpr const size_t huge_page_size = size_t(1) << 21;
+
+private:
+
+    huge_pages _huge_pages;
+
+    logger *_logger;
+
+    std::atomic<size_t> _mapped_bytes;
+
+public:
+
+    explicit page_resource(
+        huge_pages mode = huge_pages::none,
+        logger *logger = nullptr);
+
+    page_resource(
+        page_resource const &other) = delete;
+
+    page_resource &operator=(
+        page_resource const &other) = delete;
+
+    page_resource(
+        page_resource &&other) noexcept = delete;
+
+    page_resource &operator=(
+        page_resource &&other) noexcept = delete;
+
+    ~page_resource() override = default;
+
+public:
+
+    void decommit(
+        void *at,
+        size_t size) noexcept override;
+
+    // Address space currently mapped by this resource, committed or not
+    size_t mapped_bytes() const noexcept;
+
+    static size_t page_size() noexcept;
+
+private:
+
+    [[nodiscard]] void *do_allocate(
+        size_t bytes,
+        size_t alignment) override;
+
+    void do_deallocate(
+        void *at,
+        size_t bytes,
+        size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    // Length of the mapping behind a request, has to be the same on allocation and deallocation
+    size_t mapping_size(size_t bytes) const noexcept;
+
+    bool uses_huge_pages(size_t bytes) const noexcept;
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_PAGE_RESOURCE_H
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <limits>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <bit_utils.h>
+#include "../include/page_resource.h"
+
+page_resource::page_resource(
+    huge_pages mode,
+    logger *logger) :
+        _huge_pages(mode),
+        _logger(logger),
+        _mapped_bytes(0)
+{
+}
+
+/** Mappings are private and MAP_NORESERVE, so nothing is committed or zeroed up front.
+ *  Stricter alignment than the mapping granularity is reached by mapping more and unmapping both ends.
+ */
+[[nodiscard]] void *page_resource::do_allocate(
+    size_t bytes,
+    size_t alignment)
+{
+    // Checked against the biggest granularity, so rounding up to whole pages can't wrap
+    if ((alignment & (alignment - 1)) != 0 || bytes > std::numeric_limits<size_t>::max() - (huge_page_size - 1))
+        throw std::bad_alloc();
+
+    size_t size = mapping_size(bytes);
+    bool huge = uses_huge_pages(bytes);
+    debug_with_guard([&] { return "[PAGE] Mapping " + std::to_string(size) + " bytes"; });
+
+    if (huge)
+        alignment = std::max(alignment, huge_page_size);
+
+    void *mapped = MAP_FAILED;
+
+    /** Pool pages are always aligned to their own size. They are reserved on mapping,
+     *  with MAP_NORESERVE an empty pool would only show up as SIGBUS on the first touch.
+     */
+    if (huge && _huge_pages == huge_pages::explicit_pool)
+    {
+        mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mapped == MAP_FAILED)
+            information_with_guard("[PAGE] Huge page pool is exhausted, falling back to transparent huge pages");
+    }
+
+    if (mapped == MAP_FAILED)
+    {
+        size_t slack = alignment > page_size() ? alignment : 0;
+        if (size > std::numeric_limits<size_t>::max() - slack)
+        {
+            error_with_guard([&] { return "[PAGE] Unable to map " + std::to_string(size) + " bytes aligned to " + std::to_string(alignment); });
+            throw std::bad_alloc();
+        }
+
+        auto raw = mmap(nullptr, size + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (raw == MAP_FAILED)
+        {
+            error_with_guard([&] { return "[PAGE] Unable to map " + std::to_string(size) + " bytes"; });
+            throw std::bad_alloc();
+        }
+
+        auto begin = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = __detail::round_up(begin, std::max(alignment, page_size()));
+
+        if (aligned != begin)
+            munmap(raw, aligned - begin);
+        if (begin + slack != aligned)
+            munmap(reinterpret_cast<void *>(aligned + size), begin + slack - aligned);
+
+        mapped = reinterpret_cast<void *>(aligned);
+
+        if (huge)
+            madvise(mapped, size, MADV_HUGEPAGE);
+    }
+
+    _mapped_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    return mapped;
+}
+
+void page_resource::do_deallocate(
+    void *at,
+    size_t bytes,
+    size_t /* alignment */)
+{
+    if (at == nullptr)
+        return;
+
+    size_t size = mapping_size(bytes);
+    debug_with_guard([&] { return "[PAGE] Unmapping " + std::to_string(size) + " bytes"; });
+
+    if (munmap(at, size) != 0)
+    {
+        error_with_guard("[PAGE] Invalid deallocation");
+        throw std::logic_error("[PAGE] Invalid deallocation!");
+    }
+
+    _mapped_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+bool page_resource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+void page_resource::decommit(
+    void *at,
+    size_t size) noexcept
+{
+    auto begin = __detail::round_up(reinterpret_cast<uintptr_t>(at), page_size());
+    auto end = (reinterpret_cast<uintptr_t>(at) + size) & ~(uintptr_t(page_size()) - 1);
+
+    if (begin < end)
+        madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+}
+
+size_t page_resource::mapped_bytes() const noexcept
+{
+    return _mapped_bytes.load(std::memory_order_relaxed);
+}
+
+size_t page_resource::page_size() noexcept
+{
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+size_t page_resource::mapping_size(size_t bytes) const noexcept
+{
+    return __detail::round_up(bytes == 0 ? 1 : bytes, uses_huge_pages(bytes) ? huge_page_size : page_size());
+}
+
+bool page_resource::uses_huge_pages(size_t bytes) const noexcept
+{
+    return _huge_pages != huge_pages::none && bytes >= huge_page_size;
+}
+
+inline logger *page_resource::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string page_resource::get_typename() const
+{
+    return "page_resource";
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include <page_resource.h>
+#include <allocator_buddies_system.h>
+#include <allocator_boundary_tags.h>
+#include <client_logger_builder.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sys/mman.h>
+#include <vector>
+
+logger *create_logger(
+    std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
+    bool use_console_stream = true,
+    logger::severity console_stream_severity = logger::severity::debug)
+{
+    std::unique_ptr<logger_builder> logger_builder_instance(new client_logger_builder);
+
+    if (use_console_stream)
+    {
+        logger_builder_instance->add_console_stream(console_stream_severity);
+    }
+
+    for (auto &output_file_stream_setup: output_file_streams_setup)
+    {
+        logger_builder_instance->add_file_stream(output_file_stream_setup.first, output_file_stream_setup.second);
+    }
+
+    logger *logger_instance = logger_builder_instance->build();
+
+    return logger_instance;
+}
+
+// Pages of the range that are backed by physical memory right now
+size_t resident_pages(
+    void *at,
+    size_t size)
+{
+    size_t page = page_resource::page_size();
+    auto begin = reinterpret_cast<uintptr_t>(at) & ~(uintptr_t(page) - 1);
+    size_t count = (reinterpret_cast<uintptr_t>(at) + size - begin + page - 1) / page;
+
+    std::vector<unsigned char> residency(count);
+    EXPECT_EQ(mincore(reinterpret_cast<void *>(begin), count * page, residency.data()), 0);
+
+    return std::count_if(residency.begin(), residency.end(), [](unsigned char state) { return state & 1; });
+}
+
+TEST(pageResourceTests, test1)
+{
+    std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
+        {
+            {
+                "page_resource_tests_logs_test_1.txt",
+                logger::severity::information
+            }
+        }));
+    page_resource subject(page_resource::huge_pages::none, logger_instance.get());
+
+    // Nothing is committed until the pages are touched
+    auto block = reinterpret_cast<char *>(subject.allocate(1 << 24, 4096));
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % 4096, 0);
+    ASSERT_EQ(subject.mapped_bytes(), 1 << 24);
+    ASSERT_EQ(resident_pages(block, 1 << 24), 0);
+
+    memset(block, 0xAB, 1 << 20);
+    ASSERT_GE(resident_pages(block, 1 << 24), (1 << 20) / page_resource::page_size());
+
+    subject.decommit(block, 1 << 20);
+    ASSERT_EQ(resident_pages(block, 1 << 24), 0);
+    ASSERT_EQ(block[100], 0);
+
+    auto aligned = subject.allocate(100, 1 << 16);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned) % (1 << 16), 0);
+    ASSERT_EQ(subject.mapped_bytes(), (1 << 24) + page_resource::page_size());
+
+    subject.deallocate(aligned, 100, 1 << 16);
+    subject.deallocate(block, 1 << 24, 4096);
+    ASSERT_EQ(subject.mapped_bytes(), 0);
+}
+
+TEST(pageResourceTests, hugePages)
+{
+    for (auto mode : { page_resource::huge_pages::transparent, page_resource::huge_pages::explicit_pool })
+    {
+        page_resource subject(mode);
+
+        // Huge page pool is usually empty, then the mapping falls back to transparent huge pages
+        auto block = subject.allocate(3 * page_resource::huge_page_size + 1);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % page_resource::huge_page_size, 0);
+        ASSERT_EQ(subject.mapped_bytes(), 4 * page_resource::huge_page_size);
+        memset(block, 0xAB, 3 * page_resource::huge_page_size + 1);
+
+        auto small = subject.allocate(100);
+        ASSERT_EQ(subject.mapped_bytes(), 4 * page_resource::huge_page_size + page_resource::page_size());
+
+        subject.deallocate(small, 100);
+        subject.deallocate(block, 3 * page_resource::huge_page_size + 1);
+        ASSERT_EQ(subject.mapped_bytes(), 0);
+    }
+}
+
+TEST(pageResourceTests, buddiesParent)
+{
+    page_resource pages;
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_buddies_system(1 << 26, &pages, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    auto block = allocator_instance->allocate(1 << 20);
+    memset(block, 0xAB, 1 << 20);
+    ASSERT_GE(resident_pages(block, 1 << 20), (1 << 20) / page_resource::page_size() - 1);
+
+    // Block merges back into the whole space, only the page with its header stays
+    allocator_instance->deallocate(block, 1);
+    ASSERT_LE(resident_pages(block, 1 << 20), 1);
+
+    block = allocator_instance->allocate(1 << 20);
+    ASSERT_EQ(reinterpret_cast<char *>(block)[1 << 19], 0);
+    allocator_instance->deallocate(block, 1);
+
+    // Blocks below 64 KiB are released once their buddies merge them into a big enough block
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 64; ++i)
+    {
+        blocks.push_back(allocator_instance->allocate(1 << 13));
+        memset(blocks.back(), 0xAB, 1 << 13);
+    }
+
+    // Block 0 keeps its buddies below 64 KiB until it is freed as the last one
+    for (size_t i = 1; i < blocks.size(); ++i)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+    ASSERT_GE(resident_pages(blocks[1], 3 << 14), (3 << 13) / page_resource::page_size());
+
+    allocator_instance->deallocate(blocks[0], 1);
+    ASSERT_LE(resident_pages(blocks[0], 64 << 14), 1);
+}
+
+TEST(pageResourceTests, boundaryTagsParent)
+{
+    page_resource pages;
+    std::unique_ptr<smart_mem_resource> allocator_instance(new allocator_boundary_tags(1 << 26, &pages, nullptr, allocator_with_fit_mode::fit_mode::first_fit));
+
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 64; ++i)
+    {
+        blocks.push_back(allocator_instance->allocate(1 << 14));
+        memset(blocks.back(), 0xAB, 1 << 14);
+    }
+
+    // Small blocks are kept committed until they merge into a big enough free block
+    allocator_instance->deallocate(blocks[1], 1);
+    ASSERT_GE(resident_pages(blocks[1], 1 << 14), (1 << 14) / page_resource::page_size());
+
+    for (size_t i = 2; i < blocks.size(); ++i)
+    {
+        allocator_instance->deallocate(blocks[i], 1);
+    }
+    ASSERT_LE(resident_pages(blocks[1], 63 << 14), 1);
+    ASSERT_GE(resident_pages(blocks[0], 1 << 14), (1 << 14) / page_resource::page_size() - 1);
+
+    allocator_instance->deallocate(blocks[0], 1);
+}
+
+TEST(pageResourceNegativeTests, test1)
+{
+    page_resource subject;
+
+    auto block = reinterpret_cast<char *>(subject.allocate(1 << 16));
+
+    ASSERT_THROW(subject.deallocate(block + 1, 1 << 16), std::logic_error);
+    ASSERT_THROW(static_cast<void>(subject.allocate(100, 3)), std::bad_alloc);
+
+    // Rounding up to pages or adding the alignment slack would wrap the mapping size around
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max() - 8)), std::bad_alloc);
+    ASSERT_THROW(static_cast<void>(subject.allocate((size_t(1) << 63) + page_resource::page_size(), size_t(1) << 63)), std::bad_alloc);
+    ASSERT_EQ(subject.mapped_bytes(), 1 << 16);
+
+    subject.deallocate(block, 1 << 16);
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
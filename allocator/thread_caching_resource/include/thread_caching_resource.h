@@ -0,0 +1,139 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_THREAD_CACHING_RESOURCE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_THREAD_CACHING_RESOURCE_H
+
+#include <pp_allocator.h>
+#include <logger_guardant.h>
+#include <typename_holder.h>
+#include <array>
+#include <atomic>
+#include <forward_list>
+#include <memory>
+#include <mutex>
+
+/** Front-end for any memory_resource: small requests are served from per-thread magazines,
+ *  the wrapped resource (and its lock) is only touched when a magazine is refilled or flushed.
+ *  Blocks cached by a finished thread are returned to the wrapped resource on thread exit.
+ */
+class thread_caching_resource final:
+    public smart_mem_resource,
+    private logger_guardant,
+    private typename_holder
+{
+
+private:
+
+    static constexpr const size_t min_class_size = 16;
+
+    static constexpr const size_t size_classes_count = 8; // 16, 32, ..., 2048
+
+    static constexpr const size_t max_class_size = min_class_size << (size_classes_count - 1);
+
+    static constexpr const size_t large_class = size_classes_count;
+
+    // How many blocks a magazine takes from / gives back to the wrapped resource at once
+    static constexpr const size_t batch_size = 32;
+
+    static constexpr const size_t magazine_capacity = 2 * batch_size;
+
+    // Two words, so payload keeps whatever alignment the wrapped resource gives modulo 16
+    struct block_header
+    {
+        size_t size_class;
+        size_t size;
+    };
+
+    static constexpr const size_t header_size = sizeof(block_header);
+
+    struct free_node
+    {
+        free_node* next;
+    };
+
+    struct magazine
+    {
+        free_node* head = nullptr;
+        size_t count = 0;
+    };
+
+    struct thread_cache
+    {
+        std::array<magazine, size_classes_count> magazines;
+    };
+
+    class cache_registry;
+
+    friend class cache_registry;
+
+    std::pmr::memory_resource *_inner;
+
+    // _inner when it has the batch API, so a refill or a flush locks it once; nullptr otherwise
+    smart_mem_resource *_batch_inner;
+
+    logger *_logger;
+
+    uint64_t _id;
+
+    // Guards only the list of caches, taken once per thread
+    std::mutex _caches_lock;
+
+    std::forward_list<std::unique_ptr<thread_cache>> _caches;
+
+    static std::atomic<uint64_t> _next_id;
+
+    static thread_local cache_registry _registry;
+
+public:
+
+    explicit thread_caching_resource(
+        std::pmr::memory_resource *inner = nullptr,
+        logger *logger = nullptr);
+
+    thread_caching_resource(
+        thread_caching_resource const &other) = delete;
+
+    thread_caching_resource &operator=(
+        thread_caching_resource const &other) = delete;
+
+    thread_caching_resource(
+        thread_caching_resource &&other) noexcept = delete;
+
+    thread_caching_resource &operator=(
+        thread_caching_resource &&other) noexcept = delete;
+
+    ~thread_caching_resource() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    // Returns every cached block of the calling thread to the wrapped resource
+    void flush_thread_cache();
+
+private:
+
+    static size_t size_to_class(size_t size) noexcept;
+
+    static size_t class_to_size(size_t size_class) noexcept;
+
+    thread_cache *local_cache();
+
+    void refill(magazine &mag, size_t size_class);
+
+    void flush(magazine &mag, size_t size_class, size_t count);
+
+    void release(void **blocks, size_t count, size_t block_size);
+
+    void flush_all(thread_cache &cache);
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_THREAD_CACHING_RESOURCE_H
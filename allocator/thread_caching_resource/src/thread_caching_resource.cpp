@@ -0,0 +1,315 @@
+#include <bit_utils.h>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include "../include/thread_caching_resource.h"
+
+std::atomic<uint64_t> thread_caching_resource::_next_id = 1;
+
+namespace
+{
+    // Ids of resources that are still alive, checked by exiting threads before flushing into them
+    std::mutex &live_lock()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+
+    std::unordered_set<uint64_t> &live_ids()
+    {
+        static std::unordered_set<uint64_t> ids;
+        return ids;
+    }
+}
+
+class thread_caching_resource::cache_registry final
+{
+
+public:
+
+    struct entry
+    {
+        thread_caching_resource *owner;
+        thread_cache *cache;
+    };
+
+    std::unordered_map<uint64_t, entry> entries;
+
+    uint64_t last_id = 0;
+
+    thread_cache *last_cache = nullptr;
+
+    ~cache_registry()
+    {
+        std::lock_guard lock(live_lock());
+
+        for (auto &[id, e] : entries)
+        {
+            if (live_ids().contains(id))
+                e.owner->flush_all(*e.cache);
+        }
+    }
+};
+
+thread_local thread_caching_resource::cache_registry thread_caching_resource::_registry;
+
+thread_caching_resource::thread_caching_resource(
+    std::pmr::memory_resource *inner,
+    logger *logger) :
+        _inner(inner == nullptr ? std::pmr::get_default_resource() : inner),
+        _batch_inner(dynamic_cast<smart_mem_resource *>(_inner)),
+        _logger(logger),
+        _id(_next_id.fetch_add(1, std::memory_order_relaxed))
+{
+    std::lock_guard lock(live_lock());
+    live_ids().insert(_id);
+}
+
+thread_caching_resource::~thread_caching_resource()
+{
+    {
+        std::lock_guard lock(live_lock());
+        live_ids().erase(_id);
+    }
+
+    std::lock_guard lock(_caches_lock);
+    for (auto &cache : _caches)
+    {
+        flush_all(*cache);
+    }
+}
+
+[[nodiscard]] void *thread_caching_resource::do_allocate_sm(
+    size_t size)
+{
+    size_t size_class = size_to_class(size);
+
+    if (size_class == large_class)
+    {
+        debug_with_guard([&] { return "[THREAD_CACHE] Passing allocation of " + std::to_string(size) + " bytes to wrapped resource"; });
+
+        if (size > std::numeric_limits<size_t>::max() - header_size)
+            throw std::bad_alloc();
+
+        auto header = reinterpret_cast<block_header *>(_inner->allocate(size + header_size));
+        if (header == nullptr)
+            throw std::bad_alloc();
+
+        header->size_class = large_class;
+        header->size = size;
+        return header + 1;
+    }
+
+    magazine &mag = local_cache()->magazines[size_class];
+    if (mag.head == nullptr)
+        refill(mag, size_class);
+
+    free_node *node = mag.head;
+    mag.head = node->next;
+    --mag.count;
+
+    return node;
+}
+
+void thread_caching_resource::do_deallocate_sm(
+    void *at)
+{
+    if (at == nullptr)
+        return;
+
+    auto header = reinterpret_cast<block_header *>(at) - 1;
+
+    if (header->size_class == large_class)
+    {
+        _inner->deallocate(header, header->size + header_size);
+        return;
+    }
+
+    magazine &mag = local_cache()->magazines[header->size_class];
+
+    auto node = reinterpret_cast<free_node *>(at);
+    node->next = mag.head;
+    mag.head = node;
+
+    if (++mag.count > magazine_capacity)
+        flush(mag, header->size_class, batch_size);
+}
+
+bool thread_caching_resource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+void thread_caching_resource::flush_thread_cache()
+{
+    flush_all(*local_cache());
+}
+
+size_t thread_caching_resource::size_to_class(size_t size) noexcept
+{
+    if (size <= min_class_size)
+        return 0;
+
+    if (size > max_class_size)
+        return large_class;
+
+    return __detail::ceil_log2(size) - __detail::ceil_log2(min_class_size);
+}
+
+size_t thread_caching_resource::class_to_size(size_t size_class) noexcept
+{
+    return min_class_size << size_class;
+}
+
+thread_caching_resource::thread_cache *thread_caching_resource::local_cache()
+{
+    if (_registry.last_id == _id)
+        return _registry.last_cache;
+
+    auto found = _registry.entries.find(_id);
+    if (found == _registry.entries.end())
+    {
+        // Entries of destroyed resources are dropped whenever one is added, so they don't pile up in long-lived threads
+        {
+            std::lock_guard lock(live_lock());
+            std::erase_if(_registry.entries, [](auto const &e) { return !live_ids().contains(e.first); });
+        }
+
+        thread_cache *cache;
+        {
+            std::lock_guard lock(_caches_lock);
+            cache = _caches.emplace_front(std::make_unique<thread_cache>()).get();
+        }
+
+        found = _registry.entries.emplace(_id, cache_registry::entry{ this, cache }).first;
+    }
+
+    _registry.last_id = _id;
+    _registry.last_cache = found->second.cache;
+
+    return _registry.last_cache;
+}
+
+void thread_caching_resource::refill(
+    magazine &mag,
+    size_t size_class)
+{
+    size_t block_size = class_to_size(size_class) + header_size;
+    std::array<void *, batch_size> blocks;
+    size_t taken = 0;
+
+    debug_with_guard([&] { return "[THREAD_CACHE] Refilling magazine of " + std::to_string(class_to_size(size_class)) + " bytes blocks"; });
+
+    if (_batch_inner != nullptr)
+    {
+        try
+        {
+            _batch_inner->allocate_batch(block_size, batch_size, blocks.data());
+            taken = batch_size;
+        }
+        catch (std::bad_alloc const &)
+        {
+        }
+    }
+
+    // Without the batch API, or when a whole batch doesn't fit, blocks are taken one by one while they last
+    for (; taken < batch_size; ++taken)
+    {
+        try
+        {
+            blocks[taken] = _inner->allocate(block_size);
+        }
+        catch (std::bad_alloc const &)
+        {
+            blocks[taken] = nullptr;
+        }
+
+        if (blocks[taken] == nullptr)
+            break;
+    }
+
+    if (taken == 0)
+    {
+        error_with_guard([&] { return "[THREAD_CACHE] Wrapped resource is unable to allocate " + std::to_string(block_size) + " bytes"; });
+        throw std::bad_alloc();
+    }
+
+    for (size_t i = 0; i < taken; ++i)
+    {
+        auto header = reinterpret_cast<block_header *>(blocks[i]);
+
+        header->size_class = size_class;
+        header->size = class_to_size(size_class);
+
+        auto node = reinterpret_cast<free_node *>(header + 1);
+        node->next = mag.head;
+        mag.head = node;
+        ++mag.count;
+    }
+}
+
+void thread_caching_resource::flush(
+    magazine &mag,
+    size_t size_class,
+    size_t count)
+{
+    if (count == 0)
+        return;
+
+    size_t block_size = class_to_size(size_class) + header_size;
+    std::array<void *, magazine_capacity> blocks;
+
+    debug_with_guard([&] { return "[THREAD_CACHE] Flushing " + std::to_string(count) + " blocks of " + std::to_string(class_to_size(size_class)) + " bytes"; });
+
+    while (count > 0 && mag.head != nullptr)
+    {
+        size_t taken = 0;
+
+        for (; taken < blocks.size() && count > 0 && mag.head != nullptr; ++taken, --count)
+        {
+            free_node *node = mag.head;
+            mag.head = node->next;
+            --mag.count;
+
+            blocks[taken] = reinterpret_cast<block_header *>(node) - 1;
+        }
+
+        release(blocks.data(), taken, block_size);
+    }
+}
+
+void thread_caching_resource::release(
+    void **blocks,
+    size_t count,
+    size_t block_size)
+{
+    if (_batch_inner != nullptr)
+    {
+        _batch_inner->deallocate_batch(blocks, count);
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        _inner->deallocate(blocks[i], block_size);
+    }
+}
+
+void thread_caching_resource::flush_all(
+    thread_cache &cache)
+{
+    for (size_t size_class = 0; size_class < size_classes_count; ++size_class)
+    {
+        flush(cache.magazines[size_class], size_class, cache.magazines[size_class].count);
+    }
+}
+
+inline logger *thread_caching_resource::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string thread_caching_resource::get_typename() const
+{
+    return "thread_caching_resource";
+}
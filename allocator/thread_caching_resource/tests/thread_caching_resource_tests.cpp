@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+#include <thread_caching_resource.h>
+#include <allocator_buddies_system.h>
+#include <allocator_global_heap.h>
+#include <client_logger_builder.h>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+logger *create_logger(
+    std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
+    bool use_console_stream = true,
+    logger::severity console_stream_severity = logger::severity::debug)
+{
+    std::unique_ptr<logger_builder> logger_builder_instance(new client_logger_builder);
+
+    if (use_console_stream)
+    {
+        logger_builder_instance->add_console_stream(console_stream_severity);
+    }
+
+    for (auto &output_file_stream_setup: output_file_streams_setup)
+    {
+        logger_builder_instance->add_file_stream(output_file_stream_setup.first, output_file_stream_setup.second);
+    }
+
+    logger *logger_instance = logger_builder_instance->build();
+
+    return logger_instance;
+}
+
+TEST(threadCachingResourceTests, test1)
+{
+    std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
+        {
+            {
+                "thread_caching_resource_tests_test1.txt",
+                logger::severity::debug
+            }
+        }, false));
+
+    allocator_buddies_system inner(1 << 16, nullptr, nullptr);
+
+    {
+        thread_caching_resource subject(&inner, logger_instance.get());
+
+        auto first_block = reinterpret_cast<int *>(subject.allocate(sizeof(int) * 10));
+        auto second_block = reinterpret_cast<int *>(subject.allocate(sizeof(int) * 10));
+        auto large_block = reinterpret_cast<char *>(subject.allocate(5000));
+
+        ASSERT_NE(first_block, second_block);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            first_block[i] = i;
+            second_block[i] = -i;
+        }
+        memset(large_block, 'a', 5000);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            ASSERT_EQ(first_block[i], i);
+            ASSERT_EQ(second_block[i], -i);
+        }
+
+        subject.deallocate(first_block, 1);
+
+        // Freed block goes back to the magazine and is handed out again
+        auto third_block = reinterpret_cast<int *>(subject.allocate(sizeof(int) * 10));
+        ASSERT_EQ(first_block, third_block);
+
+        subject.deallocate(third_block, 1);
+        subject.deallocate(second_block, 1);
+        subject.deallocate(large_block, 1);
+    }
+
+    auto blocks = inner.get_blocks_info();
+    ASSERT_EQ(blocks.size(), 1);
+    ASSERT_FALSE(blocks[0].is_block_occupied);
+}
+
+TEST(threadCachingResourceTests, test2)
+{
+    allocator_buddies_system inner(1 << 25, nullptr, nullptr);
+
+    {
+        thread_caching_resource subject(&inner);
+
+        size_t const threads_count = 8;
+        std::vector<std::vector<void *>> allocated(threads_count);
+        std::vector<std::thread> threads;
+
+        for (size_t t = 0; t < threads_count; ++t)
+        {
+            threads.emplace_back([&subject, &allocated, t]()
+            {
+                for (size_t i = 0; i < 1000; ++i)
+                {
+                    size_t size = 8 + (i * 37 + t) % 3000;
+                    auto block = reinterpret_cast<unsigned char *>(subject.allocate(size));
+                    memset(block, static_cast<int>(t), size);
+                    allocated[t].push_back(block);
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        threads.clear();
+
+        // Blocks are freed by a different thread than the one which allocated them
+        for (size_t t = 0; t < threads_count; ++t)
+        {
+            threads.emplace_back([&subject, &allocated, t, threads_count]()
+            {
+                for (auto block : allocated[(t + 1) % threads_count])
+                {
+                    ASSERT_EQ(*reinterpret_cast<unsigned char *>(block), (t + 1) % threads_count);
+                    subject.deallocate(block, 1);
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    auto blocks = inner.get_blocks_info();
+    ASSERT_EQ(blocks.size(), 1);
+    ASSERT_FALSE(blocks[0].is_block_occupied);
+}
+
+TEST(threadCachingResourceTests, test3)
+{
+    allocator_global_heap inner;
+    thread_caching_resource subject(&inner);
+
+    for (size_t alignment : { 32, 64, 128 })
+    {
+        void *block = subject.allocate(100, alignment);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % alignment, 0);
+        subject.deallocate(block, 100, alignment);
+    }
+
+    subject.flush_thread_cache();
+}
+
+namespace
+{
+    // Counts the calls into the wrapped resource, each one stands for a lock of a real allocator
+    class counting_resource final:
+        public smart_mem_resource
+    {
+
+    public:
+
+        size_t calls = 0;
+
+    private:
+
+        void *do_allocate_sm(
+            size_t size) override
+        {
+            ++calls;
+            return ::operator new(size);
+        }
+
+        void do_deallocate_sm(
+            void *at) override
+        {
+            ++calls;
+            ::operator delete(at);
+        }
+
+        void do_allocate_batch_sm(
+            size_t size,
+            size_t count,
+            void **out) override
+        {
+            ++calls;
+            for (size_t i = 0; i < count; ++i)
+            {
+                out[i] = ::operator new(size);
+            }
+        }
+
+        void do_deallocate_batch_sm(
+            void *const *ptrs,
+            size_t count) override
+        {
+            ++calls;
+            for (size_t i = 0; i < count; ++i)
+            {
+                ::operator delete(ptrs[i]);
+            }
+        }
+
+        bool do_is_equal(
+            std::pmr::memory_resource const &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
+TEST(threadCachingResourceTests, test4)
+{
+    counting_resource inner;
+
+    // Hardened builds check every block of a batch and free them one call at a time
+    auto flush_calls = [](size_t count) -> size_t
+    {
+        return smart_mem_resource::hardened ? count : 1;
+    };
+
+    {
+        thread_caching_resource subject(&inner);
+        std::vector<void *> blocks;
+
+        // Every refill takes a whole batch in one call
+        for (size_t i = 0; i < 65; ++i)
+        {
+            blocks.push_back(subject.allocate(24));
+        }
+        ASSERT_EQ(inner.calls, 3);
+
+        // The magazine overflows once and gives half of its blocks back in one call
+        for (auto block : blocks)
+        {
+            subject.deallocate(block, 24);
+        }
+        ASSERT_EQ(inner.calls, 3 + flush_calls(32));
+
+        subject.flush_thread_cache();
+        ASSERT_EQ(inner.calls, 3 + flush_calls(32) + flush_calls(64));
+    }
+
+    ASSERT_EQ(inner.calls, 3 + flush_calls(32) + flush_calls(64));
+}
+
+TEST(threadCachingResourceNegativeTests, test1)
+{
+    allocator_buddies_system inner(1 << 16, nullptr, nullptr);
+    thread_caching_resource subject(&inner);
+
+    // Header of a large block would wrap the size around
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max() - 8)), std::bad_alloc);
+    ASSERT_THROW(static_cast<void>(subject.allocate(1 << 17)), std::bad_alloc);
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
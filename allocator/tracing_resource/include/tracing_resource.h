@@ -0,0 +1,175 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_TRACING_RESOURCE_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_TRACING_RESOURCE_H
+
+#include <pp_allocator.h>
+#include <logger_guardant.h>
+#include <typename_holder.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <forward_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** Decorator for any memory_resource that records every allocation and deallocation going through it.
+ *  Each thread appends to its own chunked buffer, so recording takes no lock and never touches
+ *  the wrapped resource. save() writes the events of all threads ordered by time as a binary log,
+ *  which allocation_trace::load turns into a trace for mp_os_allctr_bench to replay.
+ *  In hardened builds the resource sees blocks with their canaries, so the events describe those.
+ */
+class tracing_resource final:
+    public smart_mem_resource,
+    private logger_guardant,
+    private typename_holder
+{
+
+public:
+
+    enum class event_kind : uint8_t
+    {
+        allocation,
+        deallocation
+    };
+
+    struct event
+    {
+        // Since the resource was created
+        uint64_t timestamp_ns;
+        // Block as the caller sees it, the same block is freed with the same address
+        uint64_t address;
+        // Clamped to UINT32_MAX, 0 for deallocations
+        uint32_t size;
+        // Thread numbers are handed out in the order threads first use the resource
+        uint32_t thread;
+        event_kind kind;
+        uint8_t alignment_log2;
+        // Keeps the saved log free of uninitialized bytes
+        std::array<uint8_t, 6> reserved{};
+    };
+
+    static_assert(sizeof(event) == 32);
+
+    // Log is this magic followed by the raw events
+    static constexpr const std::array<char, 8> log_magic{ 'M', 'P', 'T', 'R', 'A', 'C', 'E', '2' };
+
+private:
+
+    static constexpr const size_t chunk_capacity = 4096;
+
+    // Only the owning thread writes, count is published after the event so readers never see a half written one
+    struct chunk
+    {
+        std::array<event, chunk_capacity> events;
+        std::atomic<size_t> count{ 0 };
+        std::atomic<chunk *> next{ nullptr };
+    };
+
+    struct thread_buffer
+    {
+        uint32_t thread;
+        chunk *head;
+        chunk *tail;
+    };
+
+    // Size of the header in front of every block, blocks with bigger alignment get as much as their alignment
+    static constexpr const size_t header_size = alignof(std::max_align_t);
+
+    struct block_header
+    {
+        size_t size;
+        size_t alignment;
+    };
+
+    static_assert(sizeof(block_header) <= header_size);
+
+    class buffer_registry;
+
+    std::pmr::memory_resource *_inner;
+
+    logger *_logger;
+
+    uint64_t _id;
+
+    std::chrono::steady_clock::time_point _start;
+
+    // Guards only the list of buffers, taken once per thread
+    mutable std::mutex _buffers_lock;
+
+    std::forward_list<std::unique_ptr<thread_buffer>> _buffers;
+
+    size_t _threads_count;
+
+    static std::atomic<uint64_t> _next_id;
+
+    static thread_local buffer_registry _registry;
+
+public:
+
+    explicit tracing_resource(
+        std::pmr::memory_resource *inner = nullptr,
+        logger *logger = nullptr);
+
+    tracing_resource(
+        tracing_resource const &other) = delete;
+
+    tracing_resource &operator=(
+        tracing_resource const &other) = delete;
+
+    tracing_resource(
+        tracing_resource &&other) noexcept = delete;
+
+    tracing_resource &operator=(
+        tracing_resource &&other) noexcept = delete;
+
+    ~tracing_resource() override;
+
+public:
+
+    [[nodiscard]] void *do_allocate_sm(
+        size_t size) override;
+
+    void do_deallocate_sm(
+        void *at) override;
+
+    [[nodiscard]] void *do_allocate_aligned_sm(
+        size_t size,
+        size_t alignment) override;
+
+    void do_deallocate_aligned_sm(
+        void *at,
+        size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    // Events of all threads recorded so far, ordered by time. Safe to call while other threads keep recording
+    std::vector<event> events() const;
+
+    // Throws std::runtime_error when the file can't be written
+    void save(
+        std::string const &path) const;
+
+    // Throws std::runtime_error for a file that can't be read or is not a log
+    static std::vector<event> load(
+        std::string const &path);
+
+private:
+
+    void record(
+        event_kind kind,
+        void *at,
+        size_t size,
+        size_t alignment);
+
+    thread_buffer *local_buffer();
+
+    void release(
+        void *at);
+
+    inline logger *get_logger() const override;
+
+    inline std::string get_typename() const override;
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_ALLOCATOR_TRACING_RESOURCE_H
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include "../include/tracing_resource.h"
+
+std::atomic<uint64_t> tracing_resource::_next_id = 1;
+
+namespace
+{
+    // Ids of resources that are still alive, threads drop the entries of the others from their registry
+    std::mutex &live_lock()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+
+    std::unordered_set<uint64_t> &live_ids()
+    {
+        static std::unordered_set<uint64_t> ids;
+        return ids;
+    }
+}
+
+// Buffers of the calling thread by resource id, ids are never reused so entries of destroyed resources are never hit
+class tracing_resource::buffer_registry final
+{
+
+public:
+
+    std::unordered_map<uint64_t, thread_buffer *> entries;
+
+    uint64_t last_id = 0;
+
+    thread_buffer *last_buffer = nullptr;
+
+};
+
+thread_local tracing_resource::buffer_registry tracing_resource::_registry;
+
+tracing_resource::tracing_resource(
+    std::pmr::memory_resource *inner,
+    logger *logger) :
+        _inner(inner == nullptr ? std::pmr::get_default_resource() : inner),
+        _logger(logger),
+        _id(_next_id.fetch_add(1, std::memory_order_relaxed)),
+        _start(std::chrono::steady_clock::now()),
+        _threads_count(0)
+{
+    std::lock_guard lock(live_lock());
+    live_ids().insert(_id);
+}
+
+tracing_resource::~tracing_resource()
+{
+    {
+        std::lock_guard lock(live_lock());
+        live_ids().erase(_id);
+    }
+
+    for (auto &buffer : _buffers)
+    {
+        for (chunk *current = buffer->head; current != nullptr;)
+        {
+            chunk *next = current->next.load(std::memory_order_relaxed);
+            delete current;
+            current = next;
+        }
+    }
+}
+
+[[nodiscard]] void *tracing_resource::do_allocate_sm(
+    size_t size)
+{
+    return do_allocate_aligned_sm(size, header_size);
+}
+
+void tracing_resource::do_deallocate_sm(
+    void *at)
+{
+    if (at == nullptr)
+        return;
+
+    record(event_kind::deallocation, at, 0, 0);
+    release(at);
+}
+
+/** Header sits right before the block, the raw block of the wrapped resource starts
+ *  max(alignment, header_size) bytes earlier so the block keeps the requested alignment.
+ */
+[[nodiscard]] void *tracing_resource::do_allocate_aligned_sm(
+    size_t size,
+    size_t alignment)
+{
+    size_t offset = std::max(alignment, header_size);
+    if (size > std::numeric_limits<size_t>::max() - offset)
+        throw std::bad_alloc();
+
+    auto raw = reinterpret_cast<unsigned char *>(_inner->allocate(offset + size, offset));
+    if (raw == nullptr)
+        throw std::bad_alloc();
+
+    void *at = raw + offset;
+    auto header = reinterpret_cast<block_header *>(at) - 1;
+    header->size = size;
+    header->alignment = offset;
+
+    try
+    {
+        record(event_kind::allocation, at, size, alignment);
+    }
+    catch (std::bad_alloc const &)
+    {
+        release(at);
+        throw;
+    }
+
+    return at;
+}
+
+void tracing_resource::do_deallocate_aligned_sm(
+    void *at,
+    size_t /* alignment */)
+{
+    do_deallocate_sm(at);
+}
+
+bool tracing_resource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+std::vector<tracing_resource::event> tracing_resource::events() const
+{
+    std::vector<event> out;
+
+    {
+        std::lock_guard lock(_buffers_lock);
+
+        for (auto const &buffer : _buffers)
+        {
+            for (chunk const *current = buffer->head; current != nullptr; current = current->next.load(std::memory_order_acquire))
+            {
+                size_t count = current->count.load(std::memory_order_acquire);
+                out.insert(out.end(), current->events.begin(), current->events.begin() + count);
+            }
+        }
+    }
+
+    // Events of one thread are already in order, stable sort keeps it for equal timestamps
+    std::stable_sort(out.begin(), out.end(), [](event const &left, event const &right)
+    {
+        return left.timestamp_ns < right.timestamp_ns;
+    });
+
+    return out;
+}
+
+void tracing_resource::save(
+    std::string const &path) const
+{
+    std::vector<event> recorded = events();
+
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(log_magic.data(), log_magic.size());
+    stream.write(reinterpret_cast<char const *>(recorded.data()), static_cast<std::streamsize>(recorded.size() * sizeof(event)));
+
+    if (!stream)
+    {
+        throw std::runtime_error("Can't write trace log " + path);
+    }
+}
+
+std::vector<tracing_resource::event> tracing_resource::load(
+    std::string const &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    std::array<char, log_magic.size()> magic{};
+
+    if (!stream.read(magic.data(), magic.size()) || magic != log_magic)
+    {
+        throw std::runtime_error(path + " is not a trace log");
+    }
+
+    std::vector<event> out;
+    event current;
+    while (stream.read(reinterpret_cast<char *>(&current), sizeof(event)))
+    {
+        out.push_back(current);
+    }
+
+    if (stream.gcount() != 0)
+    {
+        throw std::runtime_error(path + " ends with a truncated event");
+    }
+
+    return out;
+}
+
+void tracing_resource::record(
+    event_kind kind,
+    void *at,
+    size_t size,
+    size_t alignment)
+{
+    thread_buffer *buffer = local_buffer();
+    chunk *tail = buffer->tail;
+    size_t count = tail->count.load(std::memory_order_relaxed);
+
+    if (count == chunk_capacity)
+    {
+        auto fresh = new chunk();
+        tail->next.store(fresh, std::memory_order_release);
+        buffer->tail = tail = fresh;
+        count = 0;
+    }
+
+    tail->events[count] = event
+        {
+            .timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count()),
+            .address = reinterpret_cast<uint64_t>(at),
+            .size = static_cast<uint32_t>(std::min<size_t>(size, UINT32_MAX)),
+            .thread = buffer->thread,
+            .kind = kind,
+            .alignment_log2 = static_cast<uint8_t>(alignment == 0 ? 0 : std::countr_zero(alignment))
+        };
+    tail->count.store(count + 1, std::memory_order_release);
+}
+
+tracing_resource::thread_buffer *tracing_resource::local_buffer()
+{
+    if (_registry.last_id == _id)
+        return _registry.last_buffer;
+
+    auto found = _registry.entries.find(_id);
+    if (found == _registry.entries.end())
+    {
+        // Entries of destroyed resources are dropped whenever one is added, so they don't pile up in long-lived threads
+        {
+            std::lock_guard lock(live_lock());
+            std::erase_if(_registry.entries, [](auto const &e) { return !live_ids().contains(e.first); });
+        }
+
+        thread_buffer *buffer;
+        {
+            std::lock_guard lock(_buffers_lock);
+            buffer = _buffers.emplace_front(std::make_unique<thread_buffer>()).get();
+            buffer->thread = static_cast<uint32_t>(_threads_count++);
+            buffer->head = buffer->tail = new chunk();
+        }
+
+        found = _registry.entries.emplace(_id, buffer).first;
+
+        debug_with_guard([&] { return "[TRACING] Thread " + std::to_string(buffer->thread) + " started recording"; });
+    }
+
+    _registry.last_id = _id;
+    _registry.last_buffer = found->second;
+
+    return _registry.last_buffer;
+}
+
+void tracing_resource::release(
+    void *at)
+{
+    auto header = reinterpret_cast<block_header *>(at) - 1;
+
+    _inner->deallocate(reinterpret_cast<unsigned char *>(at) - header->alignment, header->alignment + header->size, header->alignment);
+}
+
+inline logger *tracing_resource::get_logger() const
+{
+    return _logger;
+}
+
+inline std::string tracing_resource::get_typename() const
+{
+    return "tracing_resource";
+}
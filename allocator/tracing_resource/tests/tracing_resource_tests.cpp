@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+#include <tracing_resource.h>
+#include <allocator_sorted_list.h>
+#include <client_logger_builder.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <vector>
+
+logger *create_logger(
+    std::vector<std::pair<std::string, logger::severity>> const &output_file_streams_setup,
+    bool use_console_stream = true,
+    logger::severity console_stream_severity = logger::severity::debug)
+{
+    std::unique_ptr<logger_builder> logger_builder_instance(new client_logger_builder);
+
+    if (use_console_stream)
+    {
+        logger_builder_instance->add_console_stream(console_stream_severity);
+    }
+
+    for (auto &output_file_stream_setup: output_file_streams_setup)
+    {
+        logger_builder_instance->add_file_stream(output_file_stream_setup.first, output_file_stream_setup.second);
+    }
+
+    logger *logger_instance = logger_builder_instance->build();
+
+    return logger_instance;
+}
+
+TEST(tracingResourceTests, test1)
+{
+    std::unique_ptr<logger> logger_instance(create_logger(std::vector<std::pair<std::string, logger::severity>>
+        {
+            {
+                "tracing_resource_tests_test1.txt",
+                logger::severity::debug
+            }
+        }, false));
+
+    allocator_sorted_list inner(1 << 14);
+
+    {
+        tracing_resource subject(&inner, logger_instance.get());
+
+        void *first = subject.allocate(100);
+        void *second = subject.allocate(7);
+        memset(first, 'a', 100);
+        subject.deallocate(first, 100);
+        void *aligned = subject.allocate(300, 64);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+        subject.deallocate(aligned, 300, 64);
+
+        auto events = subject.events();
+        ASSERT_EQ(events.size(), 5);
+
+        // The trace sees the blocks of the wrapped allocator, canaries of hardened builds included,
+        // an aligned block has a whole alignment step in front of it to hold its header
+        size_t const header = smart_mem_resource::hardened_header_size;
+        size_t const aligned_front = smart_mem_resource::hardened ? 64 : 0;
+
+        ASSERT_EQ(events[0].kind, tracing_resource::event_kind::allocation);
+        ASSERT_EQ(events[0].address, reinterpret_cast<uint64_t>(first) - header);
+        ASSERT_EQ(events[0].size, 100 + smart_mem_resource::hardened_overhead);
+        ASSERT_EQ(events[1].address, reinterpret_cast<uint64_t>(second) - header);
+        ASSERT_EQ(events[1].size, 7 + smart_mem_resource::hardened_overhead);
+        ASSERT_EQ(events[2].kind, tracing_resource::event_kind::deallocation);
+        ASSERT_EQ(events[2].address, reinterpret_cast<uint64_t>(first) - header);
+        ASSERT_EQ(events[2].size, 0);
+        ASSERT_EQ(events[3].size, 300 + aligned_front + smart_mem_resource::hardened_tail_size);
+        ASSERT_EQ(events[3].alignment_log2, 6);
+        ASSERT_EQ(events[4].address, reinterpret_cast<uint64_t>(aligned) - aligned_front);
+
+        for (size_t i = 0; i < events.size(); ++i)
+        {
+            ASSERT_EQ(events[i].thread, 0);
+            if (i > 0)
+            {
+                ASSERT_GE(events[i].timestamp_ns, events[i - 1].timestamp_ns);
+            }
+        }
+
+        subject.deallocate(second, 7);
+    }
+
+    // Every block went back to the wrapped allocator
+    auto blocks = inner.get_blocks_info();
+    ASSERT_EQ(blocks.size(), 1);
+    ASSERT_FALSE(blocks[0].is_block_occupied);
+}
+
+TEST(tracingResourceTests, test2)
+{
+    tracing_resource subject;
+
+    size_t const threads_count = 4, iterations = 10000;
+    std::atomic<bool> done = false;
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&]()
+        {
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                void *block = subject.allocate(1 + i % 200);
+                subject.deallocate(block, 1 + i % 200);
+            }
+        });
+    }
+
+    // Events can be collected while the threads keep recording
+    std::thread reader([&]()
+    {
+        while (!done.load())
+        {
+            auto events = subject.events();
+            ASSERT_LE(events.size(), threads_count * iterations * 2);
+        }
+    });
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    done = true;
+    reader.join();
+
+    auto events = subject.events();
+    ASSERT_EQ(events.size(), threads_count * iterations * 2);
+
+    // Every thread frees its block right after allocating it, whatever the other threads do in between
+    std::vector<size_t> per_thread(threads_count, 0);
+    std::vector<uint64_t> last_allocated(threads_count, 0);
+    for (auto const &e : events)
+    {
+        ASSERT_LT(e.thread, threads_count);
+        if (per_thread[e.thread]++ % 2 == 0)
+        {
+            ASSERT_EQ(e.kind, tracing_resource::event_kind::allocation);
+            last_allocated[e.thread] = e.address;
+        }
+        else
+        {
+            ASSERT_EQ(e.kind, tracing_resource::event_kind::deallocation);
+            ASSERT_EQ(e.address, last_allocated[e.thread]);
+        }
+    }
+
+    for (size_t count : per_thread)
+    {
+        ASSERT_EQ(count, iterations * 2);
+    }
+}
+
+TEST(tracingResourceTests, saveAndLoad)
+{
+    tracing_resource subject;
+    std::vector<void *> blocks;
+
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        blocks.push_back(subject.allocate(16 + i % 100));
+    }
+    for (void *block : blocks)
+    {
+        subject.deallocate(block, 1);
+    }
+
+    subject.save("tracing_resource_tests_save_and_load.log");
+    auto loaded = tracing_resource::load("tracing_resource_tests_save_and_load.log");
+    std::remove("tracing_resource_tests_save_and_load.log");
+
+    auto events = subject.events();
+    ASSERT_EQ(loaded.size(), events.size());
+    ASSERT_EQ(memcmp(loaded.data(), events.data(), events.size() * sizeof(tracing_resource::event)), 0);
+}
+
+TEST(tracingResourceNegativeTests, test1)
+{
+    allocator_sorted_list inner(1024);
+    tracing_resource subject(&inner);
+
+    // Failed allocation leaves no event behind
+    ASSERT_THROW(static_cast<void>(subject.allocate(4096)), std::bad_alloc);
+    ASSERT_TRUE(subject.events().empty());
+
+    // Header would wrap the size around
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max() - 8)), std::bad_alloc);
+    ASSERT_THROW(static_cast<void>(subject.allocate(std::numeric_limits<size_t>::max() - 8, 64)), std::bad_alloc);
+    ASSERT_TRUE(subject.events().empty());
+
+    ASSERT_THROW(tracing_resource::load("tracing_resource_tests_missing.log"), std::runtime_error);
+
+    std::ofstream("tracing_resource_tests_bad.log") << "a 0 100\n";
+    ASSERT_THROW(tracing_resource::load("tracing_resource_tests_bad.log"), std::runtime_error);
+
+    std::ofstream("tracing_resource_tests_bad.log", std::ios::binary) << "MPTRACE2" << "short";
+    ASSERT_THROW(tracing_resource::load("tracing_resource_tests_bad.log"), std::runtime_error);
+    std::remove("tracing_resource_tests_bad.log");
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -8,6 +8,7 @@
 #include <not_implemented.h>
 #include <pp_allocator.h>
 
+#include <bit>
 #include <vector>
 #include <utility>
 #include <iostream>
@@ -27,19 +28,7 @@ namespace __detail {
 	}
 
 	constexpr size_t nearest_greater_power_of_2(size_t size) noexcept {
-		int ones_counter = 0, index = -1;
-
-		constexpr const size_t o = 1;
-
-		for (int i = sizeof(size_t) * 8 - 1; i >= 0; --i) {
-			if (size & (o << i)) {
-				if (ones_counter == 0)
-					index = i;
-				++ones_counter;
-			}
-		}
-
-		return ones_counter <= 1 ? (1u << index) : (1u << (index + 1));
+		return std::bit_ceil(size);
 	}
 }// namespace __detail
 
@@ -0,0 +1,93 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_BIT_UTILS_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_BIT_UTILS_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace __detail
+{
+    // Smallest k with 2^k >= size, 0 for 0 and 1
+    constexpr size_t ceil_log2(size_t size) noexcept
+    {
+        return size <= 1 ? 0 : std::bit_width(size - 1);
+    }
+
+    // Largest k with 2^k <= size, 0 for 0
+    constexpr size_t floor_log2(size_t size) noexcept
+    {
+        return size == 0 ? 0 : std::bit_width(size) - 1;
+    }
+
+    // alignment has to be a power of 2
+    constexpr size_t round_up(size_t size, size_t alignment) noexcept
+    {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    /** Size class of a request in one table load instead of a search over Classes, which go up strictly.
+     *  Requests are bucketed by Granule, so every class has to be a multiple of it.
+     *  Anything above the largest class maps to Classes.size(), the usual index of the "large" class.
+     */
+    template<size_t Granule, auto Classes>
+    class size_class_table final
+    {
+
+    public:
+
+        static constexpr const size_t count = Classes.size();
+
+        static_assert(std::has_single_bit(Granule) && count > 0 && count <= std::numeric_limits<uint8_t>::max());
+
+    private:
+
+        static constexpr const size_t buckets_count = Classes.back() / Granule + 1;
+
+        static constexpr std::array<uint8_t, buckets_count> build() noexcept
+        {
+            std::array<uint8_t, buckets_count> lookup{};
+
+            size_t size_class = 0;
+            for (size_t bucket = 0; bucket < buckets_count; ++bucket)
+            {
+                while (Classes[size_class] < bucket * Granule)
+                    ++size_class;
+
+                lookup[bucket] = static_cast<uint8_t>(size_class);
+            }
+
+            return lookup;
+        }
+
+        static constexpr bool valid() noexcept
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (Classes[i] % Granule != 0 || (i > 0 && Classes[i] <= Classes[i - 1]))
+                    return false;
+            }
+
+            return true;
+        }
+
+        static_assert(valid(), "Size classes have to go up strictly and be multiples of the granule");
+
+        static constexpr const std::array<uint8_t, buckets_count> _lookup = build();
+
+    public:
+
+        static constexpr size_t of(size_t size) noexcept
+        {
+            // Checked before rounding, which would wrap for sizes near SIZE_MAX
+            if (size > Classes.back())
+                return count;
+
+            return _lookup[(size + Granule - 1) / Granule];
+        }
+
+    };
+}
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_BIT_UTILS_H
@@ -0,0 +1,163 @@
+#include <client_logger.h>
+#include <client_logger_builder.h>
+#include <log_format.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+    std::string const format = "[%d %t][%s] %m";
+
+    std::string const message = "allocated 128 bytes at 0x7f3a1c002a40, 12 blocks in use";
+
+    std::string legacy_put_time(
+        char const *pattern)
+    {
+        auto time = std::time(nullptr);
+
+        std::ostringstream result_stream;
+        result_stream << std::put_time(std::localtime(&time), pattern);
+
+        return result_stream.str();
+    }
+
+    // What client_logger::make_format did before log_format: a parse and a fresh ostringstream per record
+    std::string legacy_make_format(
+        std::string const &text,
+        std::string const &severity)
+    {
+        std::ostringstream oss;
+        for (auto elem = format.begin(), end = format.end(); elem != end; ++elem)
+        {
+            if (*elem != '%')
+            {
+                oss << *elem;
+                continue;
+            }
+
+            switch (*++elem)
+            {
+                case 'd':
+                    oss << legacy_put_time("%d.%m.%Y");
+                    break;
+                case 't':
+                    oss << legacy_put_time("%H:%M:%S");
+                    break;
+                case 's':
+                    oss << severity;
+                    break;
+                case 'm':
+                    oss << text;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        return oss.str();
+    }
+
+    // Sum of the record lengths is printed, so the compiler can not drop the loop
+    void measure(
+        std::string const &name,
+        size_t messages_count,
+        std::function<size_t()> const &record,
+        std::function<void()> const &finish = {})
+    {
+        size_t sum = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < messages_count; ++i)
+        {
+            sum += record();
+        }
+        if (finish)
+        {
+            finish();
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::left << std::setw(24) << name
+                  << std::right << std::setw(16) << std::fixed << std::setprecision(0) << static_cast<double>(messages_count) / elapsed
+                  << std::setw(16) << sum << std::endl;
+    }
+
+    std::unique_ptr<logger> file_logger(
+        std::string const &path,
+        bool async)
+    {
+        client_logger_builder builder;
+        builder.add_file_stream(path, logger::severity::information).set_format(format);
+        if (async)
+        {
+            builder.set_async(1 << 14);
+        }
+
+        return std::unique_ptr<logger>(builder.build());
+    }
+
+}
+
+int main(
+    int argc,
+    char **argv)
+{
+    size_t messages_count = 1000000;
+    if (argc > 1)
+    {
+        try
+        {
+            messages_count = std::max<size_t>(std::stoull(argv[1]), 1);
+        }
+        catch (std::logic_error const &)
+        {
+            std::cerr << "Usage: " << argv[0] << " [messages]" << std::endl;
+            return 1;
+        }
+    }
+
+    auto path = (std::filesystem::temp_directory_path() / "mp_os_lggr_bench.txt").string();
+
+    std::cout << std::left << std::setw(24) << "case"
+              << std::right << std::setw(16) << "messages/s" << std::setw(16) << "checksum" << '\n';
+
+    measure("format legacy", messages_count, []
+    {
+        return legacy_make_format(message, "INFORMATION").size();
+    });
+
+    log_format compiled(format);
+    measure("format compiled", messages_count, [&]
+    {
+        return compiled.render_local(message, logger::severity::information).size();
+    });
+
+    for (bool async : { false, true })
+    {
+        auto log = file_logger(path, async);
+
+        // Records still in the queue of the async logger are part of the cost
+        measure(async ? "file async" : "file sync", messages_count, [&]
+        {
+            log->information(message);
+            return message.size();
+        }, [&]
+        {
+            dynamic_cast<client_logger &>(*log).flush();
+        });
+    }
+
+    std::filesystem::remove(path);
+
+    return 0;
+}
@@ -2,27 +2,89 @@
 #define MATH_PRACTICE_AND_OPERATING_SYSTEMS_CLIENT_LOGGER_H
 
 #include <logger.h>
+#include <log_format.h>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <unordered_map>
 #include <forward_list>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
 
 class client_logger_builder;
 
 class client_logger final:
     public logger
 {
+public:
+
+    // What log does with a record when the queue of an async logger is full
+    enum class overflow_policy
+    { BLOCK, DROP, DROP_LOWER_SEVERITY };
+
+    struct async_options
+    {
+        // Rounded up to a power of 2
+        size_t capacity;
+
+        overflow_policy policy;
+
+        // DROP_LOWER_SEVERITY drops records below it and blocks for the rest
+        logger::severity blocking_severity;
+    };
+
+    // When written records are pushed out of the user-space buffers. Critical records and destruction always flush
+    struct flush_policy
+    {
+        // After every record
+        bool always = false;
+
+        // After records of this severity and above
+        logger::severity min_severity = logger::severity::error;
+
+        // After a record coming this long after the last flush, 0 turns it off
+        std::chrono::milliseconds interval{ 1000 };
+
+        // After this many bytes since the last flush, 0 turns it off
+        size_t bytes = 0;
+
+        bool is_due(
+            logger::severity severity,
+            size_t unflushed_bytes,
+            std::chrono::steady_clock::duration since_flush) const noexcept;
+    };
+
 private:
     //region refcounted_stream
 
     class refcounted_stream final
     {
-        // <path: str, <n_ref, stream>> 
-        static std::unordered_map<std::string, std::pair<size_t, std::ofstream>> _global_streams;
+        struct shared_file
+        {
+            size_t refs;
+            // Set before the file is opened, so records are written out in large chunks
+            std::unique_ptr<char[]> buffer;
+            std::ofstream stream;
+            // Held while one record goes into the buffer or the file is flushed, loggers on other files never wait for it
+            std::mutex lock;
+        };
+
+        static constexpr size_t buffer_size = 1 << 16;
+
+        // <path: str, shared_file>, nodes stay where they are, so shared_file pointers outlive rehashing
+        static std::unordered_map<std::string, shared_file> _global_streams;
+
+        // Guards _global_streams and the reference counts, taken only when streams are opened, copied or closed
+        static std::mutex _global_streams_lock;
         
-        std::pair<std::string, std::ofstream*> _stream;
+        std::pair<std::string, shared_file*> _stream;
         friend client_logger;
         friend client_logger_builder;
+
+        void release() noexcept;
+
     public:
 
         explicit refcounted_stream(const std::string& path);
@@ -38,30 +100,54 @@ private:
         //if ofstream* is nullptr initializes it with opened file from global map
         void open();
 
+        // Appends text and a line break as one piece, whichever thread or logger writes the same file
+        void write(const std::string& text) const;
+
+        void flush() const;
+
         ~refcounted_stream();
     };
 
     //region refcounted_stream
 
-    enum class flag
-    { DATE, TIME, SEVERITY, MESSAGE, NO_FLAG };
+    // Bounded queue of formatted records and the thread writing them out, shared by copies of the logger
+    class async_writer;
+
+    // <list<refcounted_stream>, bool - console output> for every severity, indexed by it
+    using destinations = std::array<std::pair<std::forward_list<refcounted_stream>, bool>, logger::severities_count>;
 
 private:
 
-    // <key: severtity, <list<refcounted_stream>, bool - console output>>
-    std::unordered_map<logger::severity ,std::pair<std::forward_list<refcounted_stream>, bool>> _output_streams;
+    destinations _output_streams;
+
+    // Lowest severity going anywhere, severities_count when none does
+    size_t _min_enabled;
+
+    log_format _format;
 
-    std::string _format;
+    flush_policy _flush_policy;
+
+    // Written by the calling threads since the last flush, unused by async loggers
+    std::atomic<size_t> _unflushed_bytes;
+
+    std::atomic<std::chrono::steady_clock::time_point> _last_flush;
+
+    // nullptr when records are written by the calling thread
+    std::shared_ptr<async_writer> _async;
 
 
 private:
 
-    //opens all streams
-    client_logger(const std::unordered_map<logger::severity, std::pair<std::forward_list<refcounted_stream>, bool>>& streams, std::string format);
+    //opens all streams, starts the writer thread when async is set
+    client_logger(const std::unordered_map<logger::severity, std::pair<std::forward_list<refcounted_stream>, bool>>& streams, log_format format,
+                  const flush_policy& flush, const std::optional<async_options>& async);
+
+    static void write_record(const std::pair<std::forward_list<refcounted_stream>, bool>& destination, const std::string& text);
 
-    std::string make_format(const std::string& message, severity sev) const;
+    static void flush_streams(const destinations& streams);
 
-    static flag char_to_flag(char c) noexcept;
+    // record in a buffer of the calling thread, valid until its next make_format
+    const std::string& make_format(const std::string& message, severity sev) const;
 
     friend client_logger_builder;
 public:
@@ -82,6 +168,15 @@ public:
         const std::string &message,
         logger::severity severity) & override;
 
+    bool is_enabled(
+        logger::severity severity) const noexcept override;
+
+    // Returns once every record logged before the call is in its streams and they are flushed
+    void flush();
+
+    // Records an async logger threw away because its queue was full
+    size_t dropped_count() const noexcept;
+
 };
 
 #endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_CLIENT_LOGGER_H
\ No newline at end of file
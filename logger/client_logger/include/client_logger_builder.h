@@ -4,6 +4,8 @@
 #include <logger_builder.h>
 #include <unordered_map>
 #include <forward_list>
+#include <limits>
+#include <optional>
 #include <nlohmann/json.hpp>
 #include "client_logger.h"
 
@@ -15,10 +17,23 @@ private:
     std::unordered_map<logger::severity, std::pair<std::forward_list<client_logger::refcounted_stream>, bool>> _output_streams;
     // <key: severtity, <list<refcounted_stream>, bool - console output>>
 
-    std::string _format;
+    // Parsed once here, every built logger copies the tokens
+    log_format _format;
+
+    std::optional<client_logger::async_options> _async;
+
+    client_logger::flush_policy _flush_policy;
+
+    static constexpr size_t default_async_capacity = 4096;
+    // Queue is rounded up to a power of two, which has to fit in size_t
+    static constexpr size_t max_async_capacity = (std::numeric_limits<size_t>::max() >> 1) + 1;
 
     void parse_severity(logger::severity, nlohmann::json& j);
 
+    void parse_async(nlohmann::json& j);
+
+    void parse_flush(nlohmann::json& j);
+
 public:
 
     client_logger_builder() : _format("%m"){};
@@ -56,6 +71,17 @@ public:
 
     logger_builder& clear() & override;
 
+    // Callers only format records and queue them, a writer thread of the built logger puts them into the streams
+    client_logger_builder& set_async(
+        size_t capacity,
+        client_logger::overflow_policy policy = client_logger::overflow_policy::BLOCK,
+        logger::severity blocking_severity = logger::severity::warning) &;
+
+    client_logger_builder& set_sync() &;
+
+    client_logger_builder& set_flush_policy(
+        client_logger::flush_policy const &policy) &;
+
     [[nodiscard]] logger *build() const override;
 
 };
@@ -1,69 +1,343 @@
 #include <string>
-#include <sstream>
 #include <algorithm>
 #include <utility>
+#include <atomic>
+#include <bit>
+#include <thread>
 #include "../include/client_logger.h"
 #include <not_implemented.h>
 
 
-std::unordered_map<std::string, std::pair<size_t, std::ofstream>>
+std::unordered_map<std::string, client_logger::refcounted_stream::shared_file>
 client_logger::refcounted_stream::_global_streams;
 
+std::mutex client_logger::refcounted_stream::_global_streams_lock;
+
+namespace {
+    // Keeps records of different loggers on the console from interleaving
+    std::mutex console_lock;
+}
+
+bool client_logger::flush_policy::is_due(
+        logger::severity severity,
+        size_t unflushed_bytes,
+        std::chrono::steady_clock::duration since_flush) const noexcept {
+    return always || severity >= min_severity || severity == logger::severity::critical ||
+           (bytes != 0 && unflushed_bytes >= bytes) ||
+           (interval.count() != 0 && since_flush >= interval);
+}
+
+// Bounded MPSC queue after Vyukov: every slot carries a sequence number telling producers whether it is free
+// and the writer whether it is filled, so neither side takes a lock
+class client_logger::async_writer final {
+
+    struct slot {
+        std::atomic<size_t> sequence;
+        logger::severity severity;
+        std::string text;
+    };
+
+    destinations _output_streams;
+
+    async_options _options;
+
+    flush_policy _flush_policy;
+
+    // Only touched by the writer thread
+    size_t _unflushed_bytes;
+
+    std::chrono::steady_clock::time_point _last_flush;
+
+    size_t _mask;
+
+    std::unique_ptr<slot[]> _slots;
+
+    alignas(64) std::atomic<size_t> _enqueue_pos;
+
+    // Everything before it is written, producers waiting for room wait on it
+    alignas(64) std::atomic<size_t> _dequeue_pos;
+
+    // Everything before it is flushed, flush waits on it
+    alignas(64) std::atomic<size_t> _flushed_pos;
+
+    // Highest position some flush call waits for
+    std::atomic<size_t> _flush_request;
+
+    // Bumped after every published record, the writer sleeps on it
+    alignas(64) std::atomic<size_t> _published;
+
+    std::atomic<size_t> _dropped;
+
+    std::atomic<bool> _stop;
+
+    std::thread _thread;
+
+public:
+
+    async_writer(
+            const destinations &streams,
+            const async_options &options,
+            const flush_policy &flush)
+        : _output_streams(streams), _options(options), _flush_policy(flush),
+        _unflushed_bytes(0), _last_flush(std::chrono::steady_clock::now()),
+        _mask(std::bit_ceil(std::max<size_t>(options.capacity, 2)) - 1),
+        _slots(new slot[_mask + 1]), _enqueue_pos(0), _dequeue_pos(0),
+        _flushed_pos(0), _flush_request(0), _published(0), _dropped(0), _stop(false) {
+
+        for (size_t i = 0; i <= _mask; ++i)
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+
+        _thread = std::thread(&async_writer::run, this);
+    }
+
+    async_writer(const async_writer &) = delete;
+
+    async_writer &operator=(const async_writer &) = delete;
+
+    // Nobody can log anymore, so the writer drains and flushes the whole queue before it stops
+    ~async_writer() {
+        _stop.store(true, std::memory_order_release);
+        _published.fetch_add(1, std::memory_order_release);
+        _published.notify_one();
+        _thread.join();
+    }
+
+    void push(const std::string &text, logger::severity severity) {
+        size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+
+        while (true) {
+            slot &target = _slots[pos & _mask];
+            size_t sequence = target.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<ptrdiff_t>(sequence - pos);
+
+            if (diff == 0) {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    target.severity = severity;
+                    // Slots keep their buffers, so a record is only copied
+                    target.text.assign(text);
+                    target.sequence.store(pos + 1, std::memory_order_release);
+
+                    _published.fetch_add(1, std::memory_order_release);
+                    _published.notify_one();
+                    return;
+                }
+            }
+            else if (diff < 0) {
+                // Slot still holds the record of the previous lap, so the queue is full
+                if (_options.policy == overflow_policy::DROP ||
+                        (_options.policy == overflow_policy::DROP_LOWER_SEVERITY &&
+                         severity < _options.blocking_severity)) {
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                size_t dequeued = _dequeue_pos.load(std::memory_order_acquire);
+                if (target.sequence.load(std::memory_order_acquire) == sequence)
+                    _dequeue_pos.wait(dequeued, std::memory_order_acquire);
+
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+            else
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    void flush() {
+        size_t target = _enqueue_pos.load(std::memory_order_acquire);
+
+        size_t requested = _flush_request.load(std::memory_order_relaxed);
+        while (requested < target &&
+               !_flush_request.compare_exchange_weak(requested, target, std::memory_order_release))
+            ;
+
+        _published.fetch_add(1, std::memory_order_release);
+        _published.notify_one();
+
+        for (size_t done = _flushed_pos.load(std::memory_order_acquire); done < target;
+                done = _flushed_pos.load(std::memory_order_acquire))
+            _flushed_pos.wait(done, std::memory_order_acquire);
+    }
+
+    size_t dropped_count() const noexcept {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    void run() {
+        while (true) {
+            size_t published = _published.load(std::memory_order_acquire);
+
+            if (write_batch() != 0)
+                continue;
+
+            size_t dequeued = _dequeue_pos.load(std::memory_order_relaxed);
+            bool stopping = _stop.load(std::memory_order_acquire);
+
+            if (_flushed_pos.load(std::memory_order_relaxed) != dequeued &&
+                    (stopping || _flush_request.load(std::memory_order_acquire) > _flushed_pos.load(std::memory_order_relaxed)))
+                flush_up_to(dequeued);
+
+            if (stopping && dequeued == _enqueue_pos.load(std::memory_order_acquire))
+                return;
+
+            if (_flushed_pos.load(std::memory_order_relaxed) != dequeued && _flush_policy.interval.count() != 0) {
+                // No record may come to trigger the interval, so the writer naps until it is over
+                auto deadline = _last_flush + _flush_policy.interval;
+                while (_published.load(std::memory_order_acquire) == published) {
+                    auto now = std::chrono::steady_clock::now();
+                    if (now >= deadline) {
+                        flush_up_to(dequeued);
+                        break;
+                    }
+
+                    std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                        deadline - now, std::chrono::milliseconds(1)));
+                }
+                continue;
+            }
+
+            // A record claimed but not published yet shows up with its own notification
+            _published.wait(published, std::memory_order_acquire);
+        }
+    }
+
+    // At most one lap per batch, so producers blocked on a full queue see progress between batches
+    size_t write_batch() {
+        size_t begin = _dequeue_pos.load(std::memory_order_relaxed), pos = begin;
+        auto since_flush = std::chrono::steady_clock::now() - _last_flush;
+        bool flush_due = false;
+
+        for (; pos - begin <= _mask; ++pos) {
+            slot &source = _slots[pos & _mask];
+            if (source.sequence.load(std::memory_order_acquire) != pos + 1)
+                break;
+
+            write_record(_output_streams[static_cast<size_t>(source.severity)], source.text);
+
+            _unflushed_bytes += source.text.size() + 1;
+            flush_due = flush_due || _flush_policy.is_due(source.severity, _unflushed_bytes, since_flush);
+
+            source.text.clear();
+            source.sequence.store(pos + _mask + 1, std::memory_order_release);
+        }
+
+        if (pos == begin)
+            return 0;
+
+        _dequeue_pos.store(pos, std::memory_order_release);
+        _dequeue_pos.notify_all();
+
+        if (flush_due)
+            flush_up_to(pos);
+
+        return pos - begin;
+    }
+
+    void flush_up_to(size_t pos) {
+        client_logger::flush_streams(_output_streams);
+        _unflushed_bytes = 0;
+        _last_flush = std::chrono::steady_clock::now();
+
+        _flushed_pos.store(pos, std::memory_order_release);
+        _flushed_pos.notify_all();
+    }
+
+};
+
 logger& client_logger::log(
         const std::string &text,
         logger::severity severity) & {
     
-    std::string output = make_format(text, severity);
-    auto log_streams = _output_streams.find(severity);
-    if (log_streams == _output_streams.end())
+    if (!is_enabled(severity))
+        return *this;
+
+    const std::string &output = make_format(text, severity);
+
+    if (_async != nullptr) {
+        _async->push(output, severity);
+
+        // Whatever comes after a critical record, the record is on its way to the disk already
+        if (severity == logger::severity::critical)
+            _async->flush();
+
         return *this;
+    }
+
+    write_record(_output_streams[static_cast<size_t>(severity)], output);
+
+    // Threads racing here may flush twice, which costs a syscall and loses nothing
+    size_t unflushed = _unflushed_bytes.fetch_add(output.size() + 1, std::memory_order_relaxed) + output.size() + 1;
+    auto now = std::chrono::steady_clock::now();
+    if (_flush_policy.is_due(severity, unflushed, now - _last_flush.load(std::memory_order_relaxed))) {
+        _unflushed_bytes.store(0, std::memory_order_relaxed);
+        _last_flush.store(now, std::memory_order_relaxed);
+        flush_streams(_output_streams);
+    }
+
+    return *this;
+}
+
+void client_logger::write_record(
+        const std::pair<std::forward_list<refcounted_stream>, bool> &destination,
+        const std::string &text) {
 
     // console output
-    if (log_streams->second.second)
-        std::cout << output << std::endl;
+    if (destination.second) {
+        std::lock_guard lock(console_lock);
+        std::cout << text << '\n';
+    }
 
     // file stream
-    for (auto &out_stream: log_streams->second.first) {
-        if (out_stream._stream.second != nullptr)
-            *out_stream._stream.second << output << std::endl;
+    for (auto &out_stream: destination.first)
+        out_stream.write(text);
+}
+
+void client_logger::flush_streams(
+        const destinations &streams) {
+
+    bool console = false;
+    for (auto &destination : streams) {
+        console = console || destination.second;
+        for (auto &out_stream : destination.first)
+            out_stream.flush();
     }
 
-    return *this;
+    if (console) {
+        std::lock_guard lock(console_lock);
+        std::cout.flush();
+    }
+}
+
+bool client_logger::is_enabled(
+        logger::severity severity) const noexcept {
+    auto index = static_cast<size_t>(severity);
+    if (index < _min_enabled)
+        return false;
+
+    auto &destination = _output_streams[index];
+    return destination.second || !destination.first.empty();
 }
 
-std::string client_logger::make_format(
+void client_logger::flush() {
+    if (_async != nullptr) {
+        _async->flush();
+        return;
+    }
+
+    _unflushed_bytes.store(0, std::memory_order_relaxed);
+    _last_flush.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+    flush_streams(_output_streams);
+}
+
+size_t client_logger::dropped_count() const noexcept {
+    return _async == nullptr ? 0 : _async->dropped_count();
+}
+
+const std::string &client_logger::make_format(
         const std::string &message,
         severity sev) const {
-    
-	std::ostringstream oss;
-	for (auto elem = _format.begin(), end = _format.end();
-            elem != end; ++elem) {
-
-		flag type = flag::NO_FLAG;
-		if (*elem == '%') {
-            type = char_to_flag(*(elem + 1));
-			switch (type) {
-				case flag::DATE:
-					oss << current_date_to_string();
-					break;
-				case flag::TIME:
-					oss << current_time_to_string();
-					break;
-				case flag::SEVERITY:
-					oss << severity_to_string(sev);
-					break;
-                case flag::MESSAGE:
-                    oss << message;
-					break;
-				default:
-					break;
-			}
-			++elem;  // ignore %'invalid letter'
-        }
-        else
-            oss << *elem;
-	}
-	return oss.str();
+    return _format.render_local(message, sev);
 }
 
 client_logger::client_logger(
@@ -71,89 +345,119 @@ client_logger::client_logger(
             logger::severity,
             std::pair<std::forward_list<refcounted_stream>, bool>
         > &streams,
-        std::string format
-    ): _format(std::move(format)), _output_streams(streams) {
-}
-
-client_logger::flag client_logger::char_to_flag(char c) noexcept {
-	switch (c) {
-		case 'd':
-			return flag::DATE;
-		case 't':
-			return flag::TIME;
-		case 's':
-			return flag::SEVERITY;
-		case 'm':
-			return flag::MESSAGE;
-		default:
-			return flag::NO_FLAG;
-	}
+        log_format format,
+        const flush_policy &flush,
+        const std::optional<async_options> &async
+    ): _min_enabled(logger::severities_count), _format(std::move(format)), _flush_policy(flush),
+    _unflushed_bytes(0), _last_flush(std::chrono::steady_clock::now()) {
+
+    for (auto &[severity, destination] : streams) {
+        auto index = static_cast<size_t>(severity);
+        _output_streams[index] = destination;
+
+        if (destination.second || !destination.first.empty())
+            _min_enabled = std::min(_min_enabled, index);
+    }
+
+    if (async.has_value())
+        _async = std::make_shared<async_writer>(_output_streams, *async, _flush_policy);
 }
 
 client_logger::client_logger(const client_logger &other)
         :_output_streams(other._output_streams),
-        _format(other._format) {
+        _min_enabled(other._min_enabled),
+        _format(other._format),
+        _flush_policy(other._flush_policy),
+        _unflushed_bytes(0),
+        _last_flush(std::chrono::steady_clock::now()),
+        _async(other._async) {
 }
 
 client_logger &client_logger::operator=(const client_logger &other) {
 	if (this != &other) {
+		flush();
 		_output_streams = other._output_streams;
+		_min_enabled = other._min_enabled;
 		_format = other._format;
+		_flush_policy = other._flush_policy;
+		_unflushed_bytes = 0;
+		_last_flush = std::chrono::steady_clock::now();
+		_async = other._async;
 	}
 	return *this;
 }
 
 client_logger::client_logger(client_logger &&other) noexcept
         : _output_streams(std::move(other._output_streams)),
-        _format(std::move(other._format)) {
+        _min_enabled(std::exchange(other._min_enabled, logger::severities_count)),
+        _format(std::move(other._format)),
+        _flush_policy(other._flush_policy),
+        _unflushed_bytes(other._unflushed_bytes.exchange(0)),
+        _last_flush(other._last_flush.load()),
+        _async(std::move(other._async)) {
 }
 
 client_logger &client_logger::operator=(client_logger &&other) noexcept {
 	if (this != &other) {
+		flush();
 		_output_streams = std::move(other._output_streams);
+		_min_enabled = std::exchange(other._min_enabled, logger::severities_count);
 		_format = std::move(other._format);
+		_flush_policy = other._flush_policy;
+		_unflushed_bytes = other._unflushed_bytes.exchange(0);
+		_last_flush = other._last_flush.load();
+		_async = std::move(other._async);
 	}
 	return *this;
 }
 
-client_logger::~client_logger() noexcept =default;
+// Streams shared with other loggers stay open, so what this one wrote is flushed here
+client_logger::~client_logger() noexcept {
+    if (_async == nullptr)
+        flush_streams(_output_streams);
+}
 
 client_logger::refcounted_stream::refcounted_stream(const std::string &path) {
+    std::lock_guard lock(_global_streams_lock);
+
 	auto opened_stream = _global_streams.find(path);
 
     if (opened_stream != _global_streams.end()) {
-		++opened_stream->second.first;
-		_stream = std::make_pair(path, &opened_stream->second.second);
+		++opened_stream->second.refs;
+		_stream = std::make_pair(path, &opened_stream->second);
     }
     else {
-        auto inserted_stream = _global_streams.emplace(
-            path, 
-            std::pair<size_t, std::ofstream>(1, std::ofstream(path))
-        );
-        if (!inserted_stream.second ||
-                !inserted_stream.first->second.second.is_open()) {
+        auto inserted_stream = _global_streams.try_emplace(path);
+        auto &file = inserted_stream.first->second;
+
+        file.refs = 1;
+        file.buffer = std::make_unique<char[]>(buffer_size);
+        file.stream.rdbuf()->pubsetbuf(file.buffer.get(), buffer_size);
+        file.stream.open(path);
 
-            if (inserted_stream.second)
-                _global_streams.erase(inserted_stream.first);
+        if (!file.stream.is_open()) {
+            _global_streams.erase(inserted_stream.first);
 
             throw std::ios_base::failure(
                 "File " + path + " could not be opened"
             );
         }
-        _stream = std::make_pair(path, &inserted_stream.first->second.second);
+        _stream = std::make_pair(path, &file);
     }
 }
 
 client_logger::refcounted_stream::refcounted_stream(
         const client_logger::refcounted_stream &oth) {
 
+    std::lock_guard lock(_global_streams_lock);
+
 	auto opened_stream = _global_streams.find(oth._stream.first);
 
 	if (opened_stream != _global_streams.end()) {
-		++opened_stream->second.first;
+		++opened_stream->second.refs;
 		_stream = std::make_pair(
             opened_stream->first,
-            &opened_stream->second.second
+            &opened_stream->second
         );
 	}
     else throw std::out_of_range(
@@ -165,12 +469,15 @@ client_logger::refcounted_stream::operator=(
         const client_logger::refcounted_stream &oth) {
 
     if (this != &oth){
+        release();
+
+        std::lock_guard lock(_global_streams_lock);
     	auto opened_stream = _global_streams.find(oth._stream.first);
-        ++opened_stream->second.first;
+        ++opened_stream->second.refs;
         // _stream = oth._stream;  // oth._stream.second could be nullptr;
 		_stream = std::make_pair(
             opened_stream->first,
-            &opened_stream->second.second
+            &opened_stream->second
         );
     }
     return *this;
@@ -186,19 +493,43 @@ client_logger::refcounted_stream::refcounted_stream(
 client_logger::refcounted_stream &client_logger::refcounted_stream::operator=(
         client_logger::refcounted_stream &&oth) noexcept {
     if (this != &oth){
+        release();
         _stream = std::move(oth._stream);
 		oth._stream.second = nullptr;
     }
     return *this;
 }
 
-client_logger::refcounted_stream::~refcounted_stream() {
+void client_logger::refcounted_stream::write(const std::string &text) const {
+    if (_stream.second == nullptr)
+        return;
+
+    std::lock_guard lock(_stream.second->lock);
+    _stream.second->stream << text << '\n';
+}
+
+void client_logger::refcounted_stream::flush() const {
+    if (_stream.second == nullptr)
+        return;
+
+    std::lock_guard lock(_stream.second->lock);
+    _stream.second->stream.flush();
+}
+
+void client_logger::refcounted_stream::release() noexcept {
 	if (_stream.second != nullptr) {
+        std::lock_guard lock(_global_streams_lock);
+
 		auto opened_stream = _global_streams.find(_stream.first);
-		--opened_stream->second.first;
-		if (opened_stream->second.first == 0) {
-			opened_stream->second.second.close();
+		--opened_stream->second.refs;
+		if (opened_stream->second.refs == 0) {
+			opened_stream->second.stream.close();
 			_global_streams.erase(opened_stream);
 		}
+        _stream.second = nullptr;
 	}
 }
+
+client_logger::refcounted_stream::~refcounted_stream() {
+    release();
+}
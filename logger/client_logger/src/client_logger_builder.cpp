@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cctype>
 #include <fstream>
+#include <stdexcept>
 
 
 using namespace nlohmann;
@@ -26,8 +27,9 @@ logger_builder& client_logger_builder::add_file_stream(
     }
 
     auto &list = streams->second.first;
+    // Relative path of a file that does not exist yet stays relative otherwise, and the file gets opened twice
     std::string canonical = std::filesystem::weakly_canonical(
-        stream_file_path
+        std::filesystem::absolute(stream_file_path)
     ).string();
 
     bool found = false;
@@ -93,6 +95,14 @@ logger_builder& client_logger_builder::transform_with_configuration(
                 set_format(value.get<std::string>());
             }
         }
+        if (key == "async") {
+            parse_async(value);
+            continue;
+        }
+        if (key == "flush") {
+            parse_flush(value);
+            continue;
+        }
         try {
 
             std::string upper_key = key;
@@ -119,18 +129,45 @@ logger_builder& client_logger_builder::transform_with_configuration(
 
 logger_builder& client_logger_builder::clear() & {
     _output_streams.clear();
-    _format = "%m";
+    _format = log_format("%m");
+    _async.reset();
+    _flush_policy = client_logger::flush_policy();
     return *this;
 }
 
 logger *client_logger_builder::build() const {
-    return new client_logger(_output_streams, _format);
+    return new client_logger(_output_streams, _format, _flush_policy, _async);
+}
+
+client_logger_builder& client_logger_builder::set_async(
+        size_t capacity,
+        client_logger::overflow_policy policy,
+        logger::severity blocking_severity) & {
+
+    if (capacity == 0)
+        throw std::invalid_argument("Async logger needs a queue of at least one record");
+    if (capacity > max_async_capacity)
+        throw std::invalid_argument("Async logger queue of " + std::to_string(capacity) + " records can't be rounded up to a power of two");
+
+    _async = client_logger::async_options{ capacity, policy, blocking_severity };
+    return *this;
+}
+
+client_logger_builder& client_logger_builder::set_sync() & {
+    _async.reset();
+    return *this;
+}
+
+client_logger_builder& client_logger_builder::set_flush_policy(
+        client_logger::flush_policy const &policy) & {
+    _flush_policy = policy;
+    return *this;
 }
 
 logger_builder& client_logger_builder::set_format(
         const std::string &format) & {
     // add some check?
-    _format = format;
+    _format = log_format(format);
     return *this;
 }
 
@@ -160,6 +197,86 @@ void client_logger_builder::parse_severity(
 	}
 }
 
+// "async": true | false | { "capacity": 4096, "overflow": "block" | "drop" | "drop_lower_severity", "blocking_severity": "warning" }
+void client_logger_builder::parse_async(
+        nlohmann::json& j) {
+
+    if (j.is_boolean()) {
+        if (j.get<bool>())
+            set_async(default_async_capacity);
+        else
+            set_sync();
+        return;
+    }
+
+    if (!j.is_object())
+        return;
+
+    // Negative numbers would wrap around to huge capacities
+    auto capacity_field = j.find("capacity");
+    if (capacity_field != j.end() && !capacity_field->is_number_unsigned())
+        throw std::invalid_argument("Async logger capacity must be a non-negative integer");
+
+    size_t capacity = j.value("capacity", default_async_capacity);
+
+    auto policy = client_logger::overflow_policy::BLOCK;
+    std::string overflow = j.value("overflow", std::string("block"));
+    if (overflow == "drop")
+        policy = client_logger::overflow_policy::DROP;
+    else if (overflow == "drop_lower_severity")
+        policy = client_logger::overflow_policy::DROP_LOWER_SEVERITY;
+    else if (overflow != "block")
+        throw std::invalid_argument("Unknown overflow policy '" + overflow + "'");
+
+    std::string blocking_severity = j.value("blocking_severity", std::string("warning"));
+    std::transform(
+        blocking_severity.begin(),
+        blocking_severity.end(),
+        blocking_severity.begin(),
+        [](unsigned char c) {
+            return std::toupper(c);
+        }
+    );
+
+    set_async(capacity, policy, logger_builder::string_to_severity(blocking_severity));
+}
+
+// "flush": "always" | { "severity": "error", "interval_ms": 1000, "bytes": 65536 }, missing triggers are off
+void client_logger_builder::parse_flush(
+        nlohmann::json& j) {
+
+    client_logger::flush_policy policy;
+
+    if (j.is_string()) {
+        if (j.get<std::string>() != "always")
+            throw std::invalid_argument("Unknown flush policy '" + j.get<std::string>() + "'");
+
+        policy.always = true;
+        set_flush_policy(policy);
+        return;
+    }
+
+    if (!j.is_object())
+        return;
+
+    policy.always = j.value("always", false);
+    policy.interval = std::chrono::milliseconds(j.value("interval_ms", 0));
+    policy.bytes = j.value("bytes", size_t(0));
+
+    std::string severity = j.value("severity", std::string("critical"));
+    std::transform(
+        severity.begin(),
+        severity.end(),
+        severity.begin(),
+        [](unsigned char c) {
+            return std::toupper(c);
+        }
+    );
+    policy.min_severity = logger_builder::string_to_severity(severity);
+
+    set_flush_policy(policy);
+}
+
 // Useless for client logger
 logger_builder& client_logger_builder::set_destination(
         const std::string &format) & {
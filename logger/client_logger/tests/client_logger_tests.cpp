@@ -2,7 +2,345 @@
 #include "../include/client_logger.h"
 #include "../include/client_logger_builder.h"
 
+#include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::vector<std::string> read_lines(
+        std::string const &path)
+    {
+        std::ifstream file(path);
+        std::vector<std::string> lines;
+
+        for (std::string line; std::getline(file, line);)
+        {
+            lines.push_back(line);
+        }
+
+        return lines;
+    }
+}
+
+TEST(clientLoggerAsyncTests, test1)
+{
+    size_t const threads_count = 4, records_count = 2000;
+
+    client_logger_builder builder;
+    builder.add_file_stream("async_test1.txt", logger::severity::information)
+        .set_format("%s %m");
+    builder.set_async(64);
+
+    std::unique_ptr<logger> log(builder.build());
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (size_t i = 0; i < records_count; ++i)
+            {
+                log->information(std::to_string(t) + " " + std::to_string(i));
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    // Everything logged so far is in the file without waiting for the destructor
+    dynamic_cast<client_logger &>(*log).flush();
+
+    auto lines = read_lines("async_test1.txt");
+    ASSERT_EQ(lines.size(), threads_count * records_count);
+
+    // Records of one thread keep their order
+    std::vector<size_t> next(threads_count, 0);
+    for (auto const &line : lines)
+    {
+        size_t t, i;
+        ASSERT_EQ(sscanf(line.c_str(), "INFORMATION %zu %zu", &t, &i), 2);
+        ASSERT_EQ(i, next[t]++);
+    }
+
+    ASSERT_EQ(dynamic_cast<client_logger &>(*log).dropped_count(), 0);
+}
+
+TEST(clientLoggerAsyncTests, test2)
+{
+    size_t const records_count = 20000;
+    size_t dropped;
+
+    {
+        client_logger_builder builder;
+        builder.add_file_stream("async_test2.txt", logger::severity::debug)
+            .add_file_stream("async_test2.txt", logger::severity::error);
+        builder.set_async(2, client_logger::overflow_policy::DROP_LOWER_SEVERITY, logger::severity::error);
+
+        std::unique_ptr<logger> log(builder.build());
+
+        for (size_t i = 0; i < records_count; ++i)
+        {
+            log->log(std::to_string(i), i % 10 == 0 ? logger::severity::error : logger::severity::debug);
+        }
+
+        // Destructor drains the queue
+        dropped = dynamic_cast<client_logger &>(*log).dropped_count();
+    }
+
+    auto lines = read_lines("async_test2.txt");
+    ASSERT_EQ(lines.size() + dropped, records_count);
+
+    // Records at the blocking severity are never dropped
+    size_t errors = 0;
+    for (auto const &line : lines)
+    {
+        errors += std::stoull(line) % 10 == 0;
+    }
+    ASSERT_EQ(errors, records_count / 10);
+}
+
+TEST(clientLoggerAsyncTests, test3)
+{
+    {
+        std::ofstream configuration("async_test3.json");
+        configuration << R"({ "log": { "format": "%m", "async": { "capacity": 16, "overflow": "drop" },)"
+                      << R"( "warning": { "paths": [ "async_test3.txt" ] } } })";
+    }
+
+    {
+        client_logger_builder builder;
+        builder.transform_with_configuration("async_test3.json", "log");
+
+        std::unique_ptr<logger> log(builder.build());
+        log->warning("first").warning("second");
+
+        // Copies share the writer, it stops with the last of them
+        std::unique_ptr<logger> copy(new client_logger(dynamic_cast<client_logger &>(*log)));
+        log.reset();
+        copy->warning("third");
+    }
+
+    ASSERT_EQ(read_lines("async_test3.txt"), (std::vector<std::string>{ "first", "second", "third" }));
+
+    {
+        std::ofstream configuration("async_test3.json");
+        configuration << R"({ "log": { "async": { "overflow": "sometimes" } } })";
+    }
+
+    client_logger_builder builder;
+    ASSERT_THROW(builder.transform_with_configuration("async_test3.json", "log"), std::invalid_argument);
+    ASSERT_THROW(builder.set_async(0), std::invalid_argument);
+}
+
+TEST(clientLoggerAsyncTests, test4)
+{
+    // Queue is rounded up to a power of two, so capacities past the largest one that fits are refused
+    for (auto const *capacity : { "0", "-1", "1.5", "\"16\"", "9223372036854775809", "18446744073709551615" })
+    {
+        {
+            std::ofstream configuration("async_test4.json");
+            configuration << R"({ "log": { "async": { "capacity": )" << capacity << " } } }";
+        }
+
+        client_logger_builder builder;
+        ASSERT_THROW(builder.transform_with_configuration("async_test4.json", "log"), std::invalid_argument);
+    }
+    std::filesystem::remove("async_test4.json");
+
+    client_logger_builder builder;
+    ASSERT_THROW(builder.set_async(std::numeric_limits<size_t>::max()), std::invalid_argument);
+    ASSERT_THROW(builder.set_async((size_t(1) << (std::numeric_limits<size_t>::digits - 1)) + 1), std::invalid_argument);
+    ASSERT_NO_THROW(builder.set_async(size_t(1) << (std::numeric_limits<size_t>::digits - 1)));
+}
+
+TEST(clientLoggerFlushTests, test1)
+{
+    client_logger::flush_policy policy;
+    policy.min_severity = logger::severity::critical;
+    policy.interval = std::chrono::milliseconds(0);
+
+    client_logger_builder builder;
+    builder.add_file_stream("flush_test1.txt", logger::severity::information)
+        .add_file_stream("flush_test1.txt", logger::severity::critical);
+    builder.set_flush_policy(policy);
+
+    std::unique_ptr<logger> log(builder.build());
+
+    // Records wait in the buffer of the file until something flushes it
+    log->information("first").information("second");
+    ASSERT_EQ(std::filesystem::file_size("flush_test1.txt"), 0);
+
+    log->critical("third");
+    ASSERT_EQ(read_lines("flush_test1.txt"), (std::vector<std::string>{ "first", "second", "third" }));
+
+    policy.bytes = 16;
+    builder.clear();
+    builder.add_file_stream("flush_test1.txt", logger::severity::information);
+    builder.set_flush_policy(policy);
+    log.reset(builder.build());
+
+    log->information("0123456789");
+    ASSERT_EQ(read_lines("flush_test1.txt").size(), 3);
+    log->information("0123456789");
+    ASSERT_EQ(read_lines("flush_test1.txt").size(), 5);
+
+    // Destruction flushes whatever is left
+    log->information("last");
+    log.reset();
+    ASSERT_EQ(read_lines("flush_test1.txt").back(), "last");
+}
+
+TEST(clientLoggerFlushTests, test2)
+{
+    {
+        std::ofstream configuration("flush_test2.json");
+        configuration << R"({ "log": { "format": "%m", "async": true, "flush": { "interval_ms": 20 },)"
+                      << R"( "information": { "paths": [ "flush_test2.txt" ] } } })";
+    }
+
+    client_logger_builder builder;
+    builder.transform_with_configuration("flush_test2.json", "log");
+
+    std::unique_ptr<logger> log(builder.build());
+    log->information("only");
+
+    // No further record comes, the writer flushes once the interval is over
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (read_lines("flush_test2.txt").empty() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(read_lines("flush_test2.txt"), std::vector<std::string>{ "only" });
+
+    {
+        std::ofstream configuration("flush_test2.json");
+        configuration << R"({ "log": { "flush": "sometimes" } })";
+    }
+
+    ASSERT_THROW(builder.transform_with_configuration("flush_test2.json", "log"), std::invalid_argument);
+}
+
+TEST(clientLoggerDispatchTests, test1)
+{
+    client_logger_builder builder;
+    builder.set_format("%s %m");
+    builder.add_file_stream("dispatch_test1.txt", logger::severity::debug);
+    builder.add_file_stream("dispatch_test1.txt", logger::severity::error);
+
+    std::unique_ptr<logger> log(builder.build());
+
+    // Below the lowest configured severity and between configured ones nothing is written
+    ASSERT_FALSE(log->is_enabled(logger::severity::trace));
+    ASSERT_TRUE(log->is_enabled(logger::severity::debug));
+    ASSERT_FALSE(log->is_enabled(logger::severity::information));
+    ASSERT_FALSE(log->is_enabled(logger::severity::warning));
+    ASSERT_TRUE(log->is_enabled(logger::severity::error));
+    ASSERT_FALSE(log->is_enabled(logger::severity::critical));
+
+    log->trace("t").debug("d").information("i").warning("w").error("e").critical("c");
+    log.reset();
+
+    ASSERT_EQ(read_lines("dispatch_test1.txt"), (std::vector<std::string>{ "DEBUG d", "ERROR e" }));
+
+    std::unique_ptr<logger> silent(client_logger_builder().build());
+    ASSERT_FALSE(silent->is_enabled(logger::severity::critical));
+    silent->critical("nowhere");
+}
+
+TEST(clientLoggerMultithreadedTests, test1)
+{
+    size_t const shared_threads_count = 4, own_threads_count = 4, records_count = 3000, rounds_count = 20;
+    size_t const payload_size = 100;
+
+    auto record = [&](size_t t, size_t i)
+    {
+        return std::to_string(t) + " " + std::to_string(i) + " " + std::string(payload_size, static_cast<char>('a' + t));
+    };
+
+    std::vector<std::thread> threads;
+
+    {
+        client_logger_builder builder;
+        builder.add_file_stream("mt_test1.txt", logger::severity::information);
+        std::unique_ptr<logger> shared(builder.build());
+
+        // One sync logger used by several threads at once
+        for (size_t t = 0; t < shared_threads_count; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                for (size_t i = 0; i < records_count; ++i)
+                {
+                    shared->information(record(t, i));
+                }
+            });
+        }
+
+        // Loggers of their own on the same file, opened and closed all the time, every other one async
+        for (size_t t = shared_threads_count; t < shared_threads_count + own_threads_count; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                size_t per_round = records_count / rounds_count;
+
+                for (size_t round = 0; round < rounds_count; ++round)
+                {
+                    client_logger_builder own_builder;
+                    own_builder.add_file_stream("mt_test1.txt", logger::severity::information)
+                        .add_file_stream("mt_test1_" + std::to_string(t) + ".txt", logger::severity::information);
+                    if (round % 2 == 1)
+                    {
+                        own_builder.set_async(16);
+                    }
+
+                    std::unique_ptr<logger> own(own_builder.build());
+                    std::unique_ptr<logger> copy(new client_logger(dynamic_cast<client_logger &>(*own)));
+
+                    for (size_t i = round * per_round; i < (round + 1) * per_round; ++i)
+                    {
+                        (i % 2 == 0 ? own : copy)->information(record(t, i));
+                    }
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    auto lines = read_lines("mt_test1.txt");
+    ASSERT_EQ(lines.size(), (shared_threads_count + own_threads_count) * records_count);
+
+    // No record is torn or mixed with another one, and records of one thread keep their order
+    std::vector<size_t> next(shared_threads_count + own_threads_count, 0);
+    for (auto const &line : lines)
+    {
+        size_t t, i;
+        ASSERT_EQ(sscanf(line.c_str(), "%zu %zu", &t, &i), 2);
+        ASSERT_LT(t, next.size());
+        ASSERT_EQ(line, record(t, i));
+        ASSERT_EQ(i, next[t]++);
+    }
+
+    // Nobody else keeps those files open, so every round truncates them and only the last one is left
+    for (size_t t = shared_threads_count; t < shared_threads_count + own_threads_count; ++t)
+    {
+        auto own_lines = read_lines("mt_test1_" + std::to_string(t) + ".txt");
+        ASSERT_EQ(own_lines.size(), records_count / rounds_count);
+        ASSERT_EQ(own_lines.back(), record(t, records_count - 1));
+    }
+}
 
 int main(int argc, char *argv[])
 {
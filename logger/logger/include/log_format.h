@@ -0,0 +1,63 @@
+#ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_FORMAT_H
+#define MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_FORMAT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "logger.h"
+
+/** Format string of a logger parsed once into literal runs and the %d (date), %t (time), %s (severity)
+ *  and %m (message) fields between them. A % before any other character drops both.
+ *  Rendering appends pieces to a string, and date and time are formatted once per second per thread.
+ */
+class log_format final
+{
+
+private:
+
+    enum class field
+    {
+        literal,
+        date,
+        time,
+        severity,
+        message
+    };
+
+    struct token
+    {
+        field kind;
+        // Range of a literal in _literals
+        size_t begin;
+        size_t length;
+    };
+
+    std::string _source;
+
+    std::string _literals;
+
+    std::vector<token> _tokens;
+
+public:
+
+    explicit log_format(
+        std::string format = "%m");
+
+public:
+
+    // Replaces the content of out with the record
+    void render(
+        std::string &out,
+        std::string_view message,
+        logger::severity severity) const;
+
+    // Renders into a buffer of the calling thread, which is valid until its next render_local
+    std::string const &render_local(
+        std::string_view message,
+        logger::severity severity) const;
+
+    std::string const &source() const noexcept;
+
+};
+
+#endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOG_FORMAT_H
@@ -18,6 +18,9 @@ public:
         critical
     };
 
+    // Severities go from 0 up without gaps, so they can index tables of this size
+    static constexpr size_t severities_count = static_cast<size_t>(severity::critical) + 1;
+
 public:
 
     virtual ~logger() noexcept = default;
@@ -28,6 +31,10 @@ public:
         std::string const &message,
         logger::severity severity) & = 0;
 
+    // false when a record of this severity would go nowhere, lets callers skip building it
+    virtual bool is_enabled(
+        logger::severity severity) const noexcept;
+
 public:
 
     logger& trace(
@@ -50,6 +57,8 @@ public:
 
 protected:
 
+    friend class log_format;
+
     static std::string severity_to_string(
         logger::severity severity);
 
@@ -1,6 +1,10 @@
 #ifndef MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOGGER_GUARDANT_H
 #define MATH_PRACTICE_AND_OPERATING_SYSTEMS_LOGGER_GUARDANT_H
 
+#include <concepts>
+#include <functional>
+#include <string_view>
+#include <utility>
 #include "logger.h"
 
 class logger_guardant
@@ -13,26 +17,96 @@ public:
 public:
 
     logger_guardant & log_with_guard(
-        std::string const &message,
+        std::string_view message,
         logger::severity severity) &;
 
     logger_guardant &trace_with_guard(
-        std::string const &message) &;
+        std::string_view message) &;
 
     logger_guardant &debug_with_guard(
-        std::string const &message) &;
+        std::string_view message) &;
 
     logger_guardant &information_with_guard(
-        std::string const &message) &;
+        std::string_view message) &;
 
     logger_guardant &warning_with_guard(
-        std::string const &message) &;
+        std::string_view message) &;
 
     logger_guardant &error_with_guard(
-        std::string const &message) &;
+        std::string_view message) &;
 
     logger_guardant &critical_with_guard(
-        std::string const &message) &;
+        std::string_view message) &;
+
+public:
+
+    // message_factory is called only when the record is going to be emitted, so filtered out records cost nothing
+    template<typename message_factory>
+        requires std::is_invocable_r_v<std::string, message_factory>
+    logger_guardant &log_with_guard(
+        message_factory &&make_message,
+        logger::severity severity) &
+    {
+        if (is_enabled_with_guard(severity))
+        {
+            get_logger()->log(std::invoke(std::forward<message_factory>(make_message)), severity);
+        }
+
+        return *this;
+    }
+
+    template<typename message_factory>
+        requires std::is_invocable_r_v<std::string, message_factory>
+    logger_guardant &trace_with_guard(
+        message_factory &&make_message) &
+    {
+        return log_with_guard(std::forward<message_factory>(make_message), logger::severity::trace);
+    }
+
+    template<typename message_factory>
+        requires std::is_invocable_r_v<std::string, message_factory>
+    logger_guardant &debug_with_guard(
+        message_factory &&make_message) &
+    {
+        return log_with_guard(std::forward<message_factory>(make_message), logger::severity::debug);
+    }
+
+    template<typename message_factory>
+        requires std::is_invocable_r_v<std::string, message_factory>
+    logger_guardant &information_with_guard(
+        message_factory &&make_message) &
+    {
+        return log_with_guard(std::forward<message_factory>(make_message), logger::severity::information);
+    }
+
+    template<typename message_factory>
+        requires std::is_invocable_r_v<std::string, message_factory>
+    logger_guardant &warning_with_guard(
+        message_factory &&make_message) &
+    {
+        return log_with_guard(std::forward<message_factory>(make_message), logger::severity::warning);
+    }
+
+    template<typename message_factory>
+        requires std::is_invocable_r_v<std::string, message_factory>
+    logger_guardant &error_with_guard(
+        message_factory &&make_message) &
+    {
+        return log_with_guard(std::forward<message_factory>(make_message), logger::severity::error);
+    }
+
+    template<typename message_factory>
+        requires std::is_invocable_r_v<std::string, message_factory>
+    logger_guardant &critical_with_guard(
+        message_factory &&make_message) &
+    {
+        return log_with_guard(std::forward<message_factory>(make_message), logger::severity::critical);
+    }
+
+public:
+
+    bool is_enabled_with_guard(
+        logger::severity severity) const;
 
 protected:
 
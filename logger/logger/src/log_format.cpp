@@ -0,0 +1,148 @@
+#include "../include/log_format.h"
+#include <array>
+#include <ctime>
+#include <utility>
+
+namespace
+{
+    // Date and time of the last second some record of this thread was rendered in
+    struct clock_cache
+    {
+        std::time_t second = -1;
+        char date[16] = {};
+        size_t date_length = 0;
+        char time[16] = {};
+        size_t time_length = 0;
+    };
+
+    clock_cache const &current_clock()
+    {
+        thread_local clock_cache cache;
+
+        std::time_t now = std::time(nullptr);
+        if (now != cache.second)
+        {
+            std::tm parts{};
+#ifdef _WIN32
+            localtime_s(&parts, &now);
+#else
+            localtime_r(&now, &parts);
+#endif
+            cache.date_length = std::strftime(cache.date, sizeof(cache.date), "%d.%m.%Y", &parts);
+            cache.time_length = std::strftime(cache.time, sizeof(cache.time), "%H:%M:%S", &parts);
+            cache.second = now;
+        }
+
+        return cache;
+    }
+}
+
+log_format::log_format(
+    std::string format) :
+        _source(std::move(format))
+{
+    auto add_literal = [this](char c)
+    {
+        if (_tokens.empty() || _tokens.back().kind != field::literal)
+        {
+            _tokens.push_back({ field::literal, _literals.size(), 0 });
+        }
+
+        _literals.push_back(c);
+        ++_tokens.back().length;
+    };
+
+    for (size_t i = 0; i < _source.size(); ++i)
+    {
+        if (_source[i] != '%')
+        {
+            add_literal(_source[i]);
+            continue;
+        }
+
+        if (++i == _source.size())
+        {
+            break;
+        }
+
+        switch (_source[i])
+        {
+            case 'd':
+                _tokens.push_back({ field::date, 0, 0 });
+                break;
+            case 't':
+                _tokens.push_back({ field::time, 0, 0 });
+                break;
+            case 's':
+                _tokens.push_back({ field::severity, 0, 0 });
+                break;
+            case 'm':
+                _tokens.push_back({ field::message, 0, 0 });
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void log_format::render(
+    std::string &out,
+    std::string_view message,
+    logger::severity severity) const
+{
+    static std::array<std::string, logger::severities_count> const severity_names =
+        {
+            logger::severity_to_string(logger::severity::trace),
+            logger::severity_to_string(logger::severity::debug),
+            logger::severity_to_string(logger::severity::information),
+            logger::severity_to_string(logger::severity::warning),
+            logger::severity_to_string(logger::severity::error),
+            logger::severity_to_string(logger::severity::critical)
+        };
+
+    out.clear();
+
+    for (auto const &piece : _tokens)
+    {
+        switch (piece.kind)
+        {
+            case field::literal:
+                out.append(_literals, piece.begin, piece.length);
+                break;
+            case field::date:
+            {
+                auto const &clock = current_clock();
+                out.append(clock.date, clock.date_length);
+                break;
+            }
+            case field::time:
+            {
+                auto const &clock = current_clock();
+                out.append(clock.time, clock.time_length);
+                break;
+            }
+            case field::severity:
+                out.append(severity_names[static_cast<size_t>(severity)]);
+                break;
+            case field::message:
+                out.append(message);
+                break;
+        }
+    }
+}
+
+std::string const &log_format::render_local(
+    std::string_view message,
+    logger::severity severity) const
+{
+    thread_local std::string buffer;
+
+    render(buffer, message, severity);
+
+    return buffer;
+}
+
+std::string const &log_format::source() const noexcept
+{
+    return _source;
+}
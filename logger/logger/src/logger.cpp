@@ -2,6 +2,12 @@
 #include <iomanip>
 #include <sstream>
 
+bool logger::is_enabled(
+    logger::severity /* severity */) const noexcept
+{
+    return true;
+}
+
 logger & logger::trace(
     std::string const &message) &
 {
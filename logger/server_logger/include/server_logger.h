@@ -2,6 +2,8 @@
 #define MATH_PRACTICE_AND_OPERATING_SYSTEMS_SERVER_LOGGER_H
 
 #include <logger.h>
+#include <log_format.h>
+#include <array>
 #include <unordered_map>
 #include <httplib.h>
 
@@ -11,11 +13,12 @@ class server_logger final:
     public logger
 {
     static const std::string _separator;
-	std::string _format;
+	log_format _format;
     httplib::Client _client;
-	std::unordered_map<logger::severity, std::pair<std::string, bool>> _streams;
-    enum class flag
-    { DATE, TIME, SEVERITY, MESSAGE, NO_FLAG };
+	// <paths, bool - console output> for every severity, indexed by it
+	std::array<std::pair<std::string, bool>, logger::severities_count> _streams;
+    // Lowest severity going anywhere, severities_count when none does
+    size_t _min_enabled;
 
     server_logger(
         const std::string& dest,
@@ -23,7 +26,7 @@ class server_logger final:
                 logger::severity,
                 std::pair<std::string, bool>
             >& streams,
-        std::string format);
+        log_format format);
 
     friend server_logger_builder;
 
@@ -46,9 +49,12 @@ public:
         const std::string &message,
         logger::severity severity) & override;
 
+    bool is_enabled(
+        logger::severity severity) const noexcept override;
+
 private:
-    static server_logger::flag char_to_flag(char c) noexcept;
-    std::string make_format(const std::string &message, severity sev) const;
+    // record in a buffer of the calling thread, valid until its next make_format
+    const std::string &make_format(const std::string &message, severity sev) const;
 };
 
 #endif //MATH_PRACTICE_AND_OPERATING_SYSTEMS_SERVER_LOGGER_H
\ No newline at end of file
@@ -8,7 +8,7 @@
 class server_logger_builder final:
     public logger_builder
 {
-    std::string _format;
+    log_format _format;
 
     std::string _destination;
 
@@ -1,6 +1,8 @@
 #include <not_implemented.h>
 #include <httplib.h>
+#include <algorithm>
 #include <ranges>
+#include <utility>
 #include "../include/server_logger.h"
 
 #ifdef _WIN32
@@ -21,7 +23,10 @@ logger& server_logger::log(
     const std::string &text,
     logger::severity severity) & {
 
-        httplib::Params params;
+    if (!is_enabled(severity))
+        return *this;
+
+    httplib::Params params;
     params.emplace("pid", std::to_string(server_logger::inner_getpid()));
     params.emplace("sev", severity_to_string(severity));
     params.emplace("message", make_format(text, severity));
@@ -29,60 +34,31 @@ logger& server_logger::log(
 	return *this;
 }
 
-std::string server_logger::make_format(
-        const std::string &message, severity sev
-    ) const {
+bool server_logger::is_enabled(
+    logger::severity severity) const noexcept {
 
-	std::ostringstream oss;
-	for (auto elem = _format.begin(), end = _format.end();
-            elem != end; ++elem) {
-
-		flag type = flag::NO_FLAG;
-		if (*elem == '%') {
-            ++elem;
-            type = char_to_flag(*elem);
-			switch (type) {
-				case flag::DATE:
-					oss << current_date_to_string();
-					break;
-				case flag::TIME:
-					oss << current_time_to_string();
-					break;
-				case flag::SEVERITY:
-					oss << severity_to_string(sev);
-					break;
-                case flag::MESSAGE:
-                    oss << message;
-					break;
-				default:
-					break;
-			}
-        }
-        else
-            oss << *elem;
-	}
-	return oss.str();
+    auto index = static_cast<size_t>(severity);
+    return index >= _min_enabled && (_streams[index].second || !_streams[index].first.empty());
 }
 
-server_logger::flag server_logger::char_to_flag(char c) noexcept {
-	switch (c) {
-		case 'd':
-			return flag::DATE;
-		case 't':
-			return flag::TIME;
-		case 's':
-			return flag::SEVERITY;
-		case 'm':
-			return flag::MESSAGE;
-		default:
-			return flag::NO_FLAG;
-	}
+const std::string &server_logger::make_format(
+        const std::string &message, severity sev
+    ) const {
+	return _format.render_local(message, sev);
 }
 
 server_logger::server_logger(const std::string& dest,
         const std::unordered_map<logger::severity, std::pair<std::string, bool>> &streams,
-        std::string format
-    ): _client(dest), _format(std::move(format)), _streams(streams){
+        log_format format
+    ): _client(dest), _format(std::move(format)), _min_enabled(logger::severities_count){
+
+    for (auto& [severity, destination] : streams) {
+        auto index = static_cast<size_t>(severity);
+        _streams[index] = destination;
+
+        if (destination.second || !destination.first.empty())
+            _min_enabled = std::min(_min_enabled, index);
+    }
 
 	std::string pid = std::to_string(inner_getpid());
 	auto res = _client.Get("/destroy?pid=" + pid);
@@ -112,14 +88,17 @@ int server_logger::inner_getpid()
 
 server_logger::server_logger(const server_logger &other)
         :_client(other._client.host(), other._client.port()),
-        _format(other._format), _streams(other._streams) {
+        _format(other._format), _streams(other._streams), _min_enabled(other._min_enabled) {
     
-    for (auto& pair : _streams) {
+    for (size_t i = 0; i < _streams.size(); ++i) {
+        auto& [paths, console] = _streams[i];
+        if (paths.empty() && !console)
+            continue;
+
         httplib::Params par;
         par.emplace("pid", std::to_string(server_logger::inner_getpid()));
-        par.emplace("sev", severity_to_string(pair.first));
+        par.emplace("sev", severity_to_string(static_cast<logger::severity>(i)));
 
-        std::string paths = pair.second.first;
         for (auto token : paths | std::views::split(_separator)) {
             if (!std::string(std::string_view(token)).empty())
                 par.emplace(
@@ -128,7 +107,7 @@ server_logger::server_logger(const server_logger &other)
                 );
         }
         
-        par.emplace("console", pair.second.second ? "1" : "0");
+        par.emplace("console", console ? "1" : "0");
 
         auto res = _client.Get("/init", par, httplib::Headers());
     }
@@ -139,35 +118,38 @@ server_logger &server_logger::operator=(const server_logger &other) {
         _client = httplib::Client(other._client.host(), other._client.port());
         _format = other._format; 
         _streams = other._streams;
+        _min_enabled = other._min_enabled;
 
-        for (auto& pair : _streams) {
-        httplib::Params par;
-        par.emplace("pid", std::to_string(server_logger::inner_getpid()));
-        par.emplace("sev", severity_to_string(pair.first));
+        for (size_t i = 0; i < _streams.size(); ++i) {
+            auto& [paths, console] = _streams[i];
+            if (paths.empty() && !console)
+                continue;
 
-        std::string paths = pair.second.first;
-        for (auto token : paths | std::views::split(_separator)) {
-            if (!std::string(std::string_view(token)).empty())
-                par.emplace(
-                    "paths",
-                    std::string(std::string_view(token))
-                );
-        }
-        
-        par.emplace("console", pair.second.second ? "1" : "0");
+            httplib::Params par;
+            par.emplace("pid", std::to_string(server_logger::inner_getpid()));
+            par.emplace("sev", severity_to_string(static_cast<logger::severity>(i)));
 
-        auto res = _client.Get("/init", par, httplib::Headers());
-    }
+            for (auto token : paths | std::views::split(_separator)) {
+                if (!std::string(std::string_view(token)).empty())
+                    par.emplace(
+                        "paths",
+                        std::string(std::string_view(token))
+                    );
+            }
 
-	}
+            par.emplace("console", console ? "1" : "0");
+
+            auto res = _client.Get("/init", par, httplib::Headers());
+        }
+    }
     return *this;
 }
 
 server_logger::server_logger(server_logger &&other) noexcept
         :_client(std::move(other._client)), _format(std::move(other._format)),
-        _streams(std::move(other._streams)) {
+        _streams(std::move(other._streams)), _min_enabled(std::exchange(other._min_enabled, logger::severities_count)) {
 
-    other._streams = std::unordered_map<logger::severity, std::pair<std::string, bool>>();
+    other._streams = {};
     other._client = httplib::Client("http://127.0.0.1:9200");
 }
 
@@ -176,8 +158,9 @@ server_logger &server_logger::operator=(server_logger &&other) noexcept{
     _client = std::move(other._client);
     _format = std::move(other._format);
     _streams = std::move(other._streams);
+    _min_enabled = std::exchange(other._min_enabled, logger::severities_count);
 
-    other._streams = std::unordered_map<logger::severity, std::pair<std::string, bool>>();
+    other._streams = {};
     other._client = httplib::Client("http://127.0.0.1:9200");
 
     return *this;
@@ -139,6 +139,6 @@ logger_builder& server_logger_builder::set_destination(
 
 logger_builder& server_logger_builder::set_format(
         const std::string &format) & {
-    _format = format;
+    _format = log_format(format);
     return *this;
 }